@@ -11,56 +11,70 @@
 #define NMEA_FLOAT_T float
 #include "INA.h"
 
-#include "Wire.h"
-
-INA::INA() {
+INA_Core::INA_Core() {
 }
 
-bool INA::begin() {
-    common_init();  // Set everything to common state, then...
-    gpsI2C = &Wire;
-    gpsI2C->begin();
-    _i2caddr = GPS_DEFAULT_I2C_ADDR;
-    // A basic scanner, see if it ACK's
-    gpsI2C->beginTransmission(_i2caddr);
-    bool rc = (gpsI2C->endTransmission() == 0);
-    sendCommand(PMTK_SET_NMEA_OUTPUT_RMCGGA);
-    sendCommand(PMTK_SET_NMEA_UPDATE_1HZ);
-    sendCommand(PGCMD_ANTENNA);
-    return rc;
+/**************************************************************************/
+/*!
+    @brief Keep reading and parsing until the GPS completes an epoch that
+    wasn't taken yet, so every value belongs to the same second. Partway
+    through an epoch, e.g. after its GGA but before its RMC, it goes on
+    waiting rather than handing back the previous one. While the background
+    reader runs it owns the transport and the producing end of the sentence
+    queue, so this only waits on the queue and never polls.
+    @param f The record to fill
+    @return True if f holds a new epoch, false if none was completed within
+    INA_FIX_TIMEOUT ms
+*/
+/**************************************************************************/
+bool INA_Core::waitFix(nmea_fix_t &f) {
+    uint32_t start = millis();
+    for (;;) {
+        // parse everything that arrived so no sentence of the epoch is skipped
+        while (newNMEAreceived()) {
+            if (streamDecode)
+                lastNMEA();  // already decoded as it arrived
+            else
+                parse(lastNMEA());
+        }
+        if (getFix(f))
+            return true;
+
+        uint32_t waited = millis() - start;
+        if (waited >= INA_FIX_TIMEOUT)
+            return false;
+        if (!readerRunning())
+            poll();
+        else if (nextNMEA(lastline, MAXLINELENGTH, INA_FIX_TIMEOUT - waited))
+            parse(lastline);
+    }
 }
 
-bool INA::getData(char *ts, float &lat, float &lon, float &alt, float &sog, float &cog, unsigned int &sat, bool &fx, float &hdopp) {
-    // char c = 0;
-    do {
-        read();
-        // c = read();
-        // if (c) Serial.print(c);
-    } while (!newNMEAreceived());
-
-    if (!parse(lastNMEA())) return false;
-
-    sprintf(ts, "20%02d-%02d-%02dT%02d:%02d:%02d.%03dZ", year, month, day, hour, minute, seconds, milliseconds);
-    fx = fix;
-    hdopp = HDOP;
-
-    if (fix) {
-        lat = latitudeDegrees;
-        lon = longitudeDegrees;
-        alt = altitude;
-        sog = speed;
-        cog = angle;
-        sat = satellites;
+bool INA_Core::getData(char *ts, float &lat, float &lon, float &alt, float &sog, float &cog, unsigned int &sat, bool &fx, float &hdopp) {
+    nmea_fix_t f;
+    if (!waitFix(f)) return false;
+
+    nmea::isoTime(nmea::epochMillis(f), ts, &isoDate);
+    fx = f.fix;
+    hdopp = f.HDOP;
+
+    if (f.fix) {
+        lat = f.latitude_fixed / 10000000.0;
+        lon = f.longitude_fixed / 10000000.0;
+        alt = f.altitude_fixed / 10.0;
+        sog = f.speed_fixed / 1000.0;
+        cog = f.angle_fixed / 100.0;
+        sat = f.satellites;
     }
 
     return true;  // Return true for successful read (add error handling if needed)
 }
 
-bool INA::getJSON(JsonDocument &doc) {
+bool INA_Core::getJSON(JsonDocument &doc) {
     unsigned int sat;
     float lat, lon, alt, sog, cog, hdopp;
     bool fx;
-    char ts[25];
+    char ts[NMEA_ISO_TIME_SIZE];
     if (!getData(&ts[0], lat, lon, alt, sog, cog, sat, fx, hdopp)) {
         return false;
     }
@@ -72,7 +86,7 @@ bool INA::getJSON(JsonDocument &doc) {
     dataSet["value"] = String(ts);
     dataSet["unit"] = "ISO 8601";
 
-    if (fix) {
+    if (fx) {
         // Comply with Kibana
         dataSet = dataArray.add<JsonObject>();  // Subsequent data sets
         dataSet["name"] = "location";
@@ -114,45 +128,26 @@ bool INA::getJSON(JsonDocument &doc) {
 
 static bool strStartsWith(const char *str, const char *prefix);
 
-/**************************************************************************/
-/*!
-    @brief Constructor when using SoftwareSerial
-    @param ser Pointer to SoftwareSerial device
-*/
-/**************************************************************************/
-#if (defined(__AVR__) || defined(ESP8266)) && defined(USE_SW_SERIAL)
-INA::INA(SoftwareSerial *ser) {
-    common_init();      // Set everything to common state, then...
-    gpsSwSerial = ser;  // ...override gpsSwSerial with value passed.
-}
-#endif
 
 /**************************************************************************/
 /*!
     @brief Initialization code used by all constructor types
 */
 /**************************************************************************/
-void INA::common_init(void) {
-    gpsHwSerial = NULL;  // port pointer in corresponding constructor
-    gpsStream = NULL;    // port pointer in corresponding constructor
-    gpsI2C = NULL;
-    gpsSPI = NULL;
-    recvdflag = false;
+void INA_Core::common_init(void) {
     paused = false;
     lineidx = 0;
-    currentline = line1;
-    lastline = line2;
+    lastline[0] = 0;
+    sentences.drain();
 
     hour = minute = seconds = year = month = day = fixquality = fixquality_3d =
         satellites = antenna = 0;  // uint8_t
     lat = lon = mag = 0;           // char
     fix = false;                   // bool
     milliseconds = 0;              // uint16_t
+    epochDay = 0;                  // uint32_t
     latitude = longitude = geoidheight = altitude = speed = angle = magvariation =
         HDOP = VDOP = PDOP = 0.0;  // nmea_float_t
-#ifdef NMEA_EXTENSIONS
-    data_init();
-#endif
 }
 
 /**************************************************************************/
@@ -161,174 +156,58 @@ void INA::common_init(void) {
     @return   none
 */
 /**************************************************************************/
-INA::~INA() {
+INA_Core::~INA_Core() {
+#ifdef INA_READER_TASK
+    stopReader();
+#endif
 #ifdef NMEA_EXTENSIONS
-    for (int i = 0; i < (int)NMEA_MAX_INDEX; i++)
+    for (int i = 0; i < (int)NMEA_MAX_INDEX; i++) {
         removeHistory((nmea_index_t)i);  // to free any history mallocs
-#endif
-}
-
-/**************************************************************************/
-/*!
-    @brief How many bytes are available to read - part of 'Print'-class
-   functionality
-    @return Bytes available, 0 if none
-*/
-/**************************************************************************/
-size_t INA::available(void) {
-    if (paused)
-        return 0;
-
-#if (defined(__AVR__) || defined(ESP8266)) && defined(USE_SW_SERIAL)
-    if (gpsSwSerial) {
-        return gpsSwSerial->available();
+        removeStats((nmea_index_t)i);
     }
 #endif
-    if (gpsHwSerial) {
-        return gpsHwSerial->available();
-    }
-    if (gpsStream) {
-        return gpsStream->available();
-    }
-    if (gpsI2C || gpsSPI) {
-        return 1;  // I2C/SPI doesnt have 'availability' so always has a byte at
-                   // least to read!
-    }
-    return 0;
 }
 
 /**************************************************************************/
 /*!
-    @brief Write a byte to the underlying transport - part of 'Print'-class
-   functionality
-    @param c A single byte to send
-    @return Bytes written - 1 on success, 0 on failure
+    @brief Decode sentences a character at a time as read() and poll()
+    receive them, instead of all at once in parse() after the line has
+    ended. The checksum and field table are kept up to date with every
+    byte, and the sentence is parsed as soon as its checksum arrives, which
+    spreads the work evenly and gets a fix to the application sooner.
+    Lines are still queued for lastNMEA(), but should not be parse()d again.
+    The results are the same as parse() gives for the same sentences.
+
+    Not available while the background reader is running, as the handlers
+    would then update the variables from the reader task.
+    @param on True to decode while receiving, false to leave it to parse()
+    @return True if the mode was set
 */
 /**************************************************************************/
-size_t INA::write(uint8_t c) {
-#if (defined(__AVR__) || defined(ESP8266)) && defined(USE_SW_SERIAL)
-    if (gpsSwSerial) {
-        return gpsSwSerial->write(c);
-    }
+bool INA_Core::setStreamDecode(bool on) {
+#ifdef INA_READER_TASK
+    if (on && readerRun)
+        return false;
 #endif
-    if (gpsHwSerial) {
-        return gpsHwSerial->write(c);
-    }
-    if (gpsStream) {
-        return gpsStream->write(c);
-    }
-    if (gpsI2C) {
-        gpsI2C->beginTransmission(_i2caddr);
-        if (gpsI2C->write(c) != 1) {
-            return 0;
-        }
-        if (gpsI2C->endTransmission(true) == 0) {
-            return 1;
-        }
-    }
-    if (gpsSPI) {
-        gpsSPI->beginTransaction(gpsSPI_settings);
-        if (gpsSPI_cs >= 0) {
-            digitalWrite(gpsSPI_cs, LOW);
-        }
-        c = gpsSPI->transfer(c);
-        if (gpsSPI_cs >= 0) {
-            digitalWrite(gpsSPI_cs, HIGH);
-        }
-        gpsSPI->endTransaction();
-        return 1;
-    }
-
-    return 0;
+    streamDecode = on;
+    streamOK = false;  // start on the next line
+    return true;
 }
 
 /**************************************************************************/
 /*!
-    @brief Read one character from the GPS device.
-
-    Call very frequently and multiple times per opportunity or the buffer
-    may overflow if there are frequent NMEA sentences. An 82 character NMEA
-    sentence 10 times per second will require 820 calls per second, and
-    once a loop() may not be enough. Check for newNMEAreceived() after at
-    least every 10 calls, or you may miss some short sentences.
-    @return The character that we received, or 0 if nothing was available
+    @brief Add one received character to the line being assembled, and push
+    the line into the sentence queue, with the millis() of its first
+    character and of its end, when it completes a sentence.
+    @param c The character received
+    @param t millis() when the character was received
+    @return True if the character completed a sentence
 */
 /**************************************************************************/
-char INA::read(void) {
-    static uint32_t firstChar = 0;  // first character received in current sentence
-    uint32_t tStart = millis();     // as close as we can get to time char was sent
-    char c = 0;
-
-    if (paused || noComms)
-        return c;
-
-#if (defined(__AVR__) || defined(ESP8266)) && defined(USE_SW_SERIAL)
-    if (gpsSwSerial) {
-        if (!gpsSwSerial->available())
-            return c;
-        c = gpsSwSerial->read();
-    }
-#endif
-    if (gpsHwSerial) {
-        if (!gpsHwSerial->available())
-            return c;
-        c = gpsHwSerial->read();
-    }
-    if (gpsStream) {
-        if (!gpsStream->available())
-            return c;
-        c = gpsStream->read();
-    }
-    if (gpsI2C) {
-        if (_buff_idx <= _buff_max) {
-            c = _i2cbuffer[_buff_idx];
-            _buff_idx++;
-        } else {
-            // refill the buffer!
-            if (gpsI2C->requestFrom((uint8_t)0x10, (uint8_t)GPS_MAX_I2C_TRANSFER,
-                                    (uint8_t) true) == GPS_MAX_I2C_TRANSFER) {
-                // got data!
-                _buff_max = 0;
-                char curr_char = 0;
-                for (int i = 0; i < GPS_MAX_I2C_TRANSFER; i++) {
-                    curr_char = gpsI2C->read();
-                    if ((curr_char == 0x0A) && (last_char != 0x0D)) {
-                        // skip duplicate 0x0A's - but keep as part of a CRLF
-                        continue;
-                    }
-                    last_char = curr_char;
-                    _i2cbuffer[_buff_max] = curr_char;
-                    _buff_max++;
-                }
-                _buff_max--;  // back up to the last valid slot
-                if ((_buff_max == 0) && (_i2cbuffer[0] == 0x0A)) {
-                    _buff_max = -1;  // ahh there was nothing to read after all
-                }
-                _buff_idx = 0;
-            }
-            return c;
-        }
-    }
-
-    if (gpsSPI) {
-        do {
-            gpsSPI->beginTransaction(gpsSPI_settings);
-            if (gpsSPI_cs >= 0) {
-                digitalWrite(gpsSPI_cs, LOW);
-            }
-            c = gpsSPI->transfer(0xFF);
-            if (gpsSPI_cs >= 0) {
-                digitalWrite(gpsSPI_cs, HIGH);
-            }
-            gpsSPI->endTransaction();
-            // skip duplicate 0x0A's - but keep as part of a CRLF
-        } while (((c == 0x0A) && (last_char != 0x0D)) ||
-                 (!isprint(c) && !isspace(c)));
-        last_char = c;
-    }
-    // Serial.print(c);
-
+bool INA_Core::lineChar(char c, uint32_t t) {
     currentline[lineidx] = c;
+    if (streamDecode)
+        streamChar(c, lineidx, t);
     lineidx = lineidx + 1;
     if (lineidx >= MAXLINELENGTH)
         lineidx = MAXLINELENGTH -
@@ -337,47 +216,108 @@ char INA::read(void) {
     if (c == '\n') {
         currentline[lineidx] = 0;
 
-        if (currentline == line1) {
-            currentline = line2;
-            lastline = line1;
-        } else {
-            currentline = line1;
-            lastline = line2;
-        }
-
         // Serial.println("----");
-        // Serial.println((char *)lastline);
+        // Serial.println(currentline);
         // Serial.println("----");
+        sentences.push(currentline, firstChar, millis());
         lineidx = 0;
-        recvdflag = true;
-        recvdTime = millis();  // time we got the end of the string
-        sentTime = firstChar;
         firstChar = 0;  // there are no characters yet
-        return c;       // wait until next character to set time
+        return true;    // wait until next character to set time
     }
 
     if (firstChar == 0)
-        firstChar = tStart;
-    return c;
+        firstChar = t;
+    return false;
+}
+
+#ifdef INA_READER_TASK
+/**************************************************************************/
+/*!
+    @brief Start a background reader that calls poll() every interval ms on
+    its own core and queues every complete sentence, so sentences are not
+    lost while loop() is busy. Collect them with nextNMEA() or lastNMEA(),
+    or let getData(), getJSON() and the other getters wait for them. While
+    the reader runs, don't call read() or poll() from the sketch.
+    On a Linux host the reader is a std::thread and core is ignored.
+    @param core The ESP32 core to pin the reader task to
+    @param interval ms to sleep between polls
+    @return True if the reader is running, false if it could not be started
+    or setStreamDecode() is on
+*/
+/**************************************************************************/
+bool INA_Core::startReader(int8_t core, uint16_t interval) {
+    if (readerRun || streamDecode)
+        return false;  // already running, or would parse from the task
+    readerInterval = interval;
+    readerRun = true;
+#if defined(ARDUINO_ARCH_ESP32)
+    TaskHandle_t task = NULL;
+    if (xTaskCreatePinnedToCore(readerLoop, "INA reader", 4096, this, 1,
+                                &task, core) != pdPASS) {
+        readerRun = false;
+        return false;
+    }
+    readerTask = task;  // the task only clears it after stopReader()
+#else
+    (void)core;
+    readerThread = std::thread(readerLoop, this);
+#endif
+    return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Stop the background reader and wait for it to finish. Sentences
+    already queued can still be collected with nextNMEA() or lastNMEA().
+*/
+/**************************************************************************/
+void INA_Core::stopReader(void) {
+    if (!readerRun)
+        return;
+    readerRun = false;
+#if defined(ARDUINO_ARCH_ESP32)
+    while (readerTask != NULL)
+        delay(1);
+#else
+    if (readerThread.joinable())
+        readerThread.join();
+#endif
 }
 
 /**************************************************************************/
 /*!
-    @brief Send a command to the GPS device
-    @param str Pointer to a string holding the command to send
+    @brief Whether the background reader is polling the GPS, so nothing
+    else may touch the transport or push to the sentence queue
+    @return True while startReader() is in effect
+*/
+/**************************************************************************/
+bool INA_Core::readerRunning(void) { return readerRun; }
+
+/**************************************************************************/
+/*!
+    @brief Body of the background reader task or thread
+    @param gps Pointer to the INA object to poll
 */
 /**************************************************************************/
-void INA::sendCommand(const char *str) {
-    Serial.println(str);
-    Wire.beginTransmission(0x10);
-    for (int i = 0; str[i] != 0; i++) {
-        Wire.write(str[i]);
+void INA_Core::readerLoop(void *gps) {
+    INA_Core *ina = (INA_Core *)gps;
+    while (ina->readerRun) {
+        ina->poll();
+#if defined(ARDUINO_ARCH_ESP32)
+        vTaskDelay(pdMS_TO_TICKS(ina->readerInterval) + 1);
+#else
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(ina->readerInterval + 1));
+#endif
     }
-    // Wire.write(str);
-    Wire.write(0x0D);
-    Wire.write(0x0A);
-    Wire.endTransmission();
+#if defined(ARDUINO_ARCH_ESP32)
+    ina->readerTask = NULL;
+    vTaskDelete(NULL);
+#endif
 }
+#else
+bool INA_Core::readerRunning(void) { return false; }
+#endif  // INA_READER_TASK
 
 /**************************************************************************/
 /*!
@@ -385,7 +325,7 @@ void INA::sendCommand(const char *str) {
     @return True if received, false if not
 */
 /**************************************************************************/
-bool INA::newNMEAreceived(void) { return recvdflag; }
+bool INA_Core::newNMEAreceived(void) { return sentences.count() > 0; }
 
 /**************************************************************************/
 /*!
@@ -393,43 +333,118 @@ bool INA::newNMEAreceived(void) { return recvdflag; }
     @param p True = pause, false = unpause
 */
 /**************************************************************************/
-void INA::pause(bool p) { paused = p; }
+void INA_Core::pause(bool p) { paused = p; }
+
+/**************************************************************************/
+/*!
+    @brief Returns the oldest NMEA line received and removes it from the
+    queue. If nothing new has arrived the previous line is returned again.
+    The times of its first and last character become the ones used by
+    parse().
+    @return Pointer to the line string
+*/
+/**************************************************************************/
+char *INA_Core::lastNMEA(void) {
+    popNMEA(lastline, MAXLINELENGTH);
+    return lastline;
+}
 
 /**************************************************************************/
 /*!
-    @brief Returns the last NMEA line received and unsets the received flag
-    @return Pointer to the last line string
+    @brief Take the oldest NMEA line from the queue into a buffer of your
+    own. Lines come out in the order they were received, and the times of
+    their first and last character become the ones used by parse().
+    @param buff Pointer to the buffer to copy the line into
+    @param len Size of the buffer, MAXLINELENGTH holds any line
+    @param sent Pointer to fill with millis() of the first character, if
+    not NULL
+    @param recvd Pointer to fill with millis() of the last character, if
+    not NULL
+    @return True if a line was copied, false if the queue was empty
 */
 /**************************************************************************/
-char *INA::lastNMEA(void) {
-    recvdflag = false;
-    return (char *)lastline;
+bool INA_Core::popNMEA(char *buff, size_t len, uint32_t *sent, uint32_t *recvd) {
+    if (!sentences.pop(buff, len, &sentTime, &recvdTime))
+        return false;
+    if (sent != NULL)
+        *sent = sentTime;
+    if (recvd != NULL)
+        *recvd = recvdTime;
+    return true;
 }
 
+/**************************************************************************/
+/*!
+    @brief Like popNMEA(), but waits for a line to arrive. Only useful while
+    the background reader or an interrupt is filling the queue.
+    @param buff Pointer to the buffer to copy the line into
+    @param len Size of the buffer, MAXLINELENGTH holds any line
+    @param timeout ms to wait for a line, 0 to return at once
+    @return True if a line was copied, false if none arrived in time
+*/
+/**************************************************************************/
+bool INA_Core::nextNMEA(char *buff, size_t len, uint32_t timeout) {
+    uint32_t start = millis();
+    while (!popNMEA(buff, len)) {
+        if (millis() - start >= timeout)
+            return false;
+        delay(1);
+    }
+    return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Number of NMEA lines received but not yet taken from the queue
+    @return Count of lines, 0 to NMEA_QUEUE_DEPTH
+*/
+/**************************************************************************/
+uint8_t INA_Core::pendingNMEA(void) { return sentences.count(); }
+
+/**************************************************************************/
+/*!
+    @brief Number of NMEA lines lost because the queue was full when they
+    arrived. If this grows, take lines more often or raise NMEA_QUEUE_DEPTH.
+    @return Count of lost lines since construction
+*/
+/**************************************************************************/
+uint32_t INA_Core::lostNMEA(void) { return sentences.overflows(); }
+
 /**************************************************************************/
 /*!
     @brief Wait for a specified sentence from the device
     @param wait4me Pointer to a string holding the desired response
     @param max How long to wait, default is MAXWAITSENTENCE
     @param usingInterrupts True if using interrupts to read from the GPS
-   (default is false)
-    @return True if we got what we wanted, false otherwise
+   (default is false). Taken as true while the background reader runs, and
+   then the wait sleeps in nextNMEA() rather than spinning on the queue.
+    @return True if we got what we wanted, false otherwise, or if max
+    sentences didn't arrive within INA_FIX_TIMEOUT ms
 */
 /**************************************************************************/
-bool INA::waitForSentence(const char *wait4me, uint8_t max,
+bool INA_Core::waitForSentence(const char *wait4me, uint8_t max,
                           bool usingInterrupts) {
+    uint32_t start = millis();
     uint8_t i = 0;
     while (i < max) {
-        if (!usingInterrupts)
+        uint32_t waited = millis() - start;
+        if (waited >= INA_FIX_TIMEOUT)
+            return false;
+        char *nmea = lastline;
+        if (usingInterrupts || readerRunning()) {
+            // something else fills the queue, so sleep until it does
+            if (!nextNMEA(lastline, MAXLINELENGTH, INA_FIX_TIMEOUT - waited))
+                return false;
+        } else {
             read();
-
-        if (newNMEAreceived()) {
-            char *nmea = lastNMEA();
-            i++;
-
-            if (strStartsWith(nmea, wait4me))
-                return true;
+            if (!newNMEAreceived())
+                continue;
+            nmea = lastNMEA();
         }
+        i++;
+
+        if (strStartsWith(nmea, wait4me))
+            return true;
     }
 
     return false;
@@ -441,9 +456,9 @@ bool INA::waitForSentence(const char *wait4me, uint8_t max,
     @return True on success, false if it failed
 */
 /**************************************************************************/
-bool INA::LOCUS_StartLogger(void) {
+bool INA_Core::LOCUS_StartLogger(void) {
     sendCommand(PMTK_LOCUS_STARTLOG);
-    recvdflag = false;
+    sentences.drain();
     return waitForSentence(PMTK_LOCUS_STARTSTOPACK);
 }
 
@@ -453,9 +468,9 @@ bool INA::LOCUS_StartLogger(void) {
     @return True on success, false if it failed
 */
 /**************************************************************************/
-bool INA::LOCUS_StopLogger(void) {
+bool INA_Core::LOCUS_StopLogger(void) {
     sendCommand(PMTK_LOCUS_STOPLOG);
-    recvdflag = false;
+    sentences.drain();
     return waitForSentence(PMTK_LOCUS_STARTSTOPACK);
 }
 
@@ -465,7 +480,7 @@ bool INA::LOCUS_StopLogger(void) {
     @return True if we read the data, false if there was no response
 */
 /**************************************************************************/
-bool INA::LOCUS_ReadStatus(void) {
+bool INA_Core::LOCUS_ReadStatus(void) {
     sendCommand(PMTK_LOCUS_QUERY_STATUS);
 
     if (!waitForSentence("$PMTKLOG"))
@@ -517,7 +532,7 @@ bool INA::LOCUS_ReadStatus(void) {
     @return False if already in standby, true if it entered standby
 */
 /**************************************************************************/
-bool INA::standby(void) {
+bool INA_Core::standby(void) {
     if (inStandbyMode) {
         return false;  // Returns false if already in standby mode, so that you do
                        // not wake it up by sending commands to GPS
@@ -536,7 +551,7 @@ bool INA::standby(void) {
     @return True if woken up, false if not in standby or failed to wake
 */
 /**************************************************************************/
-bool INA::wakeup(void) {
+bool INA_Core::wakeup(void) {
     if (inStandbyMode) {
         inStandbyMode = false;
         sendCommand("");  // send byte to wake it up
@@ -555,7 +570,7 @@ bool INA::wakeup(void) {
     @return nmea_float_t value in seconds since last fix.
 */
 /**************************************************************************/
-nmea_float_t INA::secondsSinceFix() {
+nmea_float_t INA_Core::secondsSinceFix() {
     return (millis() - lastFix) / 1000.;
 }
 
@@ -567,7 +582,7 @@ nmea_float_t INA::secondsSinceFix() {
     @return nmea_float_t value in seconds since last GPS time.
 */
 /**************************************************************************/
-nmea_float_t INA::secondsSinceTime() {
+nmea_float_t INA_Core::secondsSinceTime() {
     return (millis() - lastTime) / 1000.;
 }
 
@@ -579,17 +594,41 @@ nmea_float_t INA::secondsSinceTime() {
     @return nmea_float_t value in seconds since last GPS date.
 */
 /**************************************************************************/
-nmea_float_t INA::secondsSinceDate() {
+nmea_float_t INA_Core::secondsSinceDate() {
     return (millis() - lastDate) / 1000.;
 }
 
+/**************************************************************************/
+/*!
+    @brief The last UTC time and date the GPS sent, as one number, for
+    consumers that have no use for it as text
+    @return Milliseconds since 1970-01-01, or since midnight if no date has
+    been received yet
+*/
+/**************************************************************************/
+uint64_t INA_Core::epochMillis(void) {
+    uint32_t ms = ((hour * 60 + minute) * 60 + seconds) * 1000UL + milliseconds;
+    return (uint64_t)epochDay * 86400000ULL + ms;
+}
+
+/**************************************************************************/
+/*!
+    @brief The last UTC time and date the GPS sent, in ISO 8601
+    @param buff Where to write it, at least NMEA_ISO_TIME_SIZE bytes
+    @return Length of the text
+*/
+/**************************************************************************/
+size_t INA_Core::isoTime(char *buff) {
+    return nmea::isoTime(epochMillis(), buff, &isoDate);
+}
+
 /**************************************************************************/
 /*!
     @brief Fakes time of receipt of a sentence. Use between build() and parse()
     to make the timing look like the sentence arrived from the GPS.
 */
 /**************************************************************************/
-void INA::resetSentTime() { sentTime = millis(); }
+void INA_Core::resetSentTime() { sentTime = millis(); }
 
 /**************************************************************************/
 /*!
@@ -23,23 +23,34 @@
 // #define USE_SW_SERIAL ///< insert line `#define NO_SW_SERIAL` before this header
 //                       ///< if you don't want to include software serial in the
 // #endif                ///< library
-#define GPS_DEFAULT_I2C_ADDR \
-    0x10  ///< The default address for I2C transport of GPS data
-#define GPS_MAX_I2C_TRANSFER \
-    32  ///< The max number of bytes we'll try to read at once
-#define GPS_MAX_SPI_TRANSFER \
-    100                    ///< The max number of bytes we'll try to read at once
 #define MAXLINELENGTH 120  ///< how long are max NMEA lines to parse?
+#define INA_FIX_TIMEOUT 2000  ///< ms the getters wait for the GPS
 #define NMEA_MAX_SENTENCE_ID \
     20  ///< maximum length of a sentence ID name, including terminating 0
 #define NMEA_MAX_SOURCE_ID \
     3  ///< maximum length of a source ID name, including terminating 0
+#define INA_PACKED_VERSION \
+    1  ///< layout version of fixPacked() and fixMsgPack() records
+#define INA_PACKED_SIZE 32  ///< bytes in a fixPacked() record
 
+#include <NMEA_core.h>
 #include <NMEA_data.h>
+#include <NMEA_queue.h>
 #include <PMTK.h>
-#include <SPI.h>
 
 #include "Arduino.h"
+#include "INA_transport.h"
+
+/**************************************************************************/
+/**
+ INA_READER_TASK enables startReader(), which keeps the GPS drained from its
+ own FreeRTOS task on the ESP32, or from a std::thread on a Linux host. */
+#if defined(ARDUINO_ARCH_ESP32)
+#define INA_READER_TASK  ///< if defined, startReader() is available
+#elif defined(__linux__)
+#define INA_READER_TASK  ///< if defined, startReader() is available
+#include <thread>
+#endif
 
 /// type for resulting code from running check()
 typedef enum {
@@ -53,23 +64,92 @@ typedef enum {
     NMEA_HAS_SENTENCE_P = 40  ///< has a recognized parseable sentence ID
 } nmea_check_t;
 
-class INA {
+/// fields of getJSON() that deltaJSON() tracks, indexes of nmea_delta_t
+typedef enum {
+    NMEA_DELTA_LAT,   ///< latitude_fixed, degrees * 10000000
+    NMEA_DELTA_LON,   ///< longitude_fixed, degrees * 10000000
+    NMEA_DELTA_ALT,   ///< altitude_fixed, decimetres
+    NMEA_DELTA_SOG,   ///< speed_fixed, thousandths of a knot
+    NMEA_DELTA_COG,   ///< angle_fixed, hundredths of a degree
+    NMEA_DELTA_SAT,   ///< satellites
+    NMEA_DELTA_FIX,   ///< fix, 0 or 1
+    NMEA_DELTA_HDOP,  ///< HDOP in hundredths
+    NMEA_DELTA_FIELDS  ///< number of tracked fields
+} nmea_delta_field_t;
+
+/**************************************************************************/
+/*!
+    What one consumer of deltaJSON() was last sent, and how much each field
+    has to change before it is sent again. Keep one for each consumer, and
+    set the tolerances in the units of nmea_delta_field_t.
+*/
+/**************************************************************************/
+typedef struct {
+    int32_t tolerance[NMEA_DELTA_FIELDS] = {0};  ///< change that isn't sent
+    uint16_t keyframe = 60;  ///< send everything every this many, 0 never
+    int32_t last[NMEA_DELTA_FIELDS] = {0};  ///< values the consumer has
+    uint16_t sinceKey = 0;   ///< documents since the last keyframe
+    bool primed = false;     ///< false until a keyframe with a fix is sent
+} nmea_delta_t;
+
+/**************************************************************************/
+/*!
+    Everything about the GPS that does not depend on how it is connected:
+    line assembly, parsing, the sentence queue and the reader task. The
+    byte level access is left to INA_Receiver, which fills it in for one
+    transport at compile time.
+*/
+/**************************************************************************/
+class INA_Core {
    public:
-    INA();
-    bool begin();
+    INA_Core();
     bool getData(char *ts, float &lat, float &lon, float &alt, float &sog, float &cog, unsigned int &sat, bool &fx, float &hdop);
     bool getJSON(JsonDocument &doc);
+    size_t getJSON(char *buff, size_t len);
+    size_t getJSON(Print &out);
+    static size_t fixJSON(const nmea_fix_t &f, char *buff, size_t len);
+    static size_t fixJSON(const nmea_fix_t &f, Print &out);
+    size_t getPacked(uint8_t *buff, size_t len);
+    size_t getMsgPack(uint8_t *buff, size_t len);
+    static size_t fixPacked(const nmea_fix_t &f, uint8_t *buff, size_t len);
+    static bool unpackFix(const uint8_t *buff, size_t len, nmea_fix_t &f);
+    static size_t fixMsgPack(const nmea_fix_t &f, uint8_t *buff, size_t len);
+    static bool unpackMsgPack(const uint8_t *buff, size_t len, nmea_fix_t &f);
+    size_t getDeltaJSON(nmea_delta_t &delta, char *buff, size_t len);
+    static size_t deltaJSON(const nmea_fix_t &f, nmea_delta_t &delta,
+                            char *buff, size_t len);
+    static size_t deltaJSON(const nmea_fix_t &f, nmea_delta_t &delta,
+                            Print &out);
+    bool setBatch(char *buff, size_t len, uint16_t maxFixes = 60,
+                  size_t maxBytes = 0, uint32_t maxAge = 0);
+    bool batchFix(void);
+    bool batchFix(const nmea_fix_t &f, uint32_t now = millis());
+    bool batchReady(uint32_t now = millis());
+    const char *batchJSON(size_t *len = NULL);
+    uint16_t batchCount(void);
+    void clearBatch(void);
 
     void common_init(void);
-    virtual ~INA();
+    virtual ~INA_Core();
 
-    size_t available(void);
-    size_t write(uint8_t);
-    char read(void);
-    void sendCommand(const char *);
+    virtual size_t available(void) = 0;
+    virtual size_t write(uint8_t) = 0;
+    virtual char read(void) = 0;
+    virtual uint8_t poll(void) = 0;
+    bool setStreamDecode(bool on = true);
+#ifdef INA_READER_TASK
+    bool startReader(int8_t core = 0, uint16_t interval = GPS_L76_I2C_INTERVAL);
+    void stopReader(void);
+#endif
+    virtual void sendCommand(const char *) = 0;
     bool newNMEAreceived();
     void pause(bool b);
     char *lastNMEA(void);
+    bool popNMEA(char *buff, size_t len, uint32_t *sent = NULL,
+                 uint32_t *recvd = NULL);
+    bool nextNMEA(char *buff, size_t len, uint32_t timeout = 0);
+    uint8_t pendingNMEA(void);
+    uint32_t lostNMEA(void);
     bool waitForSentence(const char *wait, uint8_t max = MAXWAITSENTENCE,
                          bool usingInterrupts = false);
     bool LOCUS_StartLogger(void);
@@ -80,10 +160,17 @@ class INA {
     nmea_float_t secondsSinceFix();
     nmea_float_t secondsSinceTime();
     nmea_float_t secondsSinceDate();
+    uint64_t epochMillis(void);
+    size_t isoTime(char *buff);
     void resetSentTime();
 
     // NMEA_parse.cpp
     bool parse(char *);
+    bool getFix(nmea_fix_t &record);
+    uint32_t snapshot(nmea_fix_t &record, nmea_float_t *latest = NULL);
+    void setEpochFields(uint16_t required = NMEA_FIX_DEFAULT);
+    double latitudeDouble(void);
+    double longitudeDouble(void);
     bool check(char *nmea);
     bool onList(char *nmea, const char **list);
     uint8_t parseHex(char c);
@@ -100,14 +187,47 @@ class INA {
 #ifdef NMEA_EXTENSIONS
     nmea_float_t get(nmea_index_t idx);
     nmea_float_t getSmoothed(nmea_index_t idx);
-    void initDataValue(nmea_index_t idx, char *label = NULL, char *fmt = NULL,
-                       char *unit = NULL, unsigned long response = 0,
+    void copyLatest(nmea_float_t *buff);
+    void setLazySmoothing(bool on = true);
+    const nmea_datadef_t *getDataDef(nmea_index_t idx);
+    bool initDataValue(nmea_index_t idx, const char *label = NULL,
+                       const char *fmt = NULL, const char *unit = NULL,
+                       unsigned long response = 0,
                        nmea_value_type_t type = NMEA_SIMPLE_FLOAT);
     nmea_history_t *initHistory(nmea_index_t idx, nmea_float_t scale = 10.0,
                                 nmea_float_t offset = 0.0,
                                 unsigned historyInterval = 20,
                                 unsigned historyN = 192);
     void removeHistory(nmea_index_t idx);
+    bool setHistoryArena(void *buff, size_t size);
+    /**************************************************************************/
+    /*!
+        @brief Carve histories out of a static array, sized at compile time
+        @param buff The array
+        @return True if the arena was set
+    */
+    /**************************************************************************/
+    template <size_t N>
+    bool setHistoryArena(uint8_t (&buff)[N]) {
+        return setHistoryArena(buff, N);
+    }
+    size_t historyArenaUsed(void);
+    size_t historyArenaHighWater(void);
+    nmea_history_error_t historyError(void);
+    unsigned historyCount(nmea_index_t idx);
+    int16_t historyValue(nmea_index_t idx, unsigned i);
+    unsigned copyHistory(nmea_index_t idx, int16_t *buff, unsigned len);
+    bool addHistoryTier(nmea_index_t idx, uint16_t factor, unsigned n);
+    bool initStats(nmea_index_t idx, uint16_t window);
+    void removeStats(nmea_index_t idx);
+    nmea_stats_t getStats(nmea_index_t idx);
+    int8_t subscribe(nmea_index_t idx, nmea_data_callback_t callback,
+                     void *arg = NULL, nmea_float_t absBand = 0,
+                     nmea_float_t relBand = 0, uint32_t minInterval = 0);
+    void unsubscribe(int8_t id);
+    unsigned getHistory(nmea_index_t idx, uint32_t span,
+                        nmea_history_point_t *buff, unsigned len,
+                        uint32_t *interval = NULL);
     void showDataValue(nmea_index_t idx, int n = 7);
     bool isCompoundAngle(nmea_index_t idx);
 #endif
@@ -119,6 +239,9 @@ class INA {
         0};  ///< the first two letters of the current sentence, e.g. WI, GP
     char thisSentence[NMEA_MAX_SENTENCE_ID] = {
         0};  ///< the next three letters of the current sentence, e.g. GLL, RMC
+    uint32_t thisKey = 0;  ///< thisSentence packed with nmeaKey()
+    uint32_t streamParsed = 0;  ///< sentences parsed by the streaming decoder
+    uint32_t fixCount = 0;      ///< epochs published by the epoch assembler
     char lastSource[NMEA_MAX_SOURCE_ID] = {
         0};  ///< the results of the check on the most recent successfully parsed
              ///< sentence
@@ -157,6 +280,10 @@ class INA {
                                     ///< of vertical position
     nmea_float_t PDOP;              ///< Position Dilution of Precision - Complex maths derives
                                     ///< a simple, single number for each kind of DOP
+    int32_t altitude_fixed = 0;     ///< Altitude in decimetres above MSL
+    int32_t geoidheight_fixed = 0;  ///< geoidheight in decimetres
+    int32_t speed_fixed = 0;        ///< speed in thousandths of a knot
+    int32_t angle_fixed = 0;        ///< angle in hundredths of a degree
     char lat = 'X';                 ///< N/S
     char lon = 'X';                 ///< E/W
     char mag = 'X';                 ///< Magnetic variation direction
@@ -164,6 +291,7 @@ class INA {
     uint8_t fixquality;             ///< Fix quality (0, 1, 2 = Invalid, GPS, DGPS)
     uint8_t fixquality_3d;          ///< 3D fix quality (1, 3, 3 = Nofix, 2D fix, 3D fix)
     uint8_t satellites;             ///< Number of satellites in use
+    uint8_t satellitesInView = 0;   ///< Number of satellites in view (from GSV)
     uint8_t antenna;                ///< Antenna that is used (from PGTOP)
 
     uint16_t LOCUS_serial;   ///< Log serial number
@@ -179,9 +307,11 @@ class INA {
 
 #ifdef NMEA_EXTENSIONS
     // NMEA additional public variables
-    nmea_datavalue_t
-        val[NMEA_MAX_INDEX];  ///< an array of data value structs, val[0] = most
-                              ///< recent HDOP so that ockam indexing works
+    nmea_datastate_t state = {};  ///< the values of all data values, index 0
+                                  ///< is the most recent HDOP so that ockam
+                                  ///< indexing works
+    nmea_datameta_t meta[NMEA_MAX_INDEX];  ///< history and definition
+                                           ///< override of each data value
     nmea_float_t depthToKeel =
         2.4;  ///< depth from surface to bottom of keel in metres
     nmea_float_t depthToTransducer =
@@ -198,37 +328,82 @@ class INA {
     int txtN = 0;           ///< the TXT sentence number
 #endif                      // NMEA_EXTENSIONS
 
+   protected:
+    bool lineChar(char c, uint32_t t);
+    bool waitFix(nmea_fix_t &f);
+    bool readerRunning(void);
+    bool paused;          ///< true while pause() holds off reading
+    bool noComms = false;  ///< true when there is nothing to read from
+
    private:
+    // INA_json.cpp
+    char *batch = NULL;        ///< setBatch() buffer, NULL when not batching
+    size_t batchSize = 0;      ///< bytes in batch
+    size_t batchUsed = 0;      ///< bytes of the open document in batch
+    size_t batchRow = 0;       ///< bytes another row like the last needs
+    uint16_t batchN = 0;       ///< rows in batch
+    uint16_t batchMaxN = 0;    ///< rows that make batchReady(), 0 for any
+    size_t batchMaxBytes = 0;  ///< bytes that make batchReady(), 0 for any
+    uint32_t batchMaxAge = 0;  ///< ms that make batchReady(), 0 for any
+    uint32_t batchStart = 0;   ///< millis() of the first row
     // NMEA_data.cpp
-    void data_init();
+#ifdef NMEA_EXTENSIONS
+    nmea_datadef_t dataDefs[NMEA_DATA_OVERRIDES];  ///< initDataValue() changes
+    uint8_t nDataDefs = 0;                         ///< dataDefs in use
+    nmea_datadef_t userDefs[NMEA_USR_COUNT];  ///< initDataValue() changes to
+                                              ///< NMEA_USR_00 onwards
+    void updateDataValue(nmea_index_t idx, nmea_float_t v, uint32_t now);
+    void smoothDataValue(nmea_index_t idx, uint32_t now);
+    bool lazySmoothing = false;  ///< smooth each value for the time it held
+    void historyRollup(nmea_history_t *h, uint8_t t, nmea_history_point_t p);
+    void statsAdd(nmea_stats_window_t *w, nmea_float_t v);
+    void dispatch(nmea_index_t idx, nmea_float_t v, uint32_t now);
+    nmea_subscription_t subs[NMEA_MAX_SUBSCRIPTIONS];  ///< subscribe() table
+    void *historyAlloc(size_t size);
+    void historyFree(void *p);
+    uint8_t *arena = NULL;    ///< history arena, NULL to use the heap
+    size_t arenaSize = 0;     ///< bytes in the arena
+    size_t arenaUsed = 0;     ///< bytes handed out from the arena
+    size_t arenaHigh = 0;     ///< most bytes ever handed out from an arena
+    nmea_history_error_t historyErr = NMEA_HISTORY_OK;  ///< last failure
+#endif
     // NMEA_parse.cpp
     const char *tokenOnList(char *token, const char **list);
-    bool parseCoord(char *p, nmea_float_t *angleDegrees = NULL,
+    static int sentenceCheck(uint32_t key);
+    bool checkIds(char *nmea);
+    bool parseFields(void);
+    bool parseSeq(void);
+    bool streamChar(char c, uint8_t i, uint32_t t);
+    bool parseGPS(void);
+    void epochTime(void);
+    void epochSet(uint16_t bits);
+    void epochPublish(void);
+    char *field(uint8_t i);
+    bool parseCoord(char *p, char *pDir, nmea_float_t *angleDegrees = NULL,
                     nmea_float_t *angle = NULL, int32_t *angle_fixed = NULL,
                     char *dir = NULL);
     char *parseStr(char *buff, char *p, int n);
-    bool parseTime(char *);
-    bool parseFix(char *);
+    bool parseFixed(char *p, uint8_t decimals, int32_t *value);
+    nmea_float_t parseFloat(char *p);
+    int32_t parseInt(char *p);
     bool parseAntenna(char *);
     bool isEmpty(char *pStart);
 
     // used by check() for validity tests, room for future expansion
     const char *sources[7] = {"II", "WI", "GP", "PG",
                               "GN", "P", "ZZZ"};  ///< valid source ids
-#ifdef NMEA_EXTENSIONS
-    const char *sentences_parsed[21] = {"GGA", "GLL", "GSA", "RMC", "DBT", "HDM",
-                                        "HDT", "MDA", "MTW", "MWV", "RMB", "TOP",
-                                        "TXT", "VHW", "VLW", "VPW", "VWR", "WCV",
-                                        "XTE", "ZZZ"};  ///< parseable sentence ids
-    const char *sentences_known[15] = {
-        "APB", "DPT", "GSV", "HDG", "MWD", "ROT",
-        "RPM", "RSA", "VDR", "VTG", "ZDA", "ZZZ"};  ///< known, but not parseable
-#else                                               // make the lists short to save memory
-    const char *sentences_parsed[6] = {"GGA", "GLL", "GSA", "RMC",
-                                       "TOP", "ZZZ"};  ///< parseable sentence ids
-    const char *sentences_known[4] = {"DBT", "HDM", "HDT",
-                                      "ZZZ"};  ///< known, but not parseable
-#endif
+    nmea_fields_t fields;  ///< field table of the sentence last checked
+    nmea_fields_t streamFields;  ///< field table the streaming decoder builds
+    bool streamDecode = false;   ///< decode in lineChar() as bytes arrive
+    bool streamOK = false;       ///< the line being streamed is still valid
+    uint8_t streamSum = 0;       ///< running checksum of the streamed line
+    uint8_t streamAst = 0;       ///< index of the * in the streamed line
+    nmea_fix_t epochBuild;       ///< the epoch being gathered
+    nmea_fix_t epochDone;        ///< the last epoch published
+    bool epochPublished = false;  ///< epochBuild has already been published
+    uint16_t epochRequired = NMEA_FIX_DEFAULT;  ///< have bits that publish
+    uint32_t fixSeen = 0;        ///< fixCount when getFix() last looked
+    std::atomic<uint32_t> snapSeq{0};  ///< odd while a sentence is parsed
 
     // Make all of these times far in the past by setting them near the middle of
     // the millis() range. Timing assumes that sentences are parsed promptly.
@@ -237,35 +412,193 @@ class INA {
     uint32_t lastFix = 2000000000L;   ///< millis() when last fix received
     uint32_t lastTime = 2000000000L;  ///< millis() when last time received
     uint32_t lastDate = 2000000000L;  ///< millis() when last date received
+    uint32_t epochDay = 0;            ///< days from 1970-01-01 to the last date
+    nmea_iso_date_t isoDate;          ///< date part of the last isoTime()
     uint32_t recvdTime =
-        2000000000L;                  ///< millis() when last full sentence received
-    uint32_t sentTime = 2000000000L;  ///< millis() when first character of last
-                                      ///< full sentence received
-    bool paused;
+        2000000000L;                  ///< millis() when last character of the line
+                                      ///< last taken from the queue was received
+    uint32_t sentTime = 2000000000L;  ///< millis() when first character of the line
+                                      ///< last taken from the queue was received
 
     uint8_t parseResponse(char *response);
-    bool noComms = false;
-    HardwareSerial *gpsHwSerial;
-    Stream *gpsStream;
-    TwoWire *gpsI2C;
-    SPIClass *gpsSPI;
-    int8_t gpsSPI_cs = -1;
-    SPISettings gpsSPI_settings =
-        SPISettings(1000000, MSBFIRST, SPI_MODE0);  // default
-    char _spibuffer[GPS_MAX_SPI_TRANSFER];          // for when we write data, we need to
-                                                    // read it too!
-    uint8_t _i2caddr;
-    char _i2cbuffer[GPS_MAX_I2C_TRANSFER];
-    int8_t _buff_max = -1, _buff_idx = 0;
-    char last_char = 0;
-
-    volatile char line1[MAXLINELENGTH];  ///< We double buffer: read one line in
-                                         ///< and leave one for the main program
-    volatile char line2[MAXLINELENGTH];  ///< Second buffer
-    volatile uint8_t lineidx = 0;        ///< our index into filling the current line
-    volatile char *currentline;          ///< Pointer to current line buffer
-    volatile char *lastline;             ///< Pointer to previous line buffer
-    volatile bool recvdflag;             ///< Received flag
-    volatile bool inStandbyMode;         ///< In standby flag
+    uint32_t firstChar = 0;  ///< millis() of first character of current sentence
+
+    char currentline[MAXLINELENGTH];  ///< the line being read in
+    uint8_t lineidx = 0;              ///< our index into filling the current line
+    char lastline[MAXLINELENGTH];     ///< the line handed out by lastNMEA()
+    NMEA_Queue<NMEA_QUEUE_DEPTH, MAXLINELENGTH>
+        sentences;                ///< complete lines waiting for the main program
+    volatile bool inStandbyMode;  ///< In standby flag
+
+#ifdef INA_READER_TASK
+    static void readerLoop(void *gps);
+    std::atomic<bool> readerRun{false};    ///< reader task should keep going
+    uint16_t readerInterval = 0;           ///< ms the reader sleeps between polls
+#if defined(ARDUINO_ARCH_ESP32)
+    std::atomic<TaskHandle_t> readerTask{NULL};  ///< the reader task, NULL once it ends
+#else
+    std::thread readerThread;              ///< the host reader thread
+#endif
+#endif
 };
+
+/**************************************************************************/
+/*!
+    A GPS receiver on one transport, chosen at compile time. read(),
+    write(), available() and poll() call the transport directly, so there
+    is no run time test of which bus the GPS is on for every byte, and the
+    code for the other transports is never built. See INA_transport.h for
+    the transports that come with the library.
+*/
+/**************************************************************************/
+template <class Transport>
+class INA_Receiver final : public INA_Core {
+   public:
+    /**************************************************************************/
+    /*!
+        @brief Construct the receiver and its transport
+        @param args Whatever the transport constructor takes, e.g. the
+        serial port for UartTransport
+    */
+    /**************************************************************************/
+    template <typename... Args>
+    INA_Receiver(Args... args) : transport(args...) {}
+
+#ifdef INA_READER_TASK
+    /**************************************************************************/
+    /*!
+        @brief Stop the reader before the transport it polls goes away
+    */
+    /**************************************************************************/
+    ~INA_Receiver() { stopReader(); }
+#endif
+
+    /**************************************************************************/
+    /*!
+        @brief Start the transport and set the GPS up to send RMC and GGA
+        once a second
+        @return True if the GPS answered
+    */
+    /**************************************************************************/
+    bool begin() {
+        common_init();  // Set everything to common state, then...
+        bool rc = transport.begin();
+        sendCommand(PMTK_SET_NMEA_OUTPUT_RMCGGA);
+        sendCommand(PMTK_SET_NMEA_UPDATE_1HZ);
+        sendCommand(PGCMD_ANTENNA);
+        return rc;
+    }
+
+    /**************************************************************************/
+    /*!
+        @brief How many bytes are available to read - part of 'Print'-class
+       functionality
+        @return Bytes available, 0 if none
+    */
+    /**************************************************************************/
+    size_t available(void) override {
+        if (paused)
+            return 0;
+        return transport.available();
+    }
+
+    /**************************************************************************/
+    /*!
+        @brief Write a byte to the underlying transport - part of
+       'Print'-class functionality
+        @param c A single byte to send
+        @return Bytes written - 1 on success, 0 on failure
+    */
+    /**************************************************************************/
+    size_t write(uint8_t c) override { return transport.write(c); }
+
+    /**************************************************************************/
+    /*!
+        @brief Read one character from the GPS device.
+
+        Call very frequently and multiple times per opportunity or the
+        buffer may overflow if there are frequent NMEA sentences. An 82
+        character NMEA sentence 10 times per second will require 820 calls
+        per second, and once a loop() may not be enough. Complete sentences
+        are queued, so up to NMEA_QUEUE_DEPTH of them can arrive before
+        newNMEAreceived() must be checked; lostNMEA() counts any beyond
+        that.
+        @return The character that we received, or 0 if nothing was
+        available
+    */
+    /**************************************************************************/
+    char read(void) override {
+        uint32_t tStart = millis();  // as close as we can get to time char was sent
+
+        if (paused || noComms)
+            return 0;
+
+        int c = transport.read();
+        if (c < 0) {
+            transport.fill();  // refill the buffer!
+            return 0;
+        }
+        lineChar(c, tStart);
+        return c;
+    }
+
+    /**************************************************************************/
+    /*!
+        @brief Fetch everything the GPS has ready in one go. Over I2C this
+        pulls up to GPS_MAX_I2C_PACKETS packets from the receiver, stopping
+        as soon as a packet holds nothing but filler, and splits the
+        complete lines out of the ring buffer in bulk. Over a serial
+        transport it drains whatever the port has buffered. Use this
+        instead of calling read() once per character.
+
+        All sentences completed by one call share a single millis() time
+        stamp. They wait in the queue for lastNMEA() or popNMEA(), up to
+        NMEA_QUEUE_DEPTH of them.
+        @return The number of complete sentences produced by this call
+    */
+    /**************************************************************************/
+    uint8_t poll(void) override {
+        uint8_t sentences = 0;
+
+        if (paused || noComms)
+            return sentences;
+
+        uint32_t t = millis();
+        for (uint8_t i = 0; i < Transport::FILLS_PER_POLL; i++) {
+            bool more = transport.fill();
+            for (int c = transport.read(); c >= 0; c = transport.read()) {
+                if (lineChar(c, t))
+                    sentences++;
+            }
+            if (!more)
+                break;  // the receiver has run dry
+        }
+        return sentences;
+    }
+
+    /**************************************************************************/
+    /*!
+        @brief Send a command to the GPS device
+        @param str Pointer to a string holding the command to send
+    */
+    /**************************************************************************/
+    void sendCommand(const char *str) override { transport.sendCommand(str); }
+
+    /**************************************************************************/
+    /*!
+        @brief Switch an I2CTransport to L76 packet mode, see
+        I2CTransport::setPacketMode(). Call after begin().
+        @param l76 True to use full L76 packets, false to go back to
+        GPS_MAX_I2C_TRANSFER sized reads with no spacing
+        @return True if the mode was set
+    */
+    /**************************************************************************/
+    bool setI2CPacketMode(bool l76 = true) {
+        return transport.setPacketMode(l76);
+    }
+
+    Transport transport;  ///< the bus or port the GPS is on
+};
+
+typedef INA_Receiver<I2CTransport> INA;  ///< the L76-L on Wire at 0x10
 #endif  // INA_H
@@ -0,0 +1,227 @@
+/*!
+ * @file INA_binary.cpp
+ * @brief Compact binary output of a fix, for metered links
+ * @n ...
+ * @copyright   MIT License
+ * @author [Bjarke Gotfredsen](bjarke@gotfredsen.com)
+ * @version  V1.0
+ * @date  2023
+ * @https://github.com/domino4com/INA
+ */
+#include "INA.h"
+
+#define INA_PACKED_MAGIC 'I'  ///< first byte of every fixPacked() record
+
+/*
+    Layout of a fixPacked() record, all values little endian:
+
+     0  magic 'I'             1  INA_PACKED_VERSION
+     2  have, 2 bytes         4  fix | fixquality << 1 | fixquality_3d << 4
+     5  satellites            6  UTC from epochMillis(), 6 bytes
+    12  latitude_fixed, 4    16  longitude_fixed, 4
+    20  altitude_fixed, 4    24  speed_fixed, 4
+    28  angle_fixed, 2       30  HDOP in hundredths, 2
+*/
+
+/**************************************************************************/
+/*!
+    @brief Store the low bytes of a value, least significant first
+    @param p Where to store it
+    @param v The value
+    @param bytes How many bytes to store
+*/
+/**************************************************************************/
+static void putLE(uint8_t *p, uint64_t v, uint8_t bytes) {
+    for (uint8_t i = 0; i < bytes; i++, v >>= 8)
+        p[i] = v & 0xFF;
+}
+
+/**************************************************************************/
+/*!
+    @brief Load a value stored by putLE()
+    @param p Where it is stored
+    @param bytes How many bytes it takes
+    @return The value
+*/
+/**************************************************************************/
+static uint64_t getLE(const uint8_t *p, uint8_t bytes) {
+    uint64_t v = 0;
+    for (uint8_t i = bytes; i > 0; i--)
+        v = (v << 8) | p[i - 1];
+    return v;
+}
+
+/**************************************************************************/
+/*!
+    @brief HDOP in hundredths, held to what 2 bytes can carry
+    @param hdop The HDOP
+    @return HDOP * 100, rounded, from 0 to 65535
+*/
+/**************************************************************************/
+static uint16_t hdopCenti(nmea_float_t hdop) {
+    if (!(hdop > 0))
+        return 0;
+    if (hdop >= 655.35)
+        return 65535;
+    return (uint16_t)(hdop * 100 + 0.5f);
+}
+
+/**************************************************************************/
+/*!
+    @brief Write a fix as a fixed layout record of INA_PACKED_SIZE bytes,
+    with the position and motion kept as the scaled integers the parser
+    makes, so nothing is lost but HDOP past its second decimal
+    @param f The fix, e.g. from getFix() or snapshot()
+    @param buff Where to write the record
+    @param len Size of buff
+    @return INA_PACKED_SIZE, or 0 if buff is too small
+*/
+/**************************************************************************/
+size_t INA_Core::fixPacked(const nmea_fix_t &f, uint8_t *buff, size_t len) {
+    if (buff == NULL || len < INA_PACKED_SIZE)
+        return 0;
+    buff[0] = INA_PACKED_MAGIC;
+    buff[1] = INA_PACKED_VERSION;
+    putLE(buff + 2, f.have, 2);
+    buff[4] = (f.fix ? 1 : 0) | (f.fixquality & 7) << 1 |
+              (f.fixquality_3d & 3) << 4;
+    buff[5] = f.satellites;
+    putLE(buff + 6, nmea::epochMillis(f), 6);
+    putLE(buff + 12, (uint32_t)f.latitude_fixed, 4);
+    putLE(buff + 16, (uint32_t)f.longitude_fixed, 4);
+    putLE(buff + 20, (uint32_t)f.altitude_fixed, 4);
+    putLE(buff + 24, (uint32_t)f.speed_fixed, 4);
+    putLE(buff + 28, (uint16_t)f.angle_fixed, 2);
+    putLE(buff + 30, hdopCenti(f.HDOP), 2);
+    return INA_PACKED_SIZE;
+}
+
+/**************************************************************************/
+/*!
+    @brief Read a record written by fixPacked() back into a fix
+    @param buff The record
+    @param len Bytes in buff
+    @param f The fix to fill. Fields the record doesn't carry are 0.
+    @return false if buff is short, or not a record of this version
+*/
+/**************************************************************************/
+bool INA_Core::unpackFix(const uint8_t *buff, size_t len, nmea_fix_t &f) {
+    if (buff == NULL || len < INA_PACKED_SIZE ||
+        buff[0] != INA_PACKED_MAGIC || buff[1] != INA_PACKED_VERSION)
+        return false;
+    f = nmea_fix_t();
+    nmea::fromEpochMillis(getLE(buff + 6, 6), f);
+    f.have = getLE(buff + 2, 2);
+    f.fix = buff[4] & 1;
+    f.fixquality = (buff[4] >> 1) & 7;
+    f.fixquality_3d = (buff[4] >> 4) & 3;
+    f.satellites = buff[5];
+    f.latitude_fixed = (int32_t)getLE(buff + 12, 4);
+    f.longitude_fixed = (int32_t)getLE(buff + 16, 4);
+    f.altitude_fixed = (int32_t)getLE(buff + 20, 4);
+    f.speed_fixed = (int32_t)getLE(buff + 24, 4);
+    f.angle_fixed = getLE(buff + 28, 2);
+    f.HDOP = getLE(buff + 30, 2) / (nmea_float_t)100;
+    return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Write a fix as a MessagePack map through ArduinoJson, with short
+    keys and the same scaled integers as fixPacked(). Only the groups of
+    fields the fix has are written, so it is often smaller than the packed
+    record, and any MessagePack reader can decode it.
+    @param f The fix, e.g. from getFix() or snapshot()
+    @param buff Where to write the map
+    @param len Size of buff
+    @return Bytes written, 0 if buff is too small
+*/
+/**************************************************************************/
+size_t INA_Core::fixMsgPack(const nmea_fix_t &f, uint8_t *buff, size_t len) {
+    JsonDocument doc;
+    doc["v"] = INA_PACKED_VERSION;
+    doc["t"] = nmea::epochMillis(f);
+    doc["h"] = f.have;
+    doc["fix"] = f.fix;
+    if (f.have & NMEA_FIX_POSITION) {
+        doc["lat"] = f.latitude_fixed;
+        doc["lon"] = f.longitude_fixed;
+    }
+    if (f.have & NMEA_FIX_ALTITUDE)
+        doc["alt"] = f.altitude_fixed;
+    if (f.have & NMEA_FIX_VELOCITY) {
+        doc["sog"] = f.speed_fixed;
+        doc["cog"] = f.angle_fixed;
+    }
+    if (f.have & (NMEA_FIX_QUALITY | NMEA_FIX_DOP)) {
+        doc["q"] = f.fixquality | f.fixquality_3d << 4;
+        doc["sat"] = f.satellites;
+        doc["hdop"] = hdopCenti(f.HDOP);
+    }
+    if (buff == NULL || len < measureMsgPack(doc))
+        return 0;
+    return serializeMsgPack(doc, buff, len);
+}
+
+/**************************************************************************/
+/*!
+    @brief Read a map written by fixMsgPack() back into a fix
+    @param buff The MessagePack data
+    @param len Bytes in buff
+    @param f The fix to fill. Fields the map doesn't carry are 0.
+    @return false if it isn't MessagePack, or not a map of this version
+*/
+/**************************************************************************/
+bool INA_Core::unpackMsgPack(const uint8_t *buff, size_t len, nmea_fix_t &f) {
+    JsonDocument doc;
+    if (buff == NULL || deserializeMsgPack(doc, buff, len) ||
+        doc["v"] != INA_PACKED_VERSION)
+        return false;
+    f = nmea_fix_t();
+    nmea::fromEpochMillis(doc["t"].as<uint64_t>(), f);
+    f.have = doc["h"];
+    f.fix = doc["fix"];
+    f.latitude_fixed = doc["lat"];
+    f.longitude_fixed = doc["lon"];
+    f.altitude_fixed = doc["alt"];
+    f.speed_fixed = doc["sog"];
+    f.angle_fixed = doc["cog"];
+    uint8_t q = doc["q"];
+    f.fixquality = q & 7;
+    f.fixquality_3d = q >> 4;
+    f.satellites = doc["sat"];
+    f.HDOP = doc["hdop"].as<uint16_t>() / (nmea_float_t)100;
+    return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Wait for the next epoch like getJSON(), and write it as a packed
+    record, see fixPacked()
+    @param buff Where to write the record
+    @param len Size of buff, at least INA_PACKED_SIZE
+    @return INA_PACKED_SIZE, or 0 if there was no new epoch
+*/
+/**************************************************************************/
+size_t INA_Core::getPacked(uint8_t *buff, size_t len) {
+    nmea_fix_t f;
+    if (!waitFix(f))
+        return 0;
+    return fixPacked(f, buff, len);
+}
+
+/**************************************************************************/
+/*!
+    @brief Wait for the next epoch like getJSON(), and write it as
+    MessagePack, see fixMsgPack()
+    @param buff Where to write the map
+    @param len Size of buff
+    @return Bytes written, or 0 if there was no new epoch
+*/
+/**************************************************************************/
+size_t INA_Core::getMsgPack(uint8_t *buff, size_t len) {
+    nmea_fix_t f;
+    if (!waitFix(f))
+        return 0;
+    return fixMsgPack(f, buff, len);
+}
@@ -0,0 +1,549 @@
+/*!
+ * @file INA_json.cpp
+ * @brief JSON output written straight from a fix, without ArduinoJson
+ * @n ...
+ * @copyright   MIT License
+ * @author [Bjarke Gotfredsen](bjarke@gotfredsen.com)
+ * @version  V1.0
+ * @date  2023
+ * @https://github.com/domino4com/INA
+ */
+#include "INA.h"
+
+/**************************************************************************/
+/*!
+    Where the JSON encoder puts its text: a caller's buffer, or a Print
+    fed in chunks from a small buffer on the stack. Counts every byte, even
+    those that didn't fit, so a caller can tell how big a buffer it needs.
+*/
+/**************************************************************************/
+struct INA_JsonSink {
+    char *buff;     ///< the caller's buffer, NULL when writing to out
+    size_t len;     ///< size of buff
+    Print *out;     ///< where to write, NULL when filling buff
+    size_t n = 0;   ///< bytes of JSON so far
+    char chunk[64];     ///< bytes waiting for out
+    uint8_t queued = 0;  ///< bytes in chunk
+
+    INA_JsonSink(char *b, size_t l) : buff(b), len(l), out(NULL) {}
+    INA_JsonSink(Print &p) : buff(NULL), len(0), out(&p) {}
+
+    void put(const char *s, size_t k) {
+        if (out == NULL) {
+            if (n + 1 < len)
+                memcpy(buff + n, s, min(k, len - 1 - n));
+        } else {
+            for (size_t i = 0; i < k; i++) {
+                chunk[queued++] = s[i];
+                if (queued == sizeof(chunk))
+                    flush();
+            }
+        }
+        n += k;
+    }
+    template <size_t N>
+    void put(const char (&s)[N]) {
+        put(s, N - 1);  // key fragments are string literals, no strlen()
+    }
+    void flush(void) {
+        out->write((const uint8_t *)chunk, queued);
+        queued = 0;
+    }
+    size_t finish(void) {
+        if (out != NULL)
+            flush();
+        else if (len > 0)
+            buff[min(n, len - 1)] = 0;
+        return n;
+    }
+
+    /**************************************************************************/
+    /*!
+        @brief Write a scaled integer as a decimal number, e.g. 5454 with 1
+        decimal as 545.4, without any floating point
+        @param v The value, times 10 to the power of decimals
+        @param decimals Decimal places in v
+        @param trim True to drop trailing zeros after the point, and the
+        point if nothing is left after it
+    */
+    /**************************************************************************/
+    void putFixed(int32_t v, uint8_t decimals, bool trim = true) {
+        char tmp[14];
+        char *end = tmp + sizeof(tmp);
+        char *p = end;
+        uint32_t u = (v < 0) ? -(uint32_t)v : v;
+        for (uint8_t d = 0; d < decimals; d++) {
+            *--p = '0' + u % 10;
+            u /= 10;
+        }
+        if (decimals > 0)
+            *--p = '.';
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while (u);
+        if (v < 0)
+            *--p = '-';
+        if (trim && decimals > 0) {
+            while (end[-1] == '0')
+                end--;
+            if (end[-1] == '.')
+                end--;
+        }
+        put(p, end - p);
+    }
+
+    /**************************************************************************/
+    /*!
+        @brief Write an unsigned number of any size, such as epoch ms
+        @param v The number
+    */
+    /**************************************************************************/
+    void putUnsigned(uint64_t v) {
+        char tmp[20];
+        char *p = tmp + sizeof(tmp);
+        do {
+            *--p = '0' + v % 10;
+            v /= 10;
+        } while (v);
+        put(p, tmp + sizeof(tmp) - p);
+    }
+};
+
+/**************************************************************************/
+/*!
+    @brief Write a fix as the same JSON getJSON(JsonDocument &) builds, name,
+    value and unit objects in an "INA" array, straight from the fixed point
+    values. Nothing is allocated.
+    @param f The fix
+    @param s Where the JSON goes
+    @param fields Bits 1 << nmea_delta_field_t of the fields to write, the
+    timestamp is always written. If not all are set, the document is
+    flagged "delta".
+    @return Length of the JSON
+*/
+/**************************************************************************/
+static size_t writeFixJSON(const nmea_fix_t &f, INA_JsonSink &s,
+                           uint16_t fields = 0xFFFF) {
+    char ts[NMEA_ISO_TIME_SIZE];
+    s.put("{\"INA\":[{\"name\":\"Timestamp\",\"value\":\"");
+    s.put(ts, nmea::isoTime(nmea::epochMillis(f), ts));
+    s.put("\",\"unit\":\"ISO 8601\"}");
+
+    if (f.fix && (fields & (1 << NMEA_DELTA_LAT | 1 << NMEA_DELTA_LON))) {
+        // degrees * 1e7 rounded to the 6 decimals Kibana gets
+        int32_t lon = f.longitude_fixed + (f.longitude_fixed < 0 ? -5 : 5);
+        int32_t lat = f.latitude_fixed + (f.latitude_fixed < 0 ? -5 : 5);
+        s.put(",{\"name\":\"location\",\"value\":\"POINT (");
+        s.putFixed(lon / 10, 6, false);
+        s.put(",");
+        s.putFixed(lat / 10, 6, false);
+        s.put(")\",\"unit\":\"\"}");
+    }
+    if (f.fix && (fields & 1 << NMEA_DELTA_ALT)) {
+        s.put(",{\"name\":\"Alt\",\"value\":");
+        s.putFixed(f.altitude_fixed, 1);
+        s.put(",\"unit\":\"m\"}");
+    }
+    if (f.fix && (fields & 1 << NMEA_DELTA_SOG)) {
+        // thousandths of a knot to mm/s, 0.514444 m/s per knot
+        int32_t sog = ((int64_t)f.speed_fixed * 514444 + 500000) / 1000000;
+        s.put(",{\"name\":\"SoG\",\"value\":");
+        s.putFixed(sog, 3);
+        s.put(",\"unit\":\"m/s\"}");
+    }
+    if (f.fix && (fields & 1 << NMEA_DELTA_COG)) {
+        s.put(",{\"name\":\"CoG\",\"value\":");
+        s.putFixed(f.angle_fixed, 2);
+        s.put(",\"unit\":\"º\"}");
+    }
+    if (f.fix && (fields & 1 << NMEA_DELTA_SAT)) {
+        s.put(",{\"name\":\"Sat\",\"value\":");
+        s.putFixed(f.satellites, 0);
+        s.put(",\"unit\":\"\"}");
+    }
+
+    if (fields & 1 << NMEA_DELTA_FIX) {
+        s.put(",{\"name\":\"Fix\",\"value\":");
+        if (f.fix)
+            s.put("true");
+        else
+            s.put("false");
+        s.put(",\"unit\":\"\"}");
+    }
+
+    if (fields & 1 << NMEA_DELTA_HDOP) {
+        s.put(",{\"name\":\"HDOP\",\"value\":");
+        s.putFixed((int32_t)(f.HDOP * 100 + 0.5f), 2);
+        s.put(",\"unit\":\"\"}");
+    }
+    if (fields == 0xFFFF)
+        s.put("]}");
+    else
+        s.put("],\"delta\":true}");
+    return s.finish();
+}
+
+/**************************************************************************/
+/*!
+    @brief Pick the fields of a fix a deltaJSON() consumer needs, and note
+    them as sent. Everything is picked for a keyframe.
+    @param f The fix
+    @param d What the consumer has
+    @return Bits 1 << nmea_delta_field_t of the fields to send, 0xFFFF for
+    a keyframe
+*/
+/**************************************************************************/
+static uint16_t deltaFields(const nmea_fix_t &f, nmea_delta_t &d) {
+    int32_t v[NMEA_DELTA_FIELDS];
+    v[NMEA_DELTA_LAT] = f.latitude_fixed;
+    v[NMEA_DELTA_LON] = f.longitude_fixed;
+    v[NMEA_DELTA_ALT] = f.altitude_fixed;
+    v[NMEA_DELTA_SOG] = f.speed_fixed;
+    v[NMEA_DELTA_COG] = f.angle_fixed;
+    v[NMEA_DELTA_SAT] = f.satellites;
+    v[NMEA_DELTA_FIX] = f.fix;
+    v[NMEA_DELTA_HDOP] = (int32_t)(f.HDOP * 100 + 0.5f);
+
+    bool key = !d.primed || (d.keyframe && ++d.sinceKey >= d.keyframe);
+    uint16_t fields = key ? 0xFFFF : 0;
+    for (uint8_t i = 0; i < NMEA_DELTA_FIELDS; i++) {
+        if (!key) {
+            if (!f.fix && i < NMEA_DELTA_FIX)
+                continue;  // not written without a fix, so not sent
+            uint32_t diff = (v[i] > d.last[i]) ? (uint32_t)v[i] - d.last[i]
+                                               : (uint32_t)d.last[i] - v[i];
+            if (i == NMEA_DELTA_COG && diff > 18000)
+                diff = 36000 - diff;  // 359.9 to 0.1 is 0.2 degrees
+            if (diff == 0 || diff <= (uint32_t)d.tolerance[i])
+                continue;
+            fields |= 1 << i;
+        }
+        if (f.fix || i >= NMEA_DELTA_FIX)
+            d.last[i] = v[i];
+    }
+    if (key) {
+        d.primed = f.fix;  // without a fix it can't carry the position
+        d.sinceKey = 0;
+    }
+    if (fields & (1 << NMEA_DELTA_LAT | 1 << NMEA_DELTA_LON)) {
+        // location carries both, so the consumer has both
+        d.last[NMEA_DELTA_LAT] = v[NMEA_DELTA_LAT];
+        d.last[NMEA_DELTA_LON] = v[NMEA_DELTA_LON];
+    }
+    return fields;
+}
+
+/**************************************************************************/
+/*!
+    @brief Write only what changed in a fix since the last document sent to
+    a consumer, in the layout of fixJSON(): the timestamp, and the fields
+    that moved by more than their tolerance in delta. Every keyframe'th
+    document, and the first, is a full one, so a consumer can rebuild the
+    whole state from the last keyframe and the deltas after it. A keyframe
+    without a fix has no position, so every document is a keyframe until
+    one has a fix. Other documents are flagged "delta":true, and leave out
+    the fields that need a fix while there is none.
+    @param f The fix, e.g. from getFix() or snapshot()
+    @param delta What this consumer has, updated as the fields are sent
+    @param buff The buffer, always 0 terminated if len > 0
+    @param len Size of the buffer
+    @return Length of the whole JSON. If it is len or more, the JSON was cut
+    short, and delta is left as it was, so the fix can be sent again with a
+    bigger buffer.
+*/
+/**************************************************************************/
+size_t INA_Core::deltaJSON(const nmea_fix_t &f, nmea_delta_t &delta,
+                           char *buff, size_t len) {
+    nmea_delta_t was = delta;
+    INA_JsonSink s(buff, len);
+    size_t n = writeFixJSON(f, s, deltaFields(f, delta));
+    if (n >= len)
+        delta = was;
+    return n;
+}
+
+/**************************************************************************/
+/*!
+    @brief Write only what changed in a fix to a Print, see deltaJSON()
+    @param f The fix, e.g. from getFix() or snapshot()
+    @param delta What this consumer has, updated as the fields are sent
+    @param out Where to write it
+    @return Bytes written
+*/
+/**************************************************************************/
+size_t INA_Core::deltaJSON(const nmea_fix_t &f, nmea_delta_t &delta,
+                           Print &out) {
+    INA_JsonSink s(out);
+    return writeFixJSON(f, s, deltaFields(f, delta));
+}
+
+/**************************************************************************/
+/*!
+    @brief Wait for the next epoch like getJSON(), and write what changed
+    since the last document sent to a consumer, see deltaJSON()
+    @param delta What this consumer has
+    @param buff The buffer
+    @param len Size of the buffer
+    @return Length of the JSON, or 0 if there was no new epoch
+*/
+/**************************************************************************/
+size_t INA_Core::getDeltaJSON(nmea_delta_t &delta, char *buff, size_t len) {
+    nmea_fix_t f;
+    if (!waitFix(f))
+        return 0;
+    return deltaJSON(f, delta, buff, len);
+}
+
+/**************************************************************************/
+/*!
+    @brief Write a fix as JSON into a buffer, in the layout getJSON() uses,
+    without ArduinoJson or any heap use. Numbers are written from the fixed
+    point values with as many decimals as the GPS sends, trailing zeros
+    trimmed, where getJSON(JsonDocument &) goes through floats and gets up
+    to 9 significant digits, e.g. "HDOP":0.9 against "HDOP":0.899999976.
+    @param f The fix, e.g. from getFix() or snapshot()
+    @param buff The buffer, always 0 terminated if len > 0
+    @param len Size of the buffer
+    @return Length of the whole JSON. If it is len or more, the JSON was cut
+    short and a buffer of at least the return value + 1 is needed.
+*/
+/**************************************************************************/
+size_t INA_Core::fixJSON(const nmea_fix_t &f, char *buff, size_t len) {
+    INA_JsonSink s(buff, len);
+    return writeFixJSON(f, s);
+}
+
+/**************************************************************************/
+/*!
+    @brief Write a fix as JSON to a Print, such as Serial or a network
+    client, in chunks of up to 64 bytes, in the layout getJSON() uses
+    @param f The fix, e.g. from getFix() or snapshot()
+    @param out Where to write it
+    @return Bytes written
+*/
+/**************************************************************************/
+size_t INA_Core::fixJSON(const nmea_fix_t &f, Print &out) {
+    INA_JsonSink s(out);
+    return writeFixJSON(f, s);
+}
+
+/**************************************************************************/
+/*!
+    @brief Wait for the next epoch like getJSON(JsonDocument &), and write
+    it as JSON into a buffer, see fixJSON()
+    @param buff The buffer
+    @param len Size of the buffer
+    @return Length of the JSON, or 0 if there was no new epoch
+*/
+/**************************************************************************/
+size_t INA_Core::getJSON(char *buff, size_t len) {
+    nmea_fix_t f;
+    if (!waitFix(f))
+        return 0;
+    return fixJSON(f, buff, len);
+}
+
+/**************************************************************************/
+/*!
+    @brief Wait for the next epoch like getJSON(JsonDocument &), and write
+    it as JSON to a Print, see fixJSON()
+    @param out Where to write it
+    @return Bytes written, or 0 if there was no new epoch
+*/
+/**************************************************************************/
+size_t INA_Core::getJSON(Print &out) {
+    nmea_fix_t f;
+    if (!waitFix(f))
+        return 0;
+    return fixJSON(f, out);
+}
+
+/// batchJSON() document up to the first row, naming the columns once
+static const char batchHead[] =
+    "{\"INA\":{\"cols\":[\"t\",\"lat\",\"lon\",\"alt\",\"sog\",\"cog\","
+    "\"sat\",\"fix\",\"hdop\"],\"rows\":[";
+/// what closes a batchJSON() document, kept free at the end of the buffer
+static const char batchTail[] = "]}}";
+
+/**************************************************************************/
+/*!
+    @brief Write a fix as one batch row, a JSON array in the order of the
+    batchHead columns, with null for what the fix doesn't have
+    @param f The fix
+    @param s Where the row goes
+    @return Length of the row
+*/
+/**************************************************************************/
+static size_t writeFixRow(const nmea_fix_t &f, INA_JsonSink &s) {
+    s.put("[");
+    s.putUnsigned(nmea::epochMillis(f));
+    if (f.have & NMEA_FIX_POSITION) {
+        int32_t lat = f.latitude_fixed + (f.latitude_fixed < 0 ? -5 : 5);
+        int32_t lon = f.longitude_fixed + (f.longitude_fixed < 0 ? -5 : 5);
+        s.put(",");
+        s.putFixed(lat / 10, 6);
+        s.put(",");
+        s.putFixed(lon / 10, 6);
+    } else {
+        s.put(",null,null");
+    }
+    if (f.have & NMEA_FIX_ALTITUDE) {
+        s.put(",");
+        s.putFixed(f.altitude_fixed, 1);
+    } else {
+        s.put(",null");
+    }
+    if (f.have & NMEA_FIX_VELOCITY) {
+        s.put(",");
+        s.putFixed(((int64_t)f.speed_fixed * 514444 + 500000) / 1000000, 3);
+        s.put(",");
+        s.putFixed(f.angle_fixed, 2);
+    } else {
+        s.put(",null,null");
+    }
+    s.put(",");
+    s.putFixed(f.satellites, 0);
+    s.put(",");
+    if (f.fix)
+        s.put("true,");
+    else
+        s.put("false,");
+    s.putFixed((int32_t)(f.HDOP * 100 + 0.5f), 2);
+    s.put("]");
+    return s.finish();
+}
+
+/**************************************************************************/
+/*!
+    @brief Start batching fixes into one JSON document, which names the
+    columns once and then holds a compact array per fix, for sending many
+    fixes in one message. Column t is the UTC time in ms since 1970, the
+    others are as in fixJSON(). The document never outgrows the buffer.
+    @param buff The buffer for the document, which must outlive the batch,
+    or NULL to stop batching
+    @param len Size of buff
+    @param maxFixes Fixes that make batchReady() true, 0 for no limit but
+    the others
+    @param maxBytes Document length that makes batchReady() true, 0 for
+    no limit but buff itself
+    @param maxAge Milliseconds from the first fix that make batchReady()
+    true, 0 for no limit
+    @return False if buff can't even hold an empty document
+*/
+/**************************************************************************/
+bool INA_Core::setBatch(char *buff, size_t len, uint16_t maxFixes,
+                        size_t maxBytes, uint32_t maxAge) {
+    batch = NULL;
+    if (buff == NULL || len < sizeof(batchHead) + sizeof(batchTail) - 1)
+        return false;
+    batch = buff;
+    batchSize = len;
+    batchMaxN = maxFixes;
+    batchMaxBytes = maxBytes;
+    batchMaxAge = maxAge;
+    clearBatch();
+    return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Empty the batch after its document has been sent
+*/
+/**************************************************************************/
+void INA_Core::clearBatch(void) {
+    batchN = 0;
+    batchRow = 0;
+    if (batch == NULL)
+        return;
+    memcpy(batch, batchHead, sizeof(batchHead) - 1);
+    batchUsed = sizeof(batchHead) - 1;
+}
+
+/**************************************************************************/
+/*!
+    @brief Add a fix to the batch as one row
+    @param f The fix, e.g. from getFix() or snapshot()
+    @param now millis() when it was taken, for the maxAge trigger
+    @return False if no batch is set, or the row doesn't fit. Send
+    batchJSON(), clearBatch() and add the fix again.
+*/
+/**************************************************************************/
+bool INA_Core::batchFix(const nmea_fix_t &f, uint32_t now) {
+    if (batch == NULL || batchN == 0xFFFF)
+        return false;
+    size_t sep = (batchN > 0) ? 1 : 0;
+    size_t room = batchSize - sizeof(batchTail) - batchUsed;
+    if (room <= sep)
+        return false;
+    INA_JsonSink s(batch + batchUsed + sep, room - sep + 1);
+    size_t n = writeFixRow(f, s);  // its 0 lands where the tail goes
+    if (n > room - sep)
+        return false;
+    if (sep)
+        batch[batchUsed] = ',';
+    if (batchN == 0)
+        batchStart = now;
+    batchUsed += sep + n;
+    batchRow = n + 1;  // the next row, with its comma
+    batchN++;
+    return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Wait for the next epoch like getJSON(), and add it to the batch
+    @return False if there was no new epoch, or batchFix() failed
+*/
+/**************************************************************************/
+bool INA_Core::batchFix(void) {
+    nmea_fix_t f;
+    if (!waitFix(f))
+        return false;
+    return batchFix(f);
+}
+
+/**************************************************************************/
+/*!
+    @brief Check the flush triggers set by setBatch()
+    @param now millis() to measure the age of the batch against
+    @return True if the batch has the fixes, bytes or age to be sent, or
+    another row like the last one would not fit
+*/
+/**************************************************************************/
+bool INA_Core::batchReady(uint32_t now) {
+    if (batch == NULL || batchN == 0)
+        return false;
+    size_t room = batchSize - sizeof(batchTail) - batchUsed;
+    return (batchMaxN && batchN >= batchMaxN) ||
+           (batchMaxBytes && batchUsed + sizeof(batchTail) > batchMaxBytes) ||
+           (batchMaxAge && now - batchStart >= batchMaxAge) ||
+           (room < batchRow);
+}
+
+/**************************************************************************/
+/*!
+    @brief Close the batch document, ready to send. More fixes can still be
+    added until clearBatch().
+    @param len Set to the length of the document if not NULL
+    @return The document, 0 terminated, or NULL if no batch is set
+*/
+/**************************************************************************/
+const char *INA_Core::batchJSON(size_t *len) {
+    if (batch == NULL)
+        return NULL;
+    memcpy(batch + batchUsed, batchTail, sizeof(batchTail));
+    if (len != NULL)
+        *len = batchUsed + sizeof(batchTail) - 1;
+    return batch;
+}
+
+/**************************************************************************/
+/*!
+    @brief How many fixes are in the batch
+    @return Rows in the batch document
+*/
+/**************************************************************************/
+uint16_t INA_Core::batchCount(void) {
+    return batchN;
+}
@@ -0,0 +1,149 @@
+/*!
+ * @file INA_transport.cpp
+ * @brief The parts of the transports too big to inline
+ * @n ...
+ * @copyright   MIT License
+ * @author [Bjarke Gotfredsen](bjarke@gotfredsen.com)
+ * @version  V1.0
+ * @date  2023
+ * @https://github.com/domino4com/INA
+ */
+#include "INA_transport.h"
+
+/**************************************************************************/
+/*!
+    @brief Start the I2C bus and see if the GPS ACK's its address
+    @return True if the GPS answered
+*/
+/**************************************************************************/
+bool I2CTransport::begin(void) {
+    gpsI2C->begin();
+    // A basic scanner, see if it ACK's
+    gpsI2C->beginTransmission(_i2caddr);
+    return (gpsI2C->endTransmission() == 0);
+}
+
+/**************************************************************************/
+/*!
+    @brief Write a byte to the GPS in an I2C transaction of its own
+    @param c A single byte to send
+    @return Bytes written - 1 on success, 0 on failure
+*/
+/**************************************************************************/
+size_t I2CTransport::write(uint8_t c) {
+    gpsI2C->beginTransmission(_i2caddr);
+    if (gpsI2C->write(c) != 1) {
+        return 0;
+    }
+    if (gpsI2C->endTransmission(true) == 0) {
+        return 1;
+    }
+    return 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief Send a command to the GPS device in one I2C transaction
+    @param str Pointer to a string holding the command to send
+*/
+/**************************************************************************/
+void I2CTransport::sendCommand(const char *str) {
+    Serial.println(str);
+    gpsI2C->beginTransmission(_i2caddr);
+    for (int i = 0; str[i] != 0; i++) {
+        gpsI2C->write(str[i]);
+    }
+    gpsI2C->write(0x0D);
+    gpsI2C->write(0x0A);
+    gpsI2C->endTransmission();
+}
+
+/**************************************************************************/
+/*!
+    @brief Switch to the packet protocol described in the Quectel L76-L/L96
+    I2C Application Note: every read fetches the full GPS_L76_I2C_PACKET
+    byte buffer of the receiver, and reads are spaced at least
+    GPS_L76_I2C_INTERVAL ms apart. This cuts the number of I2C transactions
+    per sentence by about 8 compared to GPS_MAX_I2C_TRANSFER sized reads.
+    Call after begin().
+
+    On the ESP32 the Wire buffer has to be enlarged to hold a whole packet,
+    which briefly restarts the bus.
+    @param l76 True to use full L76 packets, false to go back to
+    GPS_MAX_I2C_TRANSFER sized reads with no spacing
+    @return True if the mode was set, false if the I2C buffer can't hold a
+    full packet on this platform
+*/
+/**************************************************************************/
+bool I2CTransport::setPacketMode(bool l76) {
+    if (!l76) {
+        _i2cpacket = GPS_MAX_I2C_TRANSFER;
+        _i2cinterval = 0;
+        return true;
+    }
+#if defined(ARDUINO_ARCH_ESP32)
+    if (gpsI2C->setBufferSize(GPS_L76_I2C_PACKET) < GPS_L76_I2C_PACKET) {
+        gpsI2C->end();  // the buffer can only be resized while the bus is down
+        bool resized =
+            (gpsI2C->setBufferSize(GPS_L76_I2C_PACKET) >= GPS_L76_I2C_PACKET);
+        gpsI2C->begin();
+        if (!resized)
+            return false;
+    }
+#else
+    return false;  // the Wire buffer is too small for a full packet
+#endif
+    _i2cpacket = GPS_L76_I2C_PACKET;
+    _i2cinterval = GPS_L76_I2C_INTERVAL;
+    return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Read one I2C packet from the GPS into the ring buffer, dropping
+    the 0x0A filler bytes the receiver pads its packets with. A packet that
+    is nothing but filler is recognized in one pass and never reaches the
+    line assembler. In L76 packet mode no read is made until
+    GPS_L76_I2C_INTERVAL ms have passed since the previous one.
+    @return True if the packet held any data, false if it was empty, the
+    transfer failed, it was too early to read or there was no room for it
+*/
+/**************************************************************************/
+bool I2CTransport::fill(void) {
+    uint16_t room = (_ringTail - _ringHead - 1) & (GPS_I2C_RING_SIZE - 1);
+    if (room < _i2cpacket)
+        return false;
+    if (_i2cinterval && (int32_t)(millis() - _i2cNextRead) < 0)
+        return false;  // the receiver needs a break between reads
+    uint8_t n = gpsI2C->requestFrom(_i2caddr, _i2cpacket, (uint8_t) true);
+    _i2cNextRead = millis() + _i2cinterval;
+    if (n != _i2cpacket)
+        return false;
+
+    char packet[GPS_L76_I2C_PACKET];
+    gpsI2C->readBytes(packet, n);
+
+    bool gotData = false;
+    int i = 0;
+    while (i < n && packet[i] == 0x0A)  // an idle receiver sends only filler
+        i++;
+    if (i > 0 && last_char == 0x0D) {
+        // keep the first 0x0A as the end of a CRLF split across packets
+        last_char = 0x0A;
+        _i2cring[_ringHead] = last_char;
+        _ringHead = (_ringHead + 1) & (GPS_I2C_RING_SIZE - 1);
+        gotData = true;
+    }
+    for (; i < n; i++) {
+        char curr_char = packet[i];
+        if ((curr_char == 0x0A) && (last_char != 0x0D)) {
+            // skip duplicate 0x0A's - but keep as part of a CRLF
+            continue;
+        }
+        last_char = curr_char;
+        _i2cring[_ringHead] = curr_char;
+        _ringHead = (_ringHead + 1) & (GPS_I2C_RING_SIZE - 1);
+        gotData = true;
+    }
+    return gotData;
+}
@@ -0,0 +1,288 @@
+/*!
+ * @file INA_transport.h
+ * @brief Transports that move bytes between INA_Receiver and the GPS
+ *
+ * Each transport is a plain class with the same small set of inline
+ * members, so INA_Receiver<Transport> can call them directly and the
+ * compiler keeps only the code of the transport a board actually uses:
+ *
+ *   bool begin()            start the bus or port, true if the GPS answers
+ *   size_t available()      bytes that read() can return without waiting
+ *   int read()              next buffered byte, or -1 if there is none
+ *   bool fill()             fetch more bytes for read(), true if it got some
+ *   size_t write(uint8_t)   send a byte to the GPS
+ *   void sendCommand(const char *)  send a whole command line to the GPS
+ *
+ * FILLS_PER_POLL is how many times poll() may call fill() in one go.
+ */
+#ifndef INA_TRANSPORT_H
+#define INA_TRANSPORT_H
+
+#include <Wire.h>
+
+#include "Arduino.h"
+
+#define GPS_DEFAULT_I2C_ADDR \
+    0x10  ///< The default address for I2C transport of GPS data
+#define GPS_MAX_I2C_TRANSFER \
+    32  ///< The max number of bytes we'll try to read at once
+#define GPS_L76_I2C_PACKET \
+    255  ///< The L76-L/L96 I2C read buffer, see the I2C application note
+#define GPS_L76_I2C_INTERVAL \
+    2  ///< ms the L76-L/L96 needs between two I2C reads
+#define GPS_I2C_RING_SIZE \
+    256  ///< size of the I2C receive ring buffer, must be a power of 2
+         ///< and larger than GPS_L76_I2C_PACKET
+#define GPS_MAX_I2C_PACKETS \
+    16  ///< The max number of I2C packets poll() will fetch in one call
+
+/**************************************************************************/
+/*!
+    The L76-L on the I2C bus, read in packets into a ring buffer with the
+    0x0A filler bytes the receiver pads its packets with taken out.
+*/
+/**************************************************************************/
+class I2CTransport {
+   public:
+    static const uint8_t FILLS_PER_POLL =
+        GPS_MAX_I2C_PACKETS;  ///< packets poll() may fetch in one call
+
+    /**************************************************************************/
+    /*!
+        @brief Use a GPS on an I2C bus
+        @param wire The bus the GPS is on
+        @param addr The I2C address of the GPS
+    */
+    /**************************************************************************/
+    I2CTransport(TwoWire *wire = &Wire, uint8_t addr = GPS_DEFAULT_I2C_ADDR)
+        : gpsI2C(wire), _i2caddr(addr) {}
+
+    bool begin(void);
+    bool fill(void);
+    size_t write(uint8_t c);
+    void sendCommand(const char *str);
+    bool setPacketMode(bool l76);
+
+    /**************************************************************************/
+    /*!
+        @brief I2C has no 'availability', so there is always a byte to read
+        @return 1
+    */
+    /**************************************************************************/
+    size_t available(void) { return 1; }
+
+    /**************************************************************************/
+    /*!
+        @brief Take the next byte out of the ring buffer
+        @return The byte, or -1 if the ring is empty and needs a fill()
+    */
+    /**************************************************************************/
+    int read(void) {
+        if (_ringTail == _ringHead)
+            return -1;
+        uint8_t c = _i2cring[_ringTail];
+        _ringTail = (_ringTail + 1) & (GPS_I2C_RING_SIZE - 1);
+        return c;
+    }
+
+   private:
+    TwoWire *gpsI2C;                            ///< the bus the GPS is on
+    uint8_t _i2caddr;                           ///< the GPS address
+    uint8_t _i2cpacket = GPS_MAX_I2C_TRANSFER;  ///< bytes per I2C read
+    uint8_t _i2cinterval = 0;                   ///< min ms between I2C reads
+    uint32_t _i2cNextRead = 0;                  ///< millis() of next allowed read
+    char _i2cring[GPS_I2C_RING_SIZE];  ///< I2C bytes waiting for line assembly
+    uint16_t _ringHead = 0;            ///< where fill() puts the next byte
+    uint16_t _ringTail = 0;            ///< where read() takes the next byte
+    char last_char = 0;                ///< the last byte put in the ring
+};
+
+/**************************************************************************/
+/*!
+    Any Arduino Stream the GPS is already attached to, such as a
+    SoftwareSerial port, opened by the sketch before begin().
+*/
+/**************************************************************************/
+class StreamTransport {
+   public:
+    static const uint8_t FILLS_PER_POLL = 1;  ///< a stream needs no fetching
+
+    /**************************************************************************/
+    /*!
+        @brief Use a GPS on a stream the sketch has opened
+        @param stream The stream the GPS is on
+    */
+    /**************************************************************************/
+    StreamTransport(Stream *stream) : gpsStream(stream) {}
+
+    /**************************************************************************/
+    /*!
+        @brief Nothing to start, the sketch has opened the stream
+        @return True
+    */
+    /**************************************************************************/
+    bool begin(void) { return true; }
+
+    /**************************************************************************/
+    /*!
+        @brief The stream buffers by itself, so there is nothing to fetch
+        @return False
+    */
+    /**************************************************************************/
+    bool fill(void) { return false; }
+
+    /**************************************************************************/
+    /*!
+        @brief How many bytes the stream has buffered
+        @return Bytes available, 0 if none
+    */
+    /**************************************************************************/
+    size_t available(void) { return gpsStream->available(); }
+
+    /**************************************************************************/
+    /*!
+        @brief Read the next byte from the stream
+        @return The byte, or -1 if there is none
+    */
+    /**************************************************************************/
+    int read(void) { return gpsStream->read(); }
+
+    /**************************************************************************/
+    /*!
+        @brief Send a byte to the GPS
+        @param c The byte
+        @return Bytes written - 1 on success, 0 on failure
+    */
+    /**************************************************************************/
+    size_t write(uint8_t c) { return gpsStream->write(c); }
+
+    /**************************************************************************/
+    /*!
+        @brief Send a command line to the GPS
+        @param str Pointer to a string holding the command to send
+    */
+    /**************************************************************************/
+    void sendCommand(const char *str) {
+        gpsStream->print(str);
+        gpsStream->print("\r\n");
+    }
+
+   protected:
+    Stream *gpsStream;  ///< the stream the GPS is on
+};
+
+/**************************************************************************/
+/*!
+    A GPS on a hardware serial port, which begin() opens at the given baud
+    rate.
+*/
+/**************************************************************************/
+class UartTransport : public StreamTransport {
+   public:
+    /**************************************************************************/
+    /*!
+        @brief Use a GPS on a hardware serial port
+        @param serial The port the GPS is on
+        @param baud The baud rate to open it at, 9600 for the L76-L
+    */
+    /**************************************************************************/
+    UartTransport(HardwareSerial *serial, uint32_t baud = 9600)
+        : StreamTransport(serial), gpsHwSerial(serial), _baud(baud) {}
+
+    /**************************************************************************/
+    /*!
+        @brief Open the serial port
+        @return True
+    */
+    /**************************************************************************/
+    bool begin(void) {
+        gpsHwSerial->begin(_baud);
+        return true;
+    }
+
+   private:
+    HardwareSerial *gpsHwSerial;  ///< the port the GPS is on
+    uint32_t _baud;               ///< the baud rate to open it at
+};
+
+/**************************************************************************/
+/*!
+    Plays back NMEA text from memory instead of a GPS, for trying out a
+    sketch or checking the parser against recorded data on the bench.
+    Anything written to it is dropped.
+*/
+/**************************************************************************/
+class ReplayTransport {
+   public:
+    static const uint8_t FILLS_PER_POLL = 1;  ///< the text is all there
+
+    /**************************************************************************/
+    /*!
+        @brief Replay NMEA text
+        @param text The sentences, with their CR LF, 0 terminated. It must
+        stay in place while it is being replayed.
+    */
+    /**************************************************************************/
+    ReplayTransport(const char *text) : _text(text), _next(text) {}
+
+    /**************************************************************************/
+    /*!
+        @brief Start again from the beginning of the text
+        @return True
+    */
+    /**************************************************************************/
+    bool begin(void) {
+        _next = _text;
+        return true;
+    }
+
+    /**************************************************************************/
+    /*!
+        @brief The text is in memory, so there is nothing to fetch
+        @return False
+    */
+    /**************************************************************************/
+    bool fill(void) { return false; }
+
+    /**************************************************************************/
+    /*!
+        @brief How much of the text is left
+        @return Bytes available, 0 at the end of the text
+    */
+    /**************************************************************************/
+    size_t available(void) { return strlen(_next); }
+
+    /**************************************************************************/
+    /*!
+        @brief Read the next byte of the text
+        @return The byte, or -1 at the end of the text
+    */
+    /**************************************************************************/
+    int read(void) { return *_next ? (uint8_t)*_next++ : -1; }
+
+    /**************************************************************************/
+    /*!
+        @brief Drop a byte meant for the GPS
+        @param c The byte
+        @return 1
+    */
+    /**************************************************************************/
+    size_t write(uint8_t c) {
+        (void)c;
+        return 1;
+    }
+
+    /**************************************************************************/
+    /*!
+        @brief Drop a command meant for the GPS
+        @param str Pointer to a string holding the command
+    */
+    /**************************************************************************/
+    void sendCommand(const char *str) { (void)str; }
+
+   private:
+    const char *_text;  ///< the text to replay
+    const char *_next;  ///< the next byte to replay
+};
+
+#endif  // INA_TRANSPORT_H
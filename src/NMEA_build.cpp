@@ -47,7 +47,7 @@
     @return Pointer to sentence if successful, NULL if fails
 */
 /**************************************************************************/
-char *INA::build(char *nmea, const char *thisSource,
+char *INA_Core::build(char *nmea, const char *thisSource,
                           const char *thisSentence, char ref, bool noCRLF) {
   sprintf(nmea, "%6.2f",
           (double)123.45); // fail if sprintf() doesn't handle floats
@@ -61,12 +61,14 @@ char *INA::build(char *nmea, const char *thisSource,
   p += strlen(thisSentence);
   *p = ',';
   p += 1; // Now $XXSSS, and need to add argument fields
-  // This may look inefficient, but an M0 will get down the list in about 1 us /
-  // strcmp()! Put the GPS sentences from INA at the top to make
-  // pruning excess code easier. Otherwise, keep them alphabetical for ease of
-  // reading.
-
-  if (!strcmp(thisSentence, "GGA")) { //************************************GGA
+  // Dispatch on the sentence id packed into an integer, one switch instead of
+  // a strcmp() per sentence. Only three letter ids have a case, anything else
+  // falls through to the default. Put the GPS sentences from INA at the top
+  // to make pruning excess code easier. Otherwise, keep them alphabetical for
+  // ease of reading.
+  uint32_t key = (strlen(thisSentence) == 3) ? nmeaKey(thisSentence) : 0;
+  switch (key) {
+  case nmeaKey("GGA"): { //**************************************************GGA
     // GGA Global Positioning System Fix Data. Time, Position and fix related
     // data for a GPS receiver
     //       1         2       3 4        5 6 7  8   9  10 11 12 13  14  15
@@ -94,8 +96,10 @@ char *INA::build(char *nmea, const char *thisSource,
                 milliseconds / 1000.,
             (double)latitude, lat, (double)longitude, lon, fixquality,
             satellites, (double)HDOP, (double)altitude, (double)geoidheight);
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "GLL")) { //*****************************GLL
+  case nmeaKey("GLL"): { //**************************************************GLL
     // GLL Geographic Position – Latitude/Longitude
     //       1       2 3        4 5         6 7
     //       |       | |        | |         | |
@@ -111,8 +115,10 @@ char *INA::build(char *nmea, const char *thisSource,
             (double)longitude, lon,
             (double)hour * 10000L + minute * 100L + seconds +
                 milliseconds / 1000.);
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "GSA")) { //*****************************GSA
+  case nmeaKey("GSA"): { //**************************************************GSA
     // GSA GPS DOP and active satellites
     //       1 2 3                        14 15  16  17 18
     //       | | |                         | |   |   |   |
@@ -128,8 +134,9 @@ char *INA::build(char *nmea, const char *thisSource,
     // 17) VDOP in meters
     // 18) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "RMC")) { //*****************************RMC
+  case nmeaKey("RMC"): { //**************************************************RMC
     // RMC Recommended Minimum Navigation Information
     //                                                            12
     //       1         2 3       4 5        6 7   8   9     10  11 |
@@ -153,8 +160,10 @@ char *INA::build(char *nmea, const char *thisSource,
             (double)latitude, lat, (double)longitude, lon, (double)speed,
             (double)angle, day * 10000 + month * 100 + year,
             (double)magvariation, mag);
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "APB")) { //*****************************APB
+  case nmeaKey("APB"): { //**************************************************APB
     // APB Autopilot Sentence "B"
     //                                       13    15
     //       1 2 3   4 5 6 7 8   9 10   11 12 |  14 |
@@ -183,8 +192,9 @@ char *INA::build(char *nmea, const char *thisSource,
     // 14) M = Magnetic, T = True
     // 15) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "DBK")) { //*****************************DBT
+  case nmeaKey("DBK"): { //**************************************************DBT
     // DBK Depth Below Keel
     //       1   2 3   4 5   6 7
     //       |   | |   | |   | |
@@ -197,8 +207,9 @@ char *INA::build(char *nmea, const char *thisSource,
     // 6) F = Fathoms
     // 7) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "DBS")) { //*****************************DBT
+  case nmeaKey("DBS"): { //**************************************************DBT
     // DBS Depth Below Surface
     //       1   2 3   4 5   6 7
     //       |   | |   | |   | |
@@ -211,8 +222,9 @@ char *INA::build(char *nmea, const char *thisSource,
     // 6) F = Fathoms
     // 7) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "DBT")) { //*****************************DBT
+  case nmeaKey("DBT"): { //**************************************************DBT
     // DBT Depth Below Transducer
     //       1   2 3   4 5   6 7
     //       |   | |   | |   | |
@@ -224,10 +236,12 @@ char *INA::build(char *nmea, const char *thisSource,
     // 5) Depth, Fathoms
     // 6) F = Fathoms
     // 7) Checksum
-    double d = val[NMEA_DEPTH].latest - depthToTransducer;
+    double d = state.latest[NMEA_DEPTH] - depthToTransducer;
     sprintf(p, "%f,f,%f,M,,,", d / 0.3048, d);
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "DPT")) { //*****************************DPT
+  case nmeaKey("DPT"): { //**************************************************DPT
     // DPT Heading – Deviation & Variation
     //       1   2   3
     //       |   |   |
@@ -238,8 +252,9 @@ char *INA::build(char *nmea, const char *thisSource,
     //      negative means distance from transducer to keel
     // 3) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "GSV")) { //*****************************GSV
+  case nmeaKey("GSV"): { //**************************************************GSV
     // GSV Satellites in view
     //       1 2 3 4 5 6 7     n
     //       | | | | | | |     |
@@ -254,8 +269,9 @@ char *INA::build(char *nmea, const char *thisSource,
     // more satellite infos like 4)-7)
     // n) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "HDG")) { //*****************************HDG
+  case nmeaKey("HDG"): { //**************************************************HDG
     //  HDG Heading – Deviation & Variation
     //       1   2   3 4   5 6
     //       |   |   | |   | |
@@ -267,8 +283,9 @@ char *INA::build(char *nmea, const char *thisSource,
     // 5) Magnetic Variation direction, E = Easterly, W = Westerly
     // 6) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "HDM")) { //*****************************HDM
+  case nmeaKey("HDM"): { //**************************************************HDM
     // HDM Heading – Magnetic
     //       1   2 3
     //       |   | |
@@ -276,9 +293,11 @@ char *INA::build(char *nmea, const char *thisSource,
     // 1) Heading Degrees, magnetic
     // 2) M = magnetic
     // 3) Checksum
-    sprintf(p, "%f,M", (double)val[NMEA_HDG].latest);
+    sprintf(p, "%f,M", (double)state.latest[NMEA_HDG]);
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "HDT")) { //*****************************HDT
+  case nmeaKey("HDT"): { //**************************************************HDT
     // HDT Heading – True
     //       1   2 3
     //       |   | |
@@ -287,9 +306,11 @@ char *INA::build(char *nmea, const char *thisSource,
     // 2) T = True
     // 3) Checksum
     // starts with $II for integrated instrumentation
-    sprintf(p, "%f,T", (double)val[NMEA_HDT].latest);
+    sprintf(p, "%f,T", (double)state.latest[NMEA_HDT]);
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "MDA")) { //*****************************MDA
+  case nmeaKey("MDA"): { //**************************************************MDA
     // MDA Meteorological Composite
     //       1   2 3   4 5   6 7   8 9 10 11  12
     //       |   | |   | |   | |   | |  |  |   |
@@ -309,8 +330,9 @@ char *INA::build(char *nmea, const char *thisSource,
     // 11) Dew Point
     // 12) C or F
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "MTW")) { //*****************************MTW
+  case nmeaKey("MTW"): { //**************************************************MTW
     // MTW Water Temperature
     //       1   2 3
     //       |   | |
@@ -320,13 +342,15 @@ char *INA::build(char *nmea, const char *thisSource,
     // 2) Unit of Measurement, Celcius
     // 3) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "MWD")) { //*****************************MWD
+  case nmeaKey("MWD"): { //**************************************************MWD
     // MWD Wind Direction & Speed
     // Format unknown
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "MWV")) { //*****************************MWV
+  case nmeaKey("MWV"): { //**************************************************MWV
     // MWV Wind Speed and Angle assuming values for True
     //       1   2 3   4 5 6
     //       |   | |   | | |
@@ -339,13 +363,15 @@ char *INA::build(char *nmea, const char *thisSource,
     // 5) Status, A = Data Valid
     // 6) Checksum
     if (ref == 'R')
-      sprintf(p, "%f,%c,%f,N,A", (double)val[NMEA_AWA].latest, ref,
-              (double)val[NMEA_AWS].latest);
+      sprintf(p, "%f,%c,%f,N,A", (double)state.latest[NMEA_AWA], ref,
+              (double)state.latest[NMEA_AWS]);
     else
-      sprintf(p, "%f,%c,%f,N,A", (double)val[NMEA_TWA].latest, 'T',
-              (double)val[NMEA_TWS].latest);
+      sprintf(p, "%f,%c,%f,N,A", (double)state.latest[NMEA_TWA], 'T',
+              (double)state.latest[NMEA_TWS]);
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "RMB")) { //*****************************RMB
+  case nmeaKey("RMB"): { //**************************************************RMB
     // RMB Recommended Minimum Navigation Information
     //       1 2   3 4    5    6       7 8        9 10  11 12  13 14
     //       | |   | |    |    |       | |        | |   |   |   | |
@@ -361,9 +387,11 @@ char *INA::build(char *nmea, const char *thisSource,
     // 11) Bearing to destination in degrees True
     // 12) Destination closing velocity in knots
     // 13) Arrival Status, A = Arrival Circle Entered 14) Checksum
-    sprintf(p, ",,,,,,,,,,,%f,A", (double)val[NMEA_VMGWP].latest);
+    sprintf(p, ",,,,,,,,,,,%f,A", (double)state.latest[NMEA_VMGWP]);
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "ROT")) { //*****************************ROT
+  case nmeaKey("ROT"): { //**************************************************ROT
     // ROT Rate Of Turn
     //       1   2 3
     //       |   | |
@@ -372,8 +400,9 @@ char *INA::build(char *nmea, const char *thisSource,
     // 2) Status, A means data is valid
     // 3) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "RPM")) { //*****************************RPM
+  case nmeaKey("RPM"): { //**************************************************RPM
     // RPM Revolutions
     //       1 2 3   4   5 6
     //       | | |   |   | |
@@ -385,8 +414,9 @@ char *INA::build(char *nmea, const char *thisSource,
     // 5) Status, A means data is valid
     // 6) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "RSA")) { //*****************************RSA
+  case nmeaKey("RSA"): { //**************************************************RSA
     //  RSA Rudder Sensor Angle
     //       1   2 3   4 5
     //       |   | |   | |
@@ -397,8 +427,9 @@ char *INA::build(char *nmea, const char *thisSource,
     // 4) Status, A means data is valid
     // 5) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "TXT")) { //*****************************TXT
+  case nmeaKey("TXT"): { //**************************************************TXT
     // TXT Text Transmission
     //       1  2  3  4    5
     //       |  |  |  |    |
@@ -409,8 +440,10 @@ char *INA::build(char *nmea, const char *thisSource,
     // 4) Text String, max 61 characters
     // 5) Checksum
     sprintf(p, "01,01,23,This is the text of the sample message");
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "VDR")) { //*****************************VDR
+  case nmeaKey("VDR"): { //**************************************************VDR
     // VDR Set and Drift
     //       1   2 3   4 5   6 7
     //       |   | |   | |   | |
@@ -423,8 +456,9 @@ char *INA::build(char *nmea, const char *thisSource,
     // 6) N = Knots
     // 7) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "VHW")) { //*****************************VHW
+  case nmeaKey("VHW"): { //**************************************************VHW
     // VHW Water Speed and Heading
     //       1   2 3   4 5   6 7   8 9
     //       |   | |   | |   | |   | |
@@ -439,11 +473,13 @@ char *INA::build(char *nmea, const char *thisSource,
     // 7) Kilometers (speed of vessel relative to the water)
     // 8) K = Kilometres
     // 9) Checksum
-    sprintf(p, "%f,T,%f,M,%f,N,%f,K", (double)val[NMEA_HDT].latest,
-            (double)val[NMEA_HDG].latest, (double)val[NMEA_VTW].latest,
-            (double)val[NMEA_VTW].latest * 1.829);
+    sprintf(p, "%f,T,%f,M,%f,N,%f,K", (double)state.latest[NMEA_HDT],
+            (double)state.latest[NMEA_HDG], (double)state.latest[NMEA_VTW],
+            (double)state.latest[NMEA_VTW] * 1.829);
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "VLW")) { //*****************************VLW
+  case nmeaKey("VLW"): { //**************************************************VLW
     // VLW Distance Traveled through Water
     //       1   2 3   4 5
     //       |   | |   | |
@@ -456,8 +492,9 @@ char *INA::build(char *nmea, const char *thisSource,
     // 4) N = Nautical Miles
     // 5) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "VPW")) { //*****************************VPW
+  case nmeaKey("VPW"): { //**************************************************VPW
     // not supported by iNavX
     // VPW Speed – Measured Parallel to Wind
     //       1   2 3   4 5
@@ -468,9 +505,11 @@ char *INA::build(char *nmea, const char *thisSource,
     // 3) Speed, "-" means downwind
     // 4) M = Meters per second
     // 5) Checksum
-    sprintf(p, "%f,N,,", (double)val[NMEA_VMG].latest);
+    sprintf(p, "%f,N,,", (double)state.latest[NMEA_VMG]);
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "VTG")) { //*****************************VTG
+  case nmeaKey("VTG"): { //**************************************************VTG
     // VTG Track Made Good and Ground Speed
     //       1   2 3   4 5   6 7   8 9
     //       |   | |   | |   | |   | |
@@ -481,8 +520,9 @@ char *INA::build(char *nmea, const char *thisSource,
     // 7) Speed Kilometers Per Hour   8) K = Kilometres Per Hour
     // 9) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "VWR")) { //*****************************VWR
+  case nmeaKey("VWR"): { //**************************************************VWR
     // VWR Relative Wind Speed and Angle
     //       1   2 3   4 5   6 7   8 9
     //       |   | |   | |   | |   | |
@@ -499,16 +539,19 @@ char *INA::build(char *nmea, const char *thisSource,
     // 8) K = Kilometers Per Hour
     // 9) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "WCV")) { //*****************************WCV
+  case nmeaKey("WCV"): { //**************************************************WCV
     // WCV Waypoint Closure Velocity
     //       1   2 3    4
     //       |   | |    |
     //$--WCV,x.x,N,c--c*hh
     // 1) Velocity 2) N = knots 3) Waypoint ID 4) Checksum
-    sprintf(p, "%f,N,home", (double)val[NMEA_VMG].latest);
+    sprintf(p, "%f,N,home", (double)state.latest[NMEA_VMG]);
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "XTE")) { //*****************************XTE
+  case nmeaKey("XTE"): { //**************************************************XTE
     // XTE Cross-Track Error – Measured
     //       1 2 3   4 5  6
     //       | | |   | |  |
@@ -525,8 +568,9 @@ char *INA::build(char *nmea, const char *thisSource,
     // 5) Cross track units. N = Nautical Miles
     // 6) Checksum
     return NULL;
+  }
 
-  } else if (!strcmp(thisSentence, "ZDA")) { //*****************************ZDA
+  case nmeaKey("ZDA"): { //**************************************************ZDA
     // ZDA Time & Date – UTC, Day, Month, Year and Local Time Zone
     //       1         2  3  4    5  6  7
     //       |         |  |  |    |  |  |
@@ -539,8 +583,9 @@ char *INA::build(char *nmea, const char *thisSource,
     // 6) Time (UTC)
     // 7) Checksum
     return NULL;
+  }
 
-  } else {
+  default:
     return NULL; // didn't find a match for the build request
   }
 
@@ -564,7 +609,7 @@ char *INA::build(char *nmea, const char *thisSource,
     @return none
 */
 /**************************************************************************/
-void INA::addChecksum(char *buff) {
+void INA_Core::addChecksum(char *buff) {
   char cs = 0;
   int i = 1;
   while (buff[i]) {
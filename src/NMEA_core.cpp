@@ -0,0 +1,611 @@
+/**************************************************************************/
+/*!
+  @file NMEA_core.cpp
+*/
+/**************************************************************************/
+
+#include "NMEA_core.h"
+
+namespace nmea {
+
+/**************************************************************************/
+/*!
+    @brief Decode one GPS sentence into a record the caller owns, without
+    touching any shared state, so any number of streams or threads can
+    decode at once. GGA, RMC, GLL, GSA, GSV and ZDA are decoded from any
+    two letter talker, see decode(). The groups of fields the sentence
+    carries are copied into out and flagged in out.have, as is each field
+    that can be empty within a group; the rest of out is left alone, so the sentences of one epoch can be gathered into the same
+    record. Start each epoch with a fresh nmea_fix_t.
+    @param begin Pointer to the $ that starts the sentence
+    @param end One past the last character of the sentence, or NULL if it
+    is 0 terminated. Anything from a CR or LF on is ignored.
+    @param out The record to fill
+    @return True if the checksum was good and the sentence is one of those
+    decoded, false otherwise
+*/
+/**************************************************************************/
+bool parse(const char *begin, const char *end, nmea_fix_t &out) {
+  nmea_fields_t f;
+  if (!split(begin, end, f))
+    return false;
+  // the sentence id is the last three letters of a two letter talker's id
+  if (f.n < 2 || f.start[1] != 7)
+    return false;
+  return decode(nmeaKey(begin + 3), f, out);
+}
+
+/**************************************************************************/
+/*!
+    @brief Decode the fields of a GPS sentence that split() has checked.
+    This is the one place the GPS sentences are decoded: parse() calls it
+    for a line, and INA_Core::parse() for the sentence it has checked or
+    streamed in, whatever its talker.
+    @param key The sentence id packed with nmeaKey()
+    @param f The fields of the sentence
+    @param out The record to fill, as for parse()
+    @return True if the sentence is one of those decoded
+*/
+/**************************************************************************/
+bool decode(uint32_t key, const nmea_fields_t &f, nmea_fix_t &out) {
+  const char *p;
+  switch (key) {
+  case nmeaKey("GGA"): { //**************************************************GGA
+    parseTime(field(f, 1), out);
+    int32_t lat, lon;
+    if (parseCoord(field(f, 2), field(f, 3), &lat) &&
+        parseCoord(field(f, 4), field(f, 5), &lon)) {
+      out.latitude_fixed = lat;
+      out.longitude_fixed = lon;
+      out.have |= NMEA_FIX_POSITION;
+    }
+    if (!isEmpty(p = field(f, 6))) {
+      out.fixquality = parseInt(p);
+      out.fix = out.fixquality > 0;
+      out.have |= NMEA_FIX_STATUS | NMEA_FIX_QUALITY;
+    }
+    if (!isEmpty(p = field(f, 7))) {
+      out.satellites = parseInt(p);
+      out.have |= NMEA_FIX_SATS;
+    }
+    if (!isEmpty(p = field(f, 8))) {
+      out.HDOP = parseFloat(p);
+      out.have |= NMEA_FIX_HDOP;
+    }
+    if (!isEmpty(p = field(f, 9)) && parseFixed(p, 1, &out.altitude_fixed)) {
+      if (!isEmpty(p = field(f, 11)) &&
+          parseFixed(p, 1, &out.geoidheight_fixed))
+        out.have |= NMEA_FIX_GEOID;
+      out.have |= NMEA_FIX_ALTITUDE;
+    }
+    return true;
+  }
+
+  case nmeaKey("RMC"): { //**************************************************RMC
+    parseTime(field(f, 1), out);
+    if (*(p = field(f, 2)) == 'A' || *p == 'V') {
+      out.fix = (*p == 'A');
+      out.have |= NMEA_FIX_STATUS;
+    }
+    int32_t lat, lon;
+    if (parseCoord(field(f, 3), field(f, 4), &lat) &&
+        parseCoord(field(f, 5), field(f, 6), &lon)) {
+      out.latitude_fixed = lat;
+      out.longitude_fixed = lon;
+      out.have |= NMEA_FIX_POSITION;
+    }
+    if (!isEmpty(p = field(f, 8)) && parseFixed(p, 2, &out.angle_fixed))
+      out.have |= NMEA_FIX_COURSE;
+    if (!isEmpty(p = field(f, 7)) && parseFixed(p, 3, &out.speed_fixed))
+      out.have |= NMEA_FIX_VELOCITY;
+    if (!isEmpty(p = field(f, 9))) {
+      uint32_t fulldate = parseInt(p);
+      out.day = fulldate / 10000;
+      out.month = (fulldate % 10000) / 100;
+      out.year = (fulldate % 100);
+      out.have |= NMEA_FIX_DATE;
+    }
+    return true;
+  }
+
+  case nmeaKey("GLL"): { //**************************************************GLL
+    parseTime(field(f, 5), out);
+    int32_t lat, lon;
+    if (parseCoord(field(f, 1), field(f, 2), &lat) &&
+        parseCoord(field(f, 3), field(f, 4), &lon)) {
+      out.latitude_fixed = lat;
+      out.longitude_fixed = lon;
+      out.have |= NMEA_FIX_POSITION;
+    }
+    if (*(p = field(f, 6)) == 'A' || *p == 'V') {
+      out.fix = (*p == 'A');
+      out.have |= NMEA_FIX_STATUS;
+    }
+    return true;
+  }
+
+  case nmeaKey("GSA"): { //**************************************************GSA
+    if (!isEmpty(p = field(f, 15))) {
+      out.PDOP = parseFloat(p);
+      out.have |= NMEA_FIX_PDOP;
+    }
+    if (!isEmpty(p = field(f, 16))) {
+      out.HDOP = parseFloat(p);
+      out.have |= NMEA_FIX_HDOP;
+    }
+    if (!isEmpty(p = field(f, 17))) {
+      out.VDOP = parseFloat(p);
+      out.have |= NMEA_FIX_VDOP;
+    }
+    if (!isEmpty(p = field(f, 2))) {
+      out.fixquality_3d = parseInt(p);
+      out.have |= NMEA_FIX_DOP;
+    }
+    return true;
+  }
+
+  case nmeaKey("GSV"): { //**************************************************GSV
+    if (!isEmpty(p = field(f, 3))) {
+      out.satellitesInView = parseInt(p);
+      out.have |= NMEA_FIX_INVIEW;
+    }
+    return true;
+  }
+
+  case nmeaKey("ZDA"): { //**************************************************ZDA
+    parseTime(field(f, 1), out);
+    if (!isEmpty(field(f, 2)) && !isEmpty(field(f, 3)) &&
+        !isEmpty(p = field(f, 4))) {
+      out.day = parseInt(field(f, 2));
+      out.month = parseInt(field(f, 3));
+      out.year = parseInt(p) % 100;
+      out.have |= NMEA_FIX_DATE;
+    }
+    return true;
+  }
+
+  default:
+    return false;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief Verify the checksum of a sentence and record where each of its
+    fields starts, in one pass. Every * but the last is treated as data.
+    @param begin Pointer to the $ or ! that starts the sentence
+    @param end One past the last character of the sentence, or NULL if it
+    is 0 terminated. The sentence also ends at a CR or LF.
+    @param fields The table to fill. Its n is only set if the sentence is
+    good, and fields beyond NMEA_MAX_FIELDS or 255 characters read empty.
+    @return True if the sentence starts right, is printable and has a good
+    checksum
+*/
+/**************************************************************************/
+bool split(const char *begin, const char *end, nmea_fields_t &fields) {
+  fields.base = begin;
+  fields.n = 0;
+  if (begin == end || (*begin != '$' && *begin != '!'))
+    return false; // doesn't start with $ or !
+  // remember the sum and field count at each *, so that all but the last *
+  // are treated as data
+  uint8_t sum = 0, sumAtAst = 0;
+  uint8_t n = 1, nAtAst = 0;
+  fields.start[0] = 1;
+  const char *ast = NULL;
+  const char *p = begin + 1;
+  for (; p != end && *p && *p != '\r' && *p != '\n'; p++) {
+    if (*p < ' ' || *p > '~')
+      return false; // not printable, so not NMEA
+    if (*p == '*') {
+      ast = p;
+      sumAtAst = sum;
+      nAtAst = n;
+    } else if (*p == ',' && n < NMEA_MAX_FIELDS && p + 1 - begin <= 255)
+      fields.start[n++] = p + 1 - begin; // fields beyond the table read empty
+    sum ^= *p;
+  }
+  if (ast == NULL || p - ast < 3)
+    return false; // there is no asterisk, or no room for the checksum
+  if (!isxdigit(ast[1]) || !isxdigit(ast[2]))
+    return false; // checksum is not two hex digits
+  if (sumAtAst != parseHex(ast[1]) * 16 + parseHex(ast[2]))
+    return false; // bad checksum :(
+  fields.n = nAtAst;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Find a field of a sentence from the offsets split() recorded,
+    without walking the sentence.
+    @param fields The table split() filled
+    @param i Index of the field, 1 for the first field after the sentence id
+    @return Pointer to the start of the field, or to an empty field if the
+    sentence does not have that many
+*/
+/**************************************************************************/
+const char *field(const nmea_fields_t &fields, uint8_t i) {
+  if (i >= fields.n)
+    return "*"; // reads as an empty field to isEmpty()
+  return fields.base + fields.start[i];
+}
+
+/**************************************************************************/
+/*!
+    @brief Parse a lat or lon angle and its direction, in either DDMM.mmmm,N
+    (latitude) or DDDMM.mmmm,W (longitude) format, into fixed point decimal
+    degrees with exact integer math. Insensitive to number of decimal places
+    present. Only fills the variables if it succeeds and the variable
+    pointer is not NULL. Rejects more than 4 digits of degrees and minutes
+    for a latitude or 5 for a longitude, and angles past 90 or 180 degrees.
+    @param p Pointer to the location of the angle in the NMEA string
+    @param pDir Pointer to the location of the direction token that follows
+    @param angle_fixed Pointer to fill with the angle in decimal degrees *
+    10000000, signed
+    @param dir Pointer to fill with the direction N/S/E/W
+    @return true if successful, false if failed or no value
+*/
+/**************************************************************************/
+bool parseCoord(const char *p, const char *pDir, int32_t *angle_fixed,
+                char *dir) {
+  if (isEmpty(p) || isEmpty(pDir))
+    return false; // no number or no direction
+  char nsew = *pDir;
+  bool isLat = (nsew == 'N' || nsew == 'S');
+  if (!isLat && nsew != 'E' && nsew != 'W')
+    return false; // not a direction
+  const char *pStart = p;
+  // get the number in DDMM.mmmm or DDDMM.mmmm format and break into integer
+  // components, keeping up to 6 decimal places of the minutes
+  uint32_t dddmm = 0;
+  for (; *p >= '0' && *p <= '9'; p++)
+    dddmm = dddmm * 10 + (*p - '0');
+  if (*p != '.' || p - pStart > (isLat ? 4 : 5))
+    return false;                 // no decimal point in range
+  uint32_t degrees = dddmm / 100; // truncate the minutes
+  uint32_t minutes = dddmm % 100; // remove the degrees
+  if (degrees > (isLat ? 90u : 180u))
+    return false; // out of range, and would overflow below
+  uint32_t microminutes = 0; // the fraction after the decimal point
+  for (uint32_t place = 100000; *++p >= '0' && *p <= '9'; place /= 10)
+    microminutes += (*p - '0') * place; // digits past 6 fall off at place 0
+
+  // 1e7 degrees per 60e6 microminutes makes the fixed point value exact
+  uint32_t fixed = degrees * 10000000 + (minutes * 1000000 + microminutes) / 6;
+  if (fixed > (isLat ? 900000000u : 1800000000u))
+    return false; // past the pole or the date line
+
+  if (angle_fixed != NULL) // signed, but DDDMM.mmmm is not
+    *angle_fixed = (nsew == 'S' || nsew == 'W') ? -(int32_t)fixed : fixed;
+  if (dir != NULL)
+    *dir = nsew;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Parse a time field in hhmmss format, with any number of decimal
+    places after the '.'
+    @param p Pointer to the location of the token in the NMEA string
+    @param out The record to put the time in, flagged NMEA_FIX_TIME
+    @return true if successful, false otherwise
+*/
+/**************************************************************************/
+bool parseTime(const char *p, nmea_fix_t &out) {
+  int32_t time; // hhmmss in milliseconds
+  if (isEmpty(p) || !parseFixed(p, 3, &time) || time < 0)
+    return false;
+  out.hour = time / 10000000;
+  out.minute = (time % 10000000) / 100000;
+  out.seconds = (time % 100000) / 1000;
+  out.milliseconds = time % 1000;
+  out.have |= NMEA_FIX_TIME;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Count the days from 1970-01-01 to a date, for epoch times
+    @param year Full year, 1970 or later
+    @param month Month, 1 to 12
+    @param day Day of the month
+    @return Days since 1970-01-01
+*/
+/**************************************************************************/
+uint32_t daysFromCivil(uint16_t year, uint8_t month, uint8_t day) {
+  // years counted from March, so the leap day is the last of the year
+  uint32_t y = year - (month <= 2);
+  uint32_t era = y / 400;
+  uint32_t yoe = y - era * 400;
+  uint32_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+/**************************************************************************/
+/*!
+    @brief The date of a day counted from 1970-01-01, the inverse of
+    daysFromCivil()
+    @param days Days since 1970-01-01
+    @param year Set to the full year
+    @param month Set to the month, 1 to 12
+    @param day Set to the day of the month
+*/
+/**************************************************************************/
+static void civilFromDays(uint32_t days, uint16_t &year, uint8_t &month,
+                          uint8_t &day) {
+  uint32_t z = days + 719468;
+  uint32_t era = z / 146097;
+  uint32_t doe = z - era * 146097;
+  uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  uint32_t mp = (5 * doy + 2) / 153;
+  day = doy - (153 * mp + 2) / 5 + 1;
+  month = mp < 10 ? mp + 3 : mp - 9;
+  year = yoe + era * 400 + (month <= 2);
+}
+
+/**************************************************************************/
+/*!
+    @brief The UTC time of a record as milliseconds since 1970-01-01, from
+    its time and, if it has one, its date
+    @param f The record
+    @return Milliseconds since the epoch, or since midnight if f has no
+    date, so a result under a day means the date was unknown
+*/
+/**************************************************************************/
+uint64_t epochMillis(const nmea_fix_t &f) {
+  uint32_t days = 0;
+  if ((f.have & NMEA_FIX_DATE) && f.month >= 1 && f.month <= 12)
+    days = daysFromCivil(2000 + f.year, f.month, f.day);
+  uint32_t ms = ((f.hour * 60 + f.minute) * 60 + f.seconds) * 1000UL +
+                f.milliseconds;
+  return (uint64_t)days * 86400000ULL + ms;
+}
+
+/**************************************************************************/
+/*!
+    @brief Fill the time and date of a record from milliseconds since
+    1970-01-01, the inverse of epochMillis()
+    @param ms Milliseconds since the epoch, or since midnight for a time
+    without a date
+    @param out The record, flagged NMEA_FIX_TIME, and NMEA_FIX_DATE if ms
+    is a day or more
+*/
+/**************************************************************************/
+void fromEpochMillis(uint64_t ms, nmea_fix_t &out) {
+  uint32_t days = ms / 86400000ULL;
+  uint32_t t = ms % 86400000ULL;
+  out.hour = t / 3600000;
+  out.minute = (t / 60000) % 60;
+  out.seconds = (t / 1000) % 60;
+  out.milliseconds = t % 1000;
+  out.have |= NMEA_FIX_TIME;
+  if (days == 0)
+    return;
+  uint16_t year;
+  civilFromDays(days, year, out.month, out.day);
+  out.year = year % 100;
+  out.have |= NMEA_FIX_DATE;
+}
+
+/// "00" to "99", so two digits are written with one division
+static const char digitPairs[] = "00010203040506070809"
+                                 "10111213141516171819"
+                                 "20212223242526272829"
+                                 "30313233343536373839"
+                                 "40414243444546474849"
+                                 "50515253545556575859"
+                                 "60616263646566676869"
+                                 "70717273747576777879"
+                                 "80818283848586878889"
+                                 "90919293949596979899";
+
+/**************************************************************************/
+/*!
+    @brief Write two digits of a number under 100
+    @param p Where to write them
+    @param v The number
+*/
+/**************************************************************************/
+static inline void putPair(char *p, uint8_t v) {
+  memcpy(p, digitPairs + 2 * v, 2);
+}
+
+/**************************************************************************/
+/*!
+    @brief Write an epoch time in ISO 8601, as YYYY-MM-DDTHH:MM:SS.mmmZ,
+    without sprintf(). The date part only changes once a day, so with a
+    cache it is copied rather than worked out again. A time without a date
+    is written as on 2000-00-00, as the sprintf() this replaces did.
+    @param ms Milliseconds since 1970-01-01, e.g. from epochMillis(), or
+    since midnight if the date is not known
+    @param out Where to write, at least NMEA_ISO_TIME_SIZE bytes
+    @param cache The last date written, or NULL to work it out every time
+    @return Length of the text, NMEA_ISO_TIME_SIZE - 1
+*/
+/**************************************************************************/
+size_t isoTime(uint64_t ms, char *out, nmea_iso_date_t *cache) {
+  uint32_t days = ms / 86400000ULL;
+  uint32_t t = ms % 86400000ULL;
+  if (cache != NULL && cache->day == days) {
+    memcpy(out, cache->text, sizeof(cache->text));
+  } else if (days == 0) {
+    memcpy(out, "2000-00-00T", 11); // no date yet
+  } else {
+    uint16_t year;
+    uint8_t month, day;
+    civilFromDays(days, year, month, day);
+    putPair(out, (year / 100) % 100);
+    putPair(out + 2, year % 100);
+    out[4] = '-';
+    putPair(out + 5, month);
+    out[7] = '-';
+    putPair(out + 8, day);
+    out[10] = 'T';
+    if (cache != NULL) {
+      memcpy(cache->text, out, sizeof(cache->text));
+      cache->day = days;
+    }
+  }
+  uint16_t milli = t % 1000;
+  t /= 1000;
+  putPair(out + 11, t / 3600);
+  out[13] = ':';
+  putPair(out + 14, (t / 60) % 60);
+  out[16] = ':';
+  putPair(out + 17, t % 60);
+  out[19] = '.';
+  out[20] = '0' + milli / 100;
+  putPair(out + 21, milli % 100);
+  out[23] = 'Z';
+  out[24] = 0;
+  return NMEA_ISO_TIME_SIZE - 1;
+}
+
+/**************************************************************************/
+/*!
+    @brief Read the decimal number at the start of an NMEA field as an
+    unsigned integer of its digits and the number of those digits that follow
+    the decimal point, like 12.34 as 1234 and 2. Reads at most 9 significant
+    digits, and drops any further decimal places, so it is exact for every
+    value NMEA-183 sends. Never calls atof() or allocates.
+    @param p Pointer to the location of the token in the NMEA string
+    @param digits Filled with the digits as an integer
+    @param places Filled with the number of decimal places in digits
+    @param negative Filled with true if the number has a leading minus sign
+    @return True if the field is a plain decimal number, false otherwise
+*/
+/**************************************************************************/
+bool scanDecimal(const char *p, uint32_t *digits, uint8_t *places,
+                 bool *negative) {
+  *digits = 0;
+  *places = 0;
+  *negative = (*p == '-');
+  if (*p == '-' || *p == '+')
+    p++;
+  bool any = false, point = false;
+  for (;; p++) {
+    if (*p >= '0' && *p <= '9') {
+      any = true;
+      if (*digits > 99999999) { // a tenth digit would not fit
+        if (!point)
+          return false; // too big to be NMEA
+        continue;       // drop the excess precision
+      }
+      *digits = *digits * 10 + (*p - '0');
+      if (point)
+        (*places)++;
+    } else if (*p == '.' && !point)
+      point = true;
+    else
+      break;
+  }
+  if (!any)
+    return false;
+  return (*p == ',' || *p == '*' || *p == 0 || *p == '\r' || *p == '\n');
+}
+
+static const uint32_t pow10s[10] = {
+    1,      10,      100,      1000,      10000,
+    100000, 1000000, 10000000, 100000000, 1000000000}; ///< for scaling digits
+
+/**************************************************************************/
+/*!
+    @brief Parse a decimal field straight into a scaled integer, e.g. with 2
+    decimals 12.345 becomes 1234. Extra decimal places are truncated toward
+    zero, the same way the fixed point latitude and longitude are.
+    @param p Pointer to the location of the token in the NMEA string
+    @param decimals Number of decimal places to keep, 0 to 9
+    @param value Pointer to fill with the scaled integer, only on success
+    @return True if the field was a number that fits, false otherwise
+*/
+/**************************************************************************/
+bool parseFixed(const char *p, uint8_t decimals, int32_t *value) {
+  uint32_t digits;
+  uint8_t places;
+  bool negative;
+  if (decimals > 9 || !scanDecimal(p, &digits, &places, &negative))
+    return false;
+  uint64_t scaled = digits;
+  if (places > decimals)
+    scaled /= pow10s[places - decimals];
+  else
+    scaled *= pow10s[decimals - places];
+  if (scaled > INT32_MAX)
+    return false;
+  *value = negative ? -(int32_t)scaled : (int32_t)scaled;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Parse a decimal field into a float with a single rounding, as a
+    stand-in for atof() that is several times faster.
+    @param p Pointer to the location of the token in the NMEA string
+    @return The value, or 0 if the field is not a number
+*/
+/**************************************************************************/
+nmea_float_t parseFloat(const char *p) {
+  uint32_t digits;
+  uint8_t places;
+  bool negative;
+  if (!scanDecimal(p, &digits, &places, &negative))
+    return 0;
+  nmea_float_t value = (nmea_float_t)digits / (nmea_float_t)pow10s[places];
+  return negative ? -value : value;
+}
+
+/**************************************************************************/
+/*!
+    @brief Parse the integer part of a decimal field, as a stand-in for
+    atoi().
+    @param p Pointer to the location of the token in the NMEA string
+    @return The value, or 0 if the field is not a number
+*/
+/**************************************************************************/
+int32_t parseInt(const char *p) {
+  int32_t value = 0;
+  parseFixed(p, 0, &value);
+  return value;
+}
+
+/**************************************************************************/
+/*!
+    @brief Is the field empty, or should we try conversion? Won't work
+    for a text field that starts with an asterisk or a comma, but that
+    probably violates the NMEA-183 standard.
+    @param pStart Pointer to the location of the token in the NMEA string
+    @return true if empty field, false if something there
+*/
+/**************************************************************************/
+bool isEmpty(const char *pStart) {
+  if (',' != *pStart && '*' != *pStart && pStart != NULL)
+    return false;
+  else
+    return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Parse a hex character and return the appropriate decimal value
+    @param c Hex character, e.g. '0' or 'B'
+    @return Integer value of the hex character. Returns 0 if c is not a proper
+   character
+*/
+/**************************************************************************/
+uint8_t parseHex(char c) {
+  if (c < '0')
+    return 0;
+  if (c <= '9')
+    return c - '0';
+  if (c < 'A')
+    return 0;
+  if (c <= 'F')
+    return (c - 'A') + 10;
+  // if (c > 'F')
+  return 0;
+}
+
+} // namespace nmea
@@ -0,0 +1,151 @@
+/**************************************************************************/
+/*!
+  @file NMEA_core.h
+
+  The stateless core of the NMEA parser: checksum and field splitting,
+  number and coordinate decoding, and nmea::parse(), which decodes the GPS
+  sentences into a record the caller owns. Nothing in it keeps state
+  between calls, so several streams can be decoded at once, from as many
+  threads as needed. INA_Core wraps it for its own line buffers and
+  variables.
+*/
+/**************************************************************************/
+#ifndef _NMEA_CORE_H
+#define _NMEA_CORE_H
+#include "Arduino.h"
+#include "NMEA_data.h"
+
+#define NMEA_MAX_FIELDS                                                        \
+  32 ///< fields check() indexes in one sentence, including the id
+
+/**************************************************************************/
+/*!
+    Offsets of the comma separated fields of a sentence, filled in the same
+    pass that verifies the checksum. Field 0 is the talker and sentence id,
+    field 1 the first value after it. Only the fields before the checksum
+    are counted.
+*/
+/**************************************************************************/
+typedef struct {
+  const char *base = NULL;        ///< the sentence the offsets refer to
+  uint8_t n = 0;                  ///< number of fields indexed
+  uint8_t start[NMEA_MAX_FIELDS]; ///< offset of each field from base
+} nmea_fields_t;
+
+/// bits of nmea_fix_t::have, one for each group of fields an epoch can fill,
+/// and one for each field within a group that a GPS may leave empty
+typedef enum {
+  NMEA_FIX_TIME = 1,      ///< hour, minute, seconds, milliseconds
+  NMEA_FIX_DATE = 2,      ///< year, month, day from RMC or ZDA
+  NMEA_FIX_STATUS = 4,    ///< fix from GGA, RMC or GLL
+  NMEA_FIX_POSITION = 8,  ///< latitude_fixed, longitude_fixed
+  NMEA_FIX_ALTITUDE = 16, ///< altitude_fixed, geoidheight_fixed from GGA
+  NMEA_FIX_VELOCITY = 32, ///< speed_fixed, angle_fixed from RMC
+  NMEA_FIX_QUALITY = 64,  ///< fixquality, satellites, HDOP from GGA
+  NMEA_FIX_DOP = 128,     ///< fixquality_3d, HDOP, VDOP, PDOP from GSA
+  NMEA_FIX_INVIEW = 256,  ///< satellitesInView from GSV
+  NMEA_FIX_COURSE = 512,  ///< angle_fixed, empty in RMC when stationary
+  NMEA_FIX_GEOID = 1024,  ///< geoidheight_fixed from GGA
+  NMEA_FIX_HDOP = 2048,   ///< HDOP from GGA or GSA
+  NMEA_FIX_PDOP = 4096,   ///< PDOP from GSA
+  NMEA_FIX_VDOP = 8192,   ///< VDOP from GSA
+  NMEA_FIX_SATS = 16384   ///< satellites from GGA
+} nmea_fix_fields_t;
+
+#define NMEA_FIX_PRESENT                                                       \
+  (NMEA_FIX_COURSE | NMEA_FIX_GEOID | NMEA_FIX_HDOP | NMEA_FIX_PDOP |          \
+   NMEA_FIX_VDOP | NMEA_FIX_SATS) ///< the single field bits, not groups
+
+#define NMEA_FIX_DEFAULT                                                       \
+  (NMEA_FIX_TIME | NMEA_FIX_DATE | NMEA_FIX_STATUS | NMEA_FIX_POSITION |       \
+   NMEA_FIX_ALTITUDE | NMEA_FIX_VELOCITY |                                     \
+   NMEA_FIX_QUALITY) ///< what RMC and GGA give, as begin() asks for
+
+/**************************************************************************/
+/*!
+    Everything the GPS reported for one UTC time, gathered from all the
+    sentences that carried that time or followed it. Published once per
+    epoch by the epoch assembler, so the fields never mix two epochs, and
+    filled by nmea::parse(). Only the groups flagged in have were sent, the
+    rest are 0. A published epoch only flags groups, and holds the last value
+    sent for a field the GPS left empty; nmea::parse() also flags each such
+    field it found, leaving out the ones that were empty.
+*/
+/**************************************************************************/
+typedef struct {
+  uint16_t have = 0;             ///< nmea_fix_fields_t bits filled in
+  uint8_t year = 0;              ///< GMT year
+  uint8_t month = 0;             ///< GMT month
+  uint8_t day = 0;               ///< GMT day
+  uint8_t hour = 0;              ///< GMT hours
+  uint8_t minute = 0;            ///< GMT minutes
+  uint8_t seconds = 0;           ///< GMT seconds
+  uint16_t milliseconds = 0;     ///< GMT milliseconds
+  int32_t latitude_fixed = 0;    ///< latitude in degrees * 10000000
+  int32_t longitude_fixed = 0;   ///< longitude in degrees * 10000000
+  int32_t altitude_fixed = 0;    ///< altitude in decimetres above MSL
+  int32_t geoidheight_fixed = 0; ///< geoid height in decimetres
+  int32_t speed_fixed = 0;       ///< speed in thousandths of a knot
+  int32_t angle_fixed = 0;       ///< course in hundredths of a degree
+  nmea_float_t HDOP = 0;         ///< Horizontal Dilution of Precision
+  nmea_float_t VDOP = 0;         ///< Vertical Dilution of Precision
+  nmea_float_t PDOP = 0;         ///< Position Dilution of Precision
+  bool fix = false;              ///< Have a fix?
+  uint8_t fixquality = 0;    ///< Fix quality (0, 1, 2 = Invalid, GPS, DGPS)
+  uint8_t fixquality_3d = 0; ///< 3D fix quality (1, 3, 3 = Nofix, 2D, 3D)
+  uint8_t satellites = 0;    ///< Number of satellites in use
+  uint8_t satellitesInView = 0; ///< Number of satellites in view
+} nmea_fix_t;
+
+/**************************************************************************/
+/*!
+    @brief Pack a three letter sentence id like "GGA" into an integer key, so
+    sentences can be dispatched with a switch instead of a chain of strcmp().
+    It is constexpr, so nmeaKey("GGA") can be used as a case label.
+    @param id Pointer to the first of the three letters
+    @return The packed key
+*/
+/**************************************************************************/
+constexpr uint32_t nmeaKey(const char *id) {
+  return ((uint32_t)(uint8_t)id[0] << 16) | ((uint32_t)(uint8_t)id[1] << 8) |
+         (uint32_t)(uint8_t)id[2];
+}
+
+#define NMEA_ISO_TIME_SIZE                                                     \
+  25 ///< bytes isoTime() writes, "YYYY-MM-DDTHH:MM:SS.mmmZ" and its 0
+
+/**************************************************************************/
+/*!
+    The date part of the last time isoTime() wrote, so the next time on the
+    same day only needs its time worked out. Keep one per thread.
+*/
+/**************************************************************************/
+typedef struct {
+  uint32_t day = 0xFFFFFFFF; ///< days since 1970-01-01 text is for
+  char text[11];             ///< "YYYY-MM-DDT", not 0 terminated
+} nmea_iso_date_t;
+
+namespace nmea {
+
+bool parse(const char *begin, const char *end, nmea_fix_t &out);
+bool decode(uint32_t key, const nmea_fields_t &f, nmea_fix_t &out);
+bool split(const char *begin, const char *end, nmea_fields_t &fields);
+const char *field(const nmea_fields_t &fields, uint8_t i);
+bool parseCoord(const char *p, const char *pDir, int32_t *angle_fixed,
+                char *dir = NULL);
+bool parseTime(const char *p, nmea_fix_t &out);
+uint32_t daysFromCivil(uint16_t year, uint8_t month, uint8_t day);
+uint64_t epochMillis(const nmea_fix_t &f);
+void fromEpochMillis(uint64_t ms, nmea_fix_t &out);
+size_t isoTime(uint64_t ms, char *out, nmea_iso_date_t *cache = NULL);
+bool scanDecimal(const char *p, uint32_t *digits, uint8_t *places,
+                 bool *negative);
+bool parseFixed(const char *p, uint8_t decimals, int32_t *value);
+nmea_float_t parseFloat(const char *p);
+int32_t parseInt(const char *p);
+bool isEmpty(const char *p);
+uint8_t parseHex(char c);
+
+} // namespace nmea
+
+#endif // _NMEA_CORE_H
@@ -6,6 +6,38 @@
 
 #include "INA.h"
 
+#ifdef NMEA_EXTENSIONS
+/**************************************************************************/
+/*!
+    @brief Sine and cosine for the components of compound angles. Define
+    NMEA_FAST_TRIG to use a polynomial good to about 0.001 instead of the
+    library functions, which is plenty for smoothing and much quicker on
+    chips without a floating point unit.
+    @param x The angle in radians
+    @return The sine or cosine of x
+*/
+/**************************************************************************/
+#ifdef NMEA_FAST_TRIG
+static nmea_float_t nmeaSin(nmea_float_t x) {
+  const nmea_float_t pi = (nmea_float_t)PI;
+  while (x > pi)
+    x -= 2 * pi;
+  while (x < -pi)
+    x += 2 * pi;
+  // parabola through 0 and +/- pi, then squared up to cut the error
+  nmea_float_t y = (4 / pi) * x - (4 / (pi * pi)) * x * fabs(x);
+  y += (nmea_float_t)0.225 * (y * fabs(y) - y);
+  return constrain(y, (nmea_float_t)-1.0, (nmea_float_t)1.0); // for asin()
+}
+static nmea_float_t nmeaCos(nmea_float_t x) {
+  return nmeaSin(x + (nmea_float_t)HALF_PI);
+}
+#else
+static nmea_float_t nmeaSin(nmea_float_t x) { return sin(x); }
+static nmea_float_t nmeaCos(nmea_float_t x) { return cos(x); }
+#endif
+#endif // NMEA_EXTENSIONS
+
 /**************************************************************************/
 /*!
     @brief Update the value and history information with a new value. Call
@@ -16,270 +48,261 @@
     @return none
 */
 /**************************************************************************/
-void INA::newDataValue(nmea_index_t idx, nmea_float_t v) {
+void INA_Core::newDataValue(nmea_index_t idx, nmea_float_t v) {
+#ifdef NMEA_EXTENSIONS
+  updateDataValue(idx, v, millis());
+#endif // NMEA_EXTENSIONS
+}
+
 #ifdef NMEA_EXTENSIONS
+/**************************************************************************/
+/*!
+    @brief The body of newDataValue(), with the time stamp taken once by
+    the caller.
+    @param idx The data index for which a new value has been received
+    @param v The new value received
+    @param now millis() when it was received
+    @return none
+*/
+/**************************************************************************/
+void INA_Core::updateDataValue(nmea_index_t idx, nmea_float_t v,
+                               uint32_t now) {
   //  Serial.println();Serial.print(idx);Serial.print(", "); Serial.println(v);
-  val[idx].latest = v; // update the value
+  if (lazySmoothing && state.lastUpdate[idx] != 0)
+    smoothDataValue(idx, now); // the old value held until now counts first
+  state.latest[idx] = v;       // update the value
+  state.lastUpdate[idx] = now; // take a time stamp
+  if (!lazySmoothing)
+    smoothDataValue(idx, now); // update the smoothed verion
+  if (meta[idx].stats)
+    statsAdd(meta[idx].stats, v);
+  if (meta[idx].sub)
+    dispatch(idx, v, now);
 
-  // update the smoothed verion
+  if (meta[idx].hist) { // there's a history struct for this tag
+    nmea_history_t *h = meta[idx].hist;
+    unsigned long seconds = (now - h->lastHistory) / 1000;
+    // do an update if the time has come, or if this is the first time through
+    if (seconds >= h->historyInterval || h->lastHistory == 0) {
+      if (lazySmoothing)
+        smoothDataValue(idx, now);
+      // Create the new entry over the oldest one, scaling and offsetting the
+      // value to fit into an integer, and based on the smoothed value.
+      h->data[h->head] = h->scale * (state.smoothed[idx] - h->offset);
+      if (++h->head == h->n)
+        h->head = 0;
+      if (h->count < h->n)
+        h->count++;
+      h->lastHistory = now;
+      if (h->nTiers > 0) {
+        int16_t v = h->data[h->head == 0 ? h->n - 1 : h->head - 1];
+        historyRollup(h, 0, {v, v, v});
+      }
+    }
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief Bring the smoothed value of a data value up to a time, along with
+    the sine and cosine components of a compound angle.
+
+    Straight after every update the weight of the latest value is
+    dt / tau, as it has always been. With setLazySmoothing() each value is
+    taken to hold from its update until the next one, and the smoothing is
+    done in closed form with a weight of 1 - exp(-dt / tau): an update first
+    brings the old value up to its own time, and a read brings the newest
+    one up to the time of the read. Every value then counts for just the
+    time it held, so the result does not depend on how often it is read.
+    @param idx The data index of the value
+    @param now millis() to bring it up to
+    @return none
+*/
+/**************************************************************************/
+void INA_Core::smoothDataValue(nmea_index_t idx, uint32_t now) {
   if (isCompoundAngle(idx)) { // angle with sin/cos component recording
-    newDataValue((nmea_index_t)(idx + 1), sin(v / (nmea_float_t)RAD_TO_DEG));
-    newDataValue((nmea_index_t)(idx + 2), cos(v / (nmea_float_t)RAD_TO_DEG));
+    nmea_float_t rad = state.latest[idx] / (nmea_float_t)RAD_TO_DEG;
+    state.latest[idx + 1] = nmeaSin(rad);
+    state.latest[idx + 2] = nmeaCos(rad);
+    state.lastUpdate[idx + 1] = state.lastUpdate[idx + 2] =
+        state.lastUpdate[idx];
+    smoothDataValue((nmea_index_t)(idx + 1), now);
+    smoothDataValue((nmea_index_t)(idx + 2), now);
   }
   // weighting factor for smoothing depends on delta t / tau
-  nmea_float_t w =
-      min((nmea_float_t)1.0,
-          (nmea_float_t)(millis() - val[idx].lastUpdate) / val[idx].response);
-  // default smoothing
-  val[idx].smoothed = (1.0f - w) * val[idx].smoothed + w * v;
+  const nmea_datadef_t *def = getDataDef(idx);
+  nmea_float_t w = 1.0f; // no time constant, no smoothing
+  if (def->response) {
+    nmea_float_t dt =
+        (nmea_float_t)(now - state.lastSmoothed[idx]) / def->response;
+    w = lazySmoothing ? 1.0f - exp(-dt) : min((nmea_float_t)1.0, dt);
+  }
+  state.lastSmoothed[idx] = now;
+
+  nmea_float_t *smoothed = &state.smoothed[idx];
+  switch (def->type) {
   // special smoothing for some angle types
-  if (val[idx].type == NMEA_COMPASS_ANGLE_SIN)
-    val[idx].smoothed =
-        compassAngle(val[idx + 1].smoothed, val[idx + 2].smoothed);
-  if (val[idx].type == NMEA_BOAT_ANGLE_SIN)
-    val[idx].smoothed = boatAngle(val[idx + 1].smoothed, val[idx + 2].smoothed);
+  case NMEA_COMPASS_ANGLE_SIN:
+    *smoothed = compassAngle(smoothed[1], smoothed[2]);
+    break;
+  case NMEA_BOAT_ANGLE_SIN:
+    *smoothed = boatAngle(smoothed[1], smoothed[2]);
+    break;
   // some types just don't make sense to smooth -- use latest
-  if (val[idx].type == NMEA_BOAT_ANGLE)
-    val[idx].smoothed = val[idx].latest;
-  if (val[idx].type == NMEA_COMPASS_ANGLE)
-    val[idx].smoothed = val[idx].latest;
-  if (val[idx].type == NMEA_DDMM)
-    val[idx].smoothed = val[idx].latest;
-  if (val[idx].type == NMEA_HHMMSS)
-    val[idx].smoothed = val[idx].latest;
-
-  val[idx].lastUpdate = millis(); // take a time stamp
-  if (val[idx].hist) {            // there's a history struct for this tag
-    unsigned long seconds = (millis() - val[idx].hist->lastHistory) / 1000;
-    // do an update if the time has come, or if this is the first time through
-    if (seconds >= val[idx].hist->historyInterval ||
-        val[idx].hist->lastHistory == 0) {
-
-      // move the old history back in time by one step
-      for (unsigned i = 0; i < (val[idx].hist->n - 1); i++)
-        val[idx].hist->data[i] = val[idx].hist->data[i + 1];
-
-      // Create the new entry, scaling and offsetting the value to fit into an
-      // integer, and based on the smoothed value.
-      val[idx].hist->data[val[idx].hist->n - 1] =
-          val[idx].hist->scale * (val[idx].smoothed - val[idx].hist->offset);
-      val[idx].hist->lastHistory = millis();
-    }
+  case NMEA_BOAT_ANGLE:
+  case NMEA_COMPASS_ANGLE:
+  case NMEA_DDMM:
+  case NMEA_HHMMSS:
+    *smoothed = state.latest[idx];
+    break;
+  default: // default smoothing
+    *smoothed = (1.0f - w) * *smoothed + w * state.latest[idx];
+    break;
   }
-#endif // NMEA_EXTENSIONS
 }
 
 /**************************************************************************/
 /*!
-    @brief    Initialize the object. Build a val[] matrix of data values for
-    all of the enumerated values, including the extra values for the compound
-    angle types. The initializer shold probably leave it up to the user
-    sketch to decide which data values should carry the extra memory burden
-    of history.
-    @return   none
+    @brief Choose when smoothed values are worked out. By default every
+    newDataValue() smooths straight away, including the sine, cosine and
+    arc tangent work for compound angles. Lazy smoothing folds each value
+    into the smoothed one for the time it held when the next update comes,
+    and brings the newest value up to date in getSmoothed() and the history,
+    so it follows the values in continuous time whatever the update and read
+    rates. In lazy mode the sine and cosine components of compound angles
+    are only up to date after getSmoothed() of the angle itself.
+    @param on True to smooth when read, false to smooth on every update
+    @return none
 */
 /**************************************************************************/
-void INA::data_init() {
+void INA_Core::setLazySmoothing(bool on) { lazySmoothing = on; }
+#endif // NMEA_EXTENSIONS
+
 #ifdef NMEA_EXTENSIONS
-  // fill all the data values with nothing
-  static char c[] = "NUL";
-  for (int i = 0; i < (int)NMEA_MAX_INDEX; i++) {
-    initDataValue((nmea_index_t)i, c, NULL, NULL, 0, (nmea_value_type_t)0);
-  }
+// formats and units shared by several data values
+static constexpr char BoatSpeedfmt[] = "%6.2f";
+static constexpr char WindSpeedfmt[] = "%6.1f";
+static constexpr char Speedunit[] = "knots";
+static constexpr char Anglefmt[] = "%6.0f";
+static constexpr char BoatAngleunit[] = "Degrees";
+static constexpr char TrueAngleunit[] = "Deg True";
+static constexpr char MagAngleunit[] = "Deg Mag";
+static constexpr char LATfmt[] = "%9.4f";
+static constexpr char LATunit[] = "DDD.dddd";
+static constexpr char NMfmt[] = "%6.2f";
+static constexpr char NMunit[] = "NM";
+static constexpr char Intfmt[] = "%6.0f";
+static constexpr char Tenthsfmt[] = "%6.1f";
+static constexpr char Tempunit[] = "Deg C";
 
-  // fill selected data values with the relevant information and pointers
-  static char BoatSpeedfmt[] = "%6.2f";
-  static char WindSpeedfmt[] = "%6.1f";
-  static char Speedunit[] = "knots";
-  static char Anglefmt[] = "%6.0f";
-  static char BoatAngleunit[] = "Degrees";
-  static char TrueAngleunit[] = "Deg True";
-  static char MagAngleunit[] = "Deg Mag";
-
-  static char HDOPlabel[] = "HDOP";
-  initDataValue(NMEA_HDOP, HDOPlabel);
-
-  static char LATlabel[] = "Lat";
-  static char LATfmt[] = "%9.4f";
-  static char LATunit[] = "DDD.dddd";
-  initDataValue(
-      NMEA_LAT, LATlabel, LATfmt, LATunit, 0,
-      NMEA_BOAT_ANGLE); // angle from -180 to 180, or actually -90 to 90 for lat
-
-  static char LONlabel[] = "Lon";
-  initDataValue(NMEA_LON, LONlabel, LATfmt, LATunit, 0,
-                NMEA_BOAT_ANGLE); // angle from -180 to 180
-
-  static char LATWPlabel[] = "WP Lat";
-  initDataValue(NMEA_LATWP, LATWPlabel, LATfmt, LATunit, 0, NMEA_BOAT_ANGLE);
-
-  static char LONWPlabel[] = "WP Lon";
-  initDataValue(NMEA_LONWP, LONWPlabel, LATfmt, LATunit, 0, NMEA_BOAT_ANGLE);
-
-  static char SOGlabel[] = "SOG";
-  initDataValue(NMEA_SOG, SOGlabel, BoatSpeedfmt, Speedunit);
-
-  static char COGlabel[] = "COG";
-  // types with sin/cos need two extra spots in the values matrix!
-  initDataValue(NMEA_COG, COGlabel, Anglefmt, TrueAngleunit, 0,
-                NMEA_COMPASS_ANGLE_SIN); // type: 0-360 angle with sin/cos 11
-
-  static char COGWPlabel[] = "WP COG";
-  initDataValue(NMEA_COGWP, COGWPlabel, Anglefmt, TrueAngleunit, 0,
-                NMEA_COMPASS_ANGLE); // type: angle 0-360 1
-
-  static char XTElabel[] = "XTE";
-  static char XTEfmt[] = "%6.2f";
-  static char XTEunit[] = "NM";
-  initDataValue(NMEA_XTE, XTElabel, XTEfmt, XTEunit);
-
-  static char DISTWPlabel[] = "WP Dist";
-  initDataValue(NMEA_DISTWP, DISTWPlabel, XTEfmt, XTEunit);
-
-  static char AWAlabel[] = "AWA";
-  initDataValue(NMEA_AWA, AWAlabel, Anglefmt, BoatAngleunit, 0,
-                NMEA_BOAT_ANGLE_SIN); // type: +-180 angle with sin/cos 12
-
-  static char AWSlabel[] = "AWS";
-  initDataValue(NMEA_AWS, AWSlabel, WindSpeedfmt, Speedunit);
-
-  static char TWAlabel[] = "TWA";
-  initDataValue(NMEA_TWA, TWAlabel, Anglefmt, BoatAngleunit, 0,
-                NMEA_BOAT_ANGLE_SIN); // type: +-180 angle with sin/cos 12
-
-  static char TWDlabel[] = "TWD";
-  initDataValue(NMEA_TWD, TWDlabel, Anglefmt, TrueAngleunit, 0,
-                NMEA_COMPASS_ANGLE_SIN); // type: 0-360 angle with sin/cos 11
-
-  static char TWSlabel[] = "TWS";
-  initDataValue(NMEA_TWS, TWSlabel, WindSpeedfmt, Speedunit);
-
-  static char VMGlabel[] = "VMG";
-  initDataValue(NMEA_VMG, VMGlabel, BoatSpeedfmt, Speedunit);
-
-  static char VMGWPlabel[] = "WP VMG";
-  initDataValue(NMEA_VMGWP, VMGWPlabel, BoatSpeedfmt, Speedunit);
-
-  static char HEELlabel[] = "Heel";
-  static char HEELunit[] = "Deg Stbd";
-  initDataValue(NMEA_HEEL, HEELlabel, Anglefmt, HEELunit, 0,
-                NMEA_BOAT_ANGLE); // type: angle +/-180 2
-
-  static char PITCHlabel[] = "Pitch";
-  static char PITCHunit[] = "Deg Bow Up";
-  initDataValue(NMEA_PITCH, PITCHlabel, Anglefmt, PITCHunit, 0,
-                NMEA_BOAT_ANGLE); // type: angle +/-180 2
-  static char HDGlabel[] = "HDG";
-  initDataValue(NMEA_HDG, HDGlabel, Anglefmt, MagAngleunit, 0,
-                NMEA_COMPASS_ANGLE_SIN); // type: 0-360 angle with sin/cos 11
-
-  static char HDTlabel[] = "HDG";
-  initDataValue(NMEA_HDT, HDTlabel, Anglefmt, TrueAngleunit, 0,
-                NMEA_COMPASS_ANGLE_SIN); // type: 0-360 angle with sin/cos 11
-
-  static char VTWlabel[] = "VTW";
-  initDataValue(NMEA_VTW, VTWlabel, BoatSpeedfmt, Speedunit);
-
-  static char LOGlabel[] = "Log";
-  static char LOGfmt[] = "%6.0f";
-  static char LOGunit[] = "NM";
-  initDataValue(NMEA_LOG, LOGlabel, LOGfmt, LOGunit);
-
-  static char LOGRlabel[] = "Trip";
-  static char LOGRfmt[] = "%6.2f";
-  initDataValue(NMEA_LOG, LOGRlabel, LOGRfmt, LOGunit);
-
-  static char DEPTHlabel[] = "Depth";
-  static char DEPTHfmt[] = "%6.1f";
-  static char DEPTHunit[] = "m";
-  initDataValue(NMEA_DEPTH, DEPTHlabel, DEPTHfmt, DEPTHunit);
-
-  static char RPM_M1label[] = "Motor 1";
-  static char RPM_M1fmt[] = "%6.0f";
-  static char RPM_M1unit[] = "RPM";
-  initDataValue(NMEA_RPM_M1, RPM_M1label, RPM_M1fmt, RPM_M1unit);
-
-  static char TEMPERATURE_M1label[] = "Temp 1";
-  static char TEMPERATURE_M1fmt[] = "%6.0f";
-  static char TEMPERATURE_M1unit[] = "Deg C";
-  initDataValue(NMEA_TEMPERATURE_M1, TEMPERATURE_M1label, TEMPERATURE_M1fmt,
-                TEMPERATURE_M1unit);
-
-  static char PRESSURE_M1label[] = "Oil 1";
-  static char PRESSURE_M1fmt[] = "%6.0f";
-  static char PRESSURE_M1unit[] = "kPa";
-  initDataValue(NMEA_PRESSURE_M1, PRESSURE_M1label, PRESSURE_M1fmt,
-                PRESSURE_M1unit);
-
-  static char VOLTAGE_M1label[] = "Motor 1";
-  static char VOLTAGE_M1fmt[] = "%6.2f";
-  static char VOLTAGE_M1unit[] = "Volts";
-  initDataValue(NMEA_VOLTAGE_M1, VOLTAGE_M1label, VOLTAGE_M1fmt,
-                VOLTAGE_M1unit);
-
-  static char CURRENT_M1label[] = "Motor 1";
-  static char CURRENT_M1fmt[] = "%6.1f";
-  static char CURRENT_M1unit[] = "Amps";
-  initDataValue(NMEA_CURRENT_M1, CURRENT_M1label, CURRENT_M1fmt,
-                CURRENT_M1unit);
-
-  static char RPM_M2label[] = "Motor 2";
-  initDataValue(NMEA_RPM_M2, RPM_M2label, RPM_M1fmt, RPM_M1unit);
-
-  static char TEMPERATURE_M2label[] = "Temp 2";
-  initDataValue(NMEA_TEMPERATURE_M2, TEMPERATURE_M2label, TEMPERATURE_M1fmt,
-                TEMPERATURE_M1unit);
-
-  static char PRESSURE_M2label[] = "Oil 2";
-  initDataValue(NMEA_PRESSURE_M2, PRESSURE_M2label, PRESSURE_M1fmt,
-                PRESSURE_M1unit);
-
-  static char VOLTAGE_M2label[] = "Motor 2";
-  initDataValue(NMEA_VOLTAGE_M2, VOLTAGE_M2label, VOLTAGE_M1fmt,
-                VOLTAGE_M1unit);
-
-  static char CURRENT_M2label[] = "Motor 2";
-  initDataValue(NMEA_CURRENT_M2, CURRENT_M2label, CURRENT_M1fmt,
-                CURRENT_M1unit);
-
-  static char TEMPERATURE_AIRlabel[] = "Air";
-  static char TEMPERATURE_AIRfmt[] = "%6.1f";
-  static char TEMPERATURE_AIRunit[] = "Deg C";
-  initDataValue(NMEA_TEMPERATURE_AIR, TEMPERATURE_AIRlabel, TEMPERATURE_AIRfmt,
-                TEMPERATURE_AIRunit);
-
-  static char TEMPERATURE_WATERlabel[] = "Water";
-  static char TEMPERATURE_WATERfmt[] = "%6.1f";
-  static char TEMPERATURE_WATERunit[] = "Deg C";
-  initDataValue(NMEA_TEMPERATURE_WATER, TEMPERATURE_WATERlabel,
-                TEMPERATURE_WATERfmt, TEMPERATURE_WATERunit);
-
-  static char HUMIDITYlabel[] = "Humidity";
-  static char HUMIDITYfmt[] = "%6.0f";
-  static char HUMIDITYunit[] = "% RH";
-  initDataValue(NMEA_HUMIDITY, HUMIDITYlabel, HUMIDITYfmt, HUMIDITYunit);
-
-  static char BAROMETERlabel[] = "Barometer";
-  static char BAROMETERfmt[] = "%6.0f";
-  static char BAROMETERunit[] = "Pa";
-  initDataValue(NMEA_BAROMETER, BAROMETERlabel, BAROMETERfmt, BAROMETERunit);
-#endif // NMEA_EXTENSIONS
+/**************************************************************************/
+/*!
+    The definitions of the library's data values, in nmea_index_t order up
+    to NMEA_USR_00. Types with sin/cos need the next two entries for the
+    components.
+*/
+/**************************************************************************/
+static constexpr nmea_datadef_t nmeaDataDefs[] = {
+    nmeaDataDef("HDOP"),                                            // HDOP
+    nmeaDataDef("Lat", LATfmt, LATunit, NMEA_BOAT_ANGLE),           // LAT
+    nmeaDataDef("Lon", LATfmt, LATunit, NMEA_BOAT_ANGLE),           // LON
+    nmeaDataDef("WP Lat", LATfmt, LATunit, NMEA_BOAT_ANGLE),        // LATWP
+    nmeaDataDef("WP Lon", LATfmt, LATunit, NMEA_BOAT_ANGLE),        // LONWP
+    nmeaDataDef("SOG", BoatSpeedfmt, Speedunit),                    // SOG
+    nmeaDataDef("COG", Anglefmt, TrueAngleunit, NMEA_COMPASS_ANGLE_SIN),
+    nmeaDataDef("NUL"),                                             // COG_SIN
+    nmeaDataDef("NUL"),                                             // COG_COS
+    nmeaDataDef("WP COG", Anglefmt, TrueAngleunit, NMEA_COMPASS_ANGLE),
+    nmeaDataDef("XTE", NMfmt, NMunit),                              // XTE
+    nmeaDataDef("WP Dist", NMfmt, NMunit),                          // DISTWP
+    nmeaDataDef("AWA", Anglefmt, BoatAngleunit, NMEA_BOAT_ANGLE_SIN),
+    nmeaDataDef("NUL"),                                             // AWA_SIN
+    nmeaDataDef("NUL"),                                             // AWA_COS
+    nmeaDataDef("AWS", WindSpeedfmt, Speedunit),                    // AWS
+    nmeaDataDef("TWA", Anglefmt, BoatAngleunit, NMEA_BOAT_ANGLE_SIN),
+    nmeaDataDef("NUL"),                                             // TWA_SIN
+    nmeaDataDef("NUL"),                                             // TWA_COS
+    nmeaDataDef("TWD", Anglefmt, TrueAngleunit, NMEA_COMPASS_ANGLE_SIN),
+    nmeaDataDef("NUL"),                                             // TWD_SIN
+    nmeaDataDef("NUL"),                                             // TWD_COS
+    nmeaDataDef("TWS", WindSpeedfmt, Speedunit),                    // TWS
+    nmeaDataDef("VMG", BoatSpeedfmt, Speedunit),                    // VMG
+    nmeaDataDef("WP VMG", BoatSpeedfmt, Speedunit),                 // VMGWP
+    nmeaDataDef("Heel", Anglefmt, "Deg Stbd", NMEA_BOAT_ANGLE),     // HEEL
+    nmeaDataDef("Pitch", Anglefmt, "Deg Bow Up", NMEA_BOAT_ANGLE),  // PITCH
+    nmeaDataDef("HDG", Anglefmt, MagAngleunit, NMEA_COMPASS_ANGLE_SIN),
+    nmeaDataDef("NUL"),                                             // HDG_SIN
+    nmeaDataDef("NUL"),                                             // HDG_COS
+    nmeaDataDef("HDG", Anglefmt, TrueAngleunit, NMEA_COMPASS_ANGLE_SIN),
+    nmeaDataDef("NUL"),                                             // HDT_SIN
+    nmeaDataDef("NUL"),                                             // HDT_COS
+    nmeaDataDef("VTW", BoatSpeedfmt, Speedunit),                    // VTW
+    nmeaDataDef("Log", Intfmt, NMunit),                             // LOG
+    nmeaDataDef("Trip", NMfmt, NMunit),                             // LOGR
+    nmeaDataDef("Depth", Tenthsfmt, "m"),                           // DEPTH
+    nmeaDataDef("Motor 1", Intfmt, "RPM"),                          // RPM_M1
+    nmeaDataDef("Temp 1", Intfmt, Tempunit),                        // TEMP._M1
+    nmeaDataDef("Oil 1", Intfmt, "kPa"),                            // PRESS._M1
+    nmeaDataDef("Motor 1", "%6.2f", "Volts"),                       // VOLT._M1
+    nmeaDataDef("Motor 1", Tenthsfmt, "Amps"),                      // CURR._M1
+    nmeaDataDef("Motor 2", Intfmt, "RPM"),                          // RPM_M2
+    nmeaDataDef("Temp 2", Intfmt, Tempunit),                        // TEMP._M2
+    nmeaDataDef("Oil 2", Intfmt, "kPa"),                            // PRESS._M2
+    nmeaDataDef("Motor 2", "%6.2f", "Volts"),                       // VOLT._M2
+    nmeaDataDef("Motor 2", Tenthsfmt, "Amps"),                      // CURR._M2
+    nmeaDataDef("Air", Tenthsfmt, Tempunit),                        // TEMP._AIR
+    nmeaDataDef("Water", Tenthsfmt, Tempunit),                      // TEMP._W.
+    nmeaDataDef("Humidity", Intfmt, "% RH"),                        // HUMIDITY
+    nmeaDataDef("Barometer", Intfmt, "Pa"),                         // BAROMETER
+};
+static_assert(sizeof(nmeaDataDefs) / sizeof(nmeaDataDefs[0]) == NMEA_USR_00,
+              "nmeaDataDefs must have one entry per nmea_index_t before "
+              "NMEA_USR_00");
+
+/// the user data values, unless the sketch defines its own nmeaUserDefs[]
+extern const nmea_datadef_t nmeaUserDefs[NMEA_USR_COUNT]
+    __attribute__((weak)) = {
+    nmeaDataDef("NUL"), nmeaDataDef("NUL"), nmeaDataDef("NUL"),
+    nmeaDataDef("NUL"), nmeaDataDef("NUL"), nmeaDataDef("NUL"),
+    nmeaDataDef("NUL"), nmeaDataDef("NUL"), nmeaDataDef("NUL"),
+    nmeaDataDef("NUL"), nmeaDataDef("NUL"), nmeaDataDef("NUL"),
+    nmeaDataDef("NUL")};
+static_assert(NMEA_USR_COUNT == 13, "update the default nmeaUserDefs[]");
+
+/**************************************************************************/
+/*!
+    @brief Look up the definition of a data value: an initDataValue()
+    override if it has one, otherwise the compile time definition.
+    @param idx The data index of the value
+    @return Pointer to the definition, or NULL for an invalid index
+*/
+/**************************************************************************/
+const nmea_datadef_t *INA_Core::getDataDef(nmea_index_t idx) {
+  if (idx >= NMEA_MAX_INDEX || idx < NMEA_HDOP)
+    return NULL;
+  if (idx >= NMEA_USR_00)
+    return meta[idx].custom ? &userDefs[idx - NMEA_USR_00]
+                            : &nmeaUserDefs[idx - NMEA_USR_00];
+  if (meta[idx].custom)
+    return &dataDefs[meta[idx].custom - 1];
+  return &nmeaDataDefs[idx];
 }
+#endif // NMEA_EXTENSIONS
 
 #ifdef NMEA_EXTENSIONS
 /**************************************************************************/
 /*!
     @brief Clearer approach to retrieving NMEA values by allowing calls that
-    look like nmea.get(NMEA_TWA) instead of val[NMEA_TWA].latest.
+    look like nmea.get(NMEA_TWA) instead of state.latest[NMEA_TWA].
     Use newDataValue() to set the values.
     @param idx the NMEA value's index
     @return the latest NMEA value
 */
 /**************************************************************************/
-nmea_float_t INA::get(nmea_index_t idx) {
+nmea_float_t INA_Core::get(nmea_index_t idx) {
   if (idx >= NMEA_MAX_INDEX || idx < NMEA_HDOP)
     return 0.0;
-  return val[idx].latest;
+  return state.latest[idx];
 }
 
 /**************************************************************************/
@@ -289,16 +312,34 @@ nmea_float_t INA::get(nmea_index_t idx) {
     @return the latest NMEA value, smoothed
 */
 /**************************************************************************/
-nmea_float_t INA::getSmoothed(nmea_index_t idx) {
+nmea_float_t INA_Core::getSmoothed(nmea_index_t idx) {
   if (idx >= NMEA_MAX_INDEX || idx < NMEA_HDOP)
     return 0.0;
-  return val[idx].smoothed;
+  if (lazySmoothing && state.lastUpdate[idx] != 0) // nothing to hold before
+    smoothDataValue(idx, millis());
+  return state.smoothed[idx];
 }
 
 /**************************************************************************/
 /*!
-    @brief Initialize the contents of a data value table entry
-    @param idx The data index for the value to be initialized
+    @brief Copy the latest value of every data value, as get() would
+    return them, in one go
+    @param buff Pointer to an array of NMEA_MAX_INDEX values to fill,
+    indexed by nmea_index_t
+    @return none
+*/
+/**************************************************************************/
+void INA_Core::copyLatest(nmea_float_t *buff) {
+  memcpy(buff, state.latest, sizeof(state.latest));
+}
+
+/**************************************************************************/
+/*!
+    @brief Change the definition of a data value at run time. Every user
+    data value, NMEA_USR_00 onwards, has a slot of its own for this. Up to
+    NMEA_DATA_OVERRIDES of the other data values can be changed. Describing
+    the user data values in nmeaUserDefs[] instead saves the copy.
+    @param idx The data index for the value to be changed
     @param label Pointer to a label string that describes the value
     @param fmt Pointer to a sprintf format to use for the value, e.g. "%6.2f"
     @param unit Pointer to a string for the units, e.g. "Deg Mag"
@@ -307,37 +348,156 @@ nmea_float_t INA::getSmoothed(nmea_index_t idx) {
     @param type The type of data contained in the value. simple float 0,
     angle 0-360 1, angle +/-180 2, angle with history centered +/- around
     the latest angle 3, lat/lon DDMM.mm 10, time HHMMSS 20.
-    @return none
+    @return True if the definition was changed, false if the index is
+    invalid or there is no room for another override
 */
 /**************************************************************************/
-void INA::initDataValue(nmea_index_t idx, char *label, char *fmt,
-                                 char *unit, unsigned long response,
-                                 nmea_value_type_t type) {
-  if (idx < NMEA_MAX_INDEX) {
-    if (label)
-      val[idx].label = label;
-    if (fmt)
-      val[idx].fmt = fmt;
-    if (unit)
-      val[idx].unit = unit;
-    if (response)
-      val[idx].response = response;
-    val[idx].type = type;
-    if ((int)(val[idx].type / 10) ==
-        1) { // angle with sin/cos component recording
-      initDataValue(
-          (nmea_index_t)(idx +
-                         1)); // initialize the next two data values as well
-      initDataValue((nmea_index_t)(idx + 2));
+bool INA_Core::initDataValue(nmea_index_t idx, const char *label,
+                             const char *fmt, const char *unit,
+                             unsigned long response, nmea_value_type_t type) {
+  if (idx >= NMEA_MAX_INDEX || idx < NMEA_HDOP)
+    return false;
+  nmea_datadef_t *d;
+  if (idx >= NMEA_USR_00) {
+    d = &userDefs[idx - NMEA_USR_00];
+    if (!meta[idx].custom) { // start from the compile time definition
+      *d = nmeaUserDefs[idx - NMEA_USR_00];
+      meta[idx].custom = 1;
+    }
+  } else {
+    if (!meta[idx].custom) { // start from the compile time definition
+      if (nDataDefs >= NMEA_DATA_OVERRIDES)
+        return false;
+      dataDefs[nDataDefs] = nmeaDataDefs[idx];
+      meta[idx].custom = ++nDataDefs;
     }
+    d = &dataDefs[meta[idx].custom - 1];
   }
+  if (label)
+    d->label = label;
+  if (fmt)
+    d->fmt = fmt;
+  if (unit)
+    d->unit = unit;
+  if (response)
+    d->response = response;
+  d->type = type;
+  return true;
 }
 
+/// What the arena aligns every block to: the statistics windows hold
+/// doubles, so the history structs alone are not enough, and this is what
+/// malloc() gives
+static const size_t arenaAlign = alignof(max_align_t);
+
+/**************************************************************************/
+/*!
+    @brief Hand out memory for a history, from the arena if one is set or
+    else from the heap, aligned as malloc() would align it. Sets historyErr
+    if there is none.
+    @param size Bytes wanted
+    @return Pointer to the memory, or NULL
+*/
+/**************************************************************************/
+void *INA_Core::historyAlloc(size_t size) {
+  if (arena == NULL) {
+    void *p = malloc(size);
+    if (p == NULL)
+      historyErr = NMEA_HISTORY_NO_HEAP;
+    return p;
+  }
+  size_t at = (arenaUsed + arenaAlign - 1) & ~(arenaAlign - 1);
+  if (at > arenaSize || size > arenaSize - at) {
+    historyErr = NMEA_HISTORY_ARENA_FULL;
+    return NULL;
+  }
+  arenaUsed = at + size;
+  if (arenaUsed > arenaHigh)
+    arenaHigh = arenaUsed;
+  return arena + at;
+}
+
+/**************************************************************************/
+/*!
+    @brief Give back memory from historyAlloc(). Memory from the arena is
+    only reclaimed by the next setHistoryArena().
+    @param p Pointer from historyAlloc(), or NULL
+*/
+/**************************************************************************/
+void INA_Core::historyFree(void *p) {
+  if (arena == NULL)
+    free(p);
+}
+
+/**************************************************************************/
+/*!
+    @brief Carve all histories and their tiers out of a fixed buffer instead
+    of the heap, so a long running node does not fragment the heap it
+    shares with JSON documents and network buffers. Call during setup,
+    before initHistory(); any histories and statistics that already exist
+    are removed.
+
+    The arena is a bump allocator: removeHistory() does not give memory back
+    to it, so set up the histories once. Use historyArenaHighWater() to size
+    the buffer, and historyError() to see why an initHistory() or
+    addHistoryTier() failed.
+    @param buff The buffer, which must stay in place while it is in use, or
+    NULL to go back to malloc()
+    @param size Bytes in the buffer
+    @return True if the arena was set, false if it is too small to hold
+    anything
+*/
+/**************************************************************************/
+bool INA_Core::setHistoryArena(void *buff, size_t size) {
+  for (int i = 0; i < NMEA_MAX_INDEX; i++) {
+    removeHistory((nmea_index_t)i);
+    removeStats((nmea_index_t)i);
+  }
+  arena = NULL;
+  arenaSize = arenaUsed = 0;
+  if (buff == NULL)
+    return true;
+  // start on a boundary anything historyAlloc() hands out can live on
+  size_t skip =
+      (arenaAlign - ((uintptr_t)buff & (arenaAlign - 1))) & (arenaAlign - 1);
+  if (size < skip + sizeof(nmea_history_t))
+    return false;
+  arena = (uint8_t *)buff + skip;
+  arenaSize = size - skip;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Bytes of the history arena handed out so far
+    @return Bytes used, 0 if there is no arena
+*/
+/**************************************************************************/
+size_t INA_Core::historyArenaUsed(void) { return arenaUsed; }
+
+/**************************************************************************/
+/*!
+    @brief The most bytes ever used in a history arena, kept across
+    setHistoryArena() calls, to size the buffer for a given configuration
+    @return Bytes
+*/
+/**************************************************************************/
+size_t INA_Core::historyArenaHighWater(void) { return arenaHigh; }
+
+/**************************************************************************/
+/*!
+    @brief Why the last initHistory() or addHistoryTier() failed
+    @return NMEA_HISTORY_OK if it succeeded, or the reason it did not
+*/
+/**************************************************************************/
+nmea_history_error_t INA_Core::historyError(void) { return historyErr; }
+
 /**************************************************************************/
 /*!
     @brief Attempt to add history to a data value table entry. If it fails
-    to malloc the space, history will not be added. Test the pointer for a
-    check if needed. Select scale and offset values carefully so that
+    to get the space, from the heap or the arena set with setHistoryArena(),
+    history will not be added and historyError() says why. Test the pointer
+    for a check if needed. Select scale and offset values carefully so that
     operations and results will fit inside 16 bit integer limits. For example
     a scale of 1.0 and an offset of 100000.0 would be a good choice for
     atmospheric pressure in Pa with values ranging ~ +/- 3500, while a scale
@@ -348,39 +508,45 @@ void INA::initDataValue(nmea_index_t idx, char *label, char *fmt,
     @param historyInterval Approximate Time in seconds between historical
    values.
     @param historyN Set size of data buffer.
-    @return pointer to the history
+    @return pointer to the history, NULL if it could not be added
 */
 /**************************************************************************/
-nmea_history_t *INA::initHistory(nmea_index_t idx, nmea_float_t scale,
+nmea_history_t *INA_Core::initHistory(nmea_index_t idx, nmea_float_t scale,
                                           nmea_float_t offset,
                                           unsigned historyInterval,
                                           unsigned historyN) {
   historyN = max((unsigned)10, historyN);
+  historyErr = NMEA_HISTORY_BAD_INDEX;
   if (idx < NMEA_MAX_INDEX) {
     // remove any existing history
-    if (val[idx].hist != NULL)
+    if (meta[idx].hist != NULL)
       removeHistory(idx);
-    // space for the struct
-    val[idx].hist = (nmea_history_t *)malloc(sizeof(nmea_history_t));
-    if (val[idx].hist != NULL) {
-      // space for the data array of the appropriate size
-      val[idx].hist->data = (int16_t *)malloc(sizeof(int16_t) * historyN);
-      if (val[idx].hist->data != NULL) {
-        // initialize the data array
-        for (unsigned i = 0; i < historyN; i++)
-          val[idx].hist->data[i] = 0;
-      } else
-        free(val[idx].hist);
-    }
-    if (val[idx].hist != NULL) {
-      val[idx].hist->n = historyN;
-      if (scale > 0.0f)
-        val[idx].hist->scale = scale;
-      val[idx].hist->offset = offset;
-      if (historyInterval > 0)
-        val[idx].hist->historyInterval = historyInterval;
+    size_t mark = arenaUsed, high = arenaHigh;
+    // space for the struct and the data array of the appropriate size
+    nmea_history_t *h = (nmea_history_t *)historyAlloc(sizeof(nmea_history_t));
+    int16_t *data = NULL;
+    if (h != NULL)
+      data = (int16_t *)historyAlloc(sizeof(int16_t) * historyN);
+    if (data == NULL) {
+      historyFree(h);
+      arenaUsed = mark; // nothing of a failed history stays in the arena
+      arenaHigh = high;
+      return NULL;
     }
-    return val[idx].hist;
+    *h = nmea_history_t();
+    h->data = data;
+    // initialize the data array
+    for (unsigned i = 0; i < historyN; i++)
+      h->data[i] = 0;
+    h->n = historyN;
+    if (scale > 0.0f)
+      h->scale = scale;
+    h->offset = offset;
+    if (historyInterval > 0)
+      h->historyInterval = historyInterval;
+    historyErr = NMEA_HISTORY_OK;
+    meta[idx].hist = h;
+    return h;
   }
   return NULL;
 }
@@ -388,17 +554,444 @@ nmea_history_t *INA::initHistory(nmea_index_t idx, nmea_float_t scale,
 /**************************************************************************/
 /*!
     @brief Remove history from a data value table entry, if it has been added.
+    Memory from a history arena is not reused until the next
+    setHistoryArena().
     @param idx The data index for the value to have history removed
     @return none
 */
 /**************************************************************************/
-void INA::removeHistory(nmea_index_t idx) {
+void INA_Core::removeHistory(nmea_index_t idx) {
   if (idx < NMEA_MAX_INDEX) {
-    if (val[idx].hist == NULL)
+    if (meta[idx].hist == NULL)
       return;
-    free(val[idx].hist->data);
-    free(val[idx].hist);
-    val[idx].hist = NULL;
+    for (uint8_t t = 0; t < meta[idx].hist->nTiers; t++)
+      historyFree(meta[idx].hist->tiers[t].data);
+    historyFree(meta[idx].hist->data);
+    historyFree(meta[idx].hist);
+    meta[idx].hist = NULL;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief Number of values recorded in the history of a data value
+    @param idx The data index of the value
+    @return Values recorded so far, up to the size of the history, or 0 if
+    the value has no history
+*/
+/**************************************************************************/
+unsigned INA_Core::historyCount(nmea_index_t idx) {
+  if (idx >= NMEA_MAX_INDEX || meta[idx].hist == NULL)
+    return 0;
+  return meta[idx].hist->count;
+}
+
+/**************************************************************************/
+/*!
+    @brief Get one value from the history of a data value
+    @param idx The data index of the value
+    @param i Which value, 0 for the oldest up to historyCount() - 1 for the
+    most recent
+    @return The scaled integer history value, see nmea_history_t, or 0 if
+    there is no such value
+*/
+/**************************************************************************/
+int16_t INA_Core::historyValue(nmea_index_t idx, unsigned i) {
+  if (idx >= NMEA_MAX_INDEX || meta[idx].hist == NULL)
+    return 0;
+  nmea_history_t *h = meta[idx].hist;
+  if (i >= h->count)
+    return 0;
+  unsigned at = h->head + (h->n - h->count) + i; // oldest is count behind head
+  if (at >= h->n)
+    at -= h->n;
+  return h->data[at];
+}
+
+/**************************************************************************/
+/*!
+    @brief Copy the most recent values from the history of a data value into
+    a buffer, oldest first, with at most two block copies.
+    @param idx The data index of the value
+    @param buff Pointer to the buffer to copy the values into
+    @param len Number of values the buffer can hold
+    @return The number of values copied, the lesser of len and
+    historyCount()
+*/
+/**************************************************************************/
+unsigned INA_Core::copyHistory(nmea_index_t idx, int16_t *buff, unsigned len) {
+  unsigned count = min(len, historyCount(idx));
+  if (count == 0)
+    return 0;
+  nmea_history_t *h = meta[idx].hist;
+  // the newest count values end just before head, and may wrap past the end
+  unsigned start =
+      (h->head >= count) ? h->head - count : h->head + h->n - count;
+  unsigned first = min(count, h->n - start);
+  memcpy(buff, &h->data[start], first * sizeof(int16_t));
+  memcpy(buff + first, h->data, (count - first) * sizeof(int16_t));
+  return count;
+}
+
+/**************************************************************************/
+/*!
+    @brief Add a coarser tier on top of the history of a data value, or on
+    top of its last tier. Every factor points of the tier below are rolled
+    up into one min/mean/max point of the new tier, from the time it is
+    added. Call after initHistory(), finest tier first, e.g. factor 15 and
+    n 144 for 5 minute points over 12 hours on a 20 second history, then
+    factor 12 and n 168 for hourly points over a week.
+    @param idx The data index of the value
+    @param factor Points of the tier below that make one point of this one
+    @param n Number of points the tier holds
+    @return True if the tier was added, false if the value has no history,
+    it already has NMEA_HISTORY_TIERS tiers, or there was no memory for it;
+    historyError() says which
+*/
+/**************************************************************************/
+bool INA_Core::addHistoryTier(nmea_index_t idx, uint16_t factor, unsigned n) {
+  if (idx >= NMEA_MAX_INDEX || meta[idx].hist == NULL) {
+    historyErr = NMEA_HISTORY_BAD_INDEX;
+    return false;
+  }
+  nmea_history_t *h = meta[idx].hist;
+  if (factor < 2 || n == 0 || h->nTiers >= NMEA_HISTORY_TIERS) {
+    historyErr = NMEA_HISTORY_BAD_TIER;
+    return false;
+  }
+  nmea_history_tier_t *tier = &h->tiers[h->nTiers];
+  tier->data = (nmea_history_point_t *)historyAlloc(
+      sizeof(nmea_history_point_t) * n);
+  if (tier->data == NULL)
+    return false;
+  tier->n = n;
+  tier->head = tier->count = 0;
+  tier->factor = factor;
+  tier->taken = 0;
+  tier->sum = 0;
+  h->nTiers++;
+  historyErr = NMEA_HISTORY_OK;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Fold one point into a tier of a history, and when the tier has
+    taken factor points, record their roll up and pass it on to the next
+    tier.
+    @param h The history
+    @param t Index of the tier in h->tiers
+    @param p The point from the tier below
+    @return none
+*/
+/**************************************************************************/
+void INA_Core::historyRollup(nmea_history_t *h, uint8_t t,
+                             nmea_history_point_t p) {
+  for (; t < h->nTiers; t++) {
+    nmea_history_tier_t *tier = &h->tiers[t];
+    if (tier->taken == 0) {
+      tier->min = p.min;
+      tier->max = p.max;
+      tier->sum = 0;
+    }
+    tier->min = min(tier->min, p.min);
+    tier->max = max(tier->max, p.max);
+    tier->sum += p.mean;
+    if (++tier->taken < tier->factor)
+      return;
+    p = {tier->min, (int16_t)(tier->sum / tier->taken), tier->max};
+    tier->taken = 0;
+    tier->data[tier->head] = p;
+    if (++tier->head == tier->n)
+      tier->head = 0;
+    if (tier->count < tier->n)
+      tier->count++;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief Get the history of a data value over a span of time from the
+    finest tier that reaches that far back, or the coarsest if none does.
+    Points of the base history have min = mean = max.
+    @param idx The data index of the value
+    @param span Seconds of history wanted, back from the most recent point
+    @param buff Pointer to the buffer to copy the points into, oldest first
+    @param len Number of points the buffer can hold
+    @param interval Pointer to fill with the seconds between the points
+    returned, if not NULL
+    @return The number of points copied, at most len, fewer if the tier has
+    not recorded that many yet
+*/
+/**************************************************************************/
+unsigned INA_Core::getHistory(nmea_index_t idx, uint32_t span,
+                              nmea_history_point_t *buff, unsigned len,
+                              uint32_t *interval) {
+  if (idx >= NMEA_MAX_INDEX || meta[idx].hist == NULL)
+    return 0;
+  nmea_history_t *h = meta[idx].hist;
+  // walk up the tiers until one covers the span
+  uint32_t step = h->historyInterval;
+  int8_t t = -1;
+  unsigned n = h->n;
+  while (t + 1 < h->nTiers && (uint32_t)n * step < span) {
+    t++;
+    step *= h->tiers[t].factor;
+    n = h->tiers[t].n;
+  }
+  if (interval != NULL)
+    *interval = step;
+
+  unsigned count = (t < 0) ? h->count : h->tiers[t].count;
+  unsigned head = (t < 0) ? h->head : h->tiers[t].head;
+  uint32_t wanted = span / step + (span % step != 0);
+  count = min(count, (unsigned)min((uint32_t)len, wanted));
+  // the newest count points end just before head
+  unsigned at = (head >= count) ? head - count : head + n - count;
+  for (unsigned i = 0; i < count; i++) {
+    if (t < 0) {
+      int16_t v = h->data[at];
+      buff[i] = {v, v, v};
+    } else {
+      buff[i] = h->tiers[t].data[at];
+    }
+    if (++at == n)
+      at = 0;
+  }
+  return count;
+}
+
+/**************************************************************************/
+/*!
+    @brief Keep running statistics of the raw values of a data value over
+    the last window values, for getStats(). The memory comes from the same
+    place as history: the heap, or the arena set with setHistoryArena().
+    Compound angles are treated as plain numbers, so their statistics are
+    only useful away from the wrap around.
+    @param idx The data index of the value
+    @param window Number of values the statistics cover
+    @return True if the statistics were added, false if not; historyError()
+    says why
+*/
+/**************************************************************************/
+bool INA_Core::initStats(nmea_index_t idx, uint16_t window) {
+  if (idx >= NMEA_MAX_INDEX || window == 0) {
+    historyErr = NMEA_HISTORY_BAD_INDEX;
+    return false;
+  }
+  removeStats(idx);
+  size_t mark = arenaUsed, high = arenaHigh;
+  nmea_stats_window_t *w =
+      (nmea_stats_window_t *)historyAlloc(sizeof(nmea_stats_window_t));
+  nmea_float_t *data = NULL;
+  uint16_t *minq = NULL, *maxq = NULL;
+  if (w != NULL)
+    data = (nmea_float_t *)historyAlloc(sizeof(nmea_float_t) * window);
+  if (data != NULL)
+    minq = (uint16_t *)historyAlloc(sizeof(uint16_t) * window);
+  if (minq != NULL)
+    maxq = (uint16_t *)historyAlloc(sizeof(uint16_t) * window);
+  if (maxq == NULL) {
+    historyFree(minq);
+    historyFree(data);
+    historyFree(w);
+    arenaUsed = mark;
+    arenaHigh = high;
+    return false;
+  }
+  *w = nmea_stats_window_t();
+  w->data = data;
+  w->minq = minq;
+  w->maxq = maxq;
+  w->n = window;
+  meta[idx].stats = w;
+  historyErr = NMEA_HISTORY_OK;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Stop keeping statistics of a data value, if it has any
+    @param idx The data index of the value
+*/
+/**************************************************************************/
+void INA_Core::removeStats(nmea_index_t idx) {
+  if (idx >= NMEA_MAX_INDEX || meta[idx].stats == NULL)
+    return;
+  historyFree(meta[idx].stats->maxq);
+  historyFree(meta[idx].stats->minq);
+  historyFree(meta[idx].stats->data);
+  historyFree(meta[idx].stats);
+  meta[idx].stats = NULL;
+}
+
+/**************************************************************************/
+/*!
+    @brief Add a value to the running statistics, dropping the oldest one
+    once the window is full
+    @param w The statistics of the data value
+    @param v The new value
+*/
+/**************************************************************************/
+void INA_Core::statsAdd(nmea_stats_window_t *w, nmea_float_t v) {
+  uint16_t at = w->head;
+  if (w->count < w->n) {
+    w->count++;
+    double d = v - w->mean;
+    w->mean += d / w->count;
+    w->m2 += d * (v - w->mean);
+  } else {
+    double old = w->data[at];
+    double mean = w->mean + (v - old) / w->n;
+    w->m2 += (v - old) * (v - mean + old - w->mean);
+    w->mean = mean;
+    // the oldest value leaves the window, and the queues if it is in them
+    if (w->minCount && w->minq[w->minFront] == at) {
+      w->minCount--;
+      if (++w->minFront == w->n)
+        w->minFront = 0;
+    }
+    if (w->maxCount && w->maxq[w->maxFront] == at) {
+      w->maxCount--;
+      if (++w->maxFront == w->n)
+        w->maxFront = 0;
+    }
+  }
+  w->data[at] = v;
+
+  // values the new one hides can never be the min or max again
+  while (w->minCount &&
+         w->data[w->minq[(w->minFront + w->minCount - 1) % w->n]] >= v)
+    w->minCount--;
+  w->minq[(w->minFront + w->minCount++) % w->n] = at;
+  while (w->maxCount &&
+         w->data[w->maxq[(w->maxFront + w->maxCount - 1) % w->n]] <= v)
+    w->maxCount--;
+  w->maxq[(w->maxFront + w->maxCount++) % w->n] = at;
+
+  if (++w->head == w->n)
+    w->head = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief Get the running statistics of a data value, without looking at
+    the values themselves
+    @param idx The data index of the value
+    @return The statistics over the window from initStats(), with count 0
+    if the value has no statistics or no values yet
+*/
+/**************************************************************************/
+nmea_stats_t INA_Core::getStats(nmea_index_t idx) {
+  nmea_stats_t st = {0, 0, 0, 0, 0};
+  if (idx >= NMEA_MAX_INDEX || meta[idx].stats == NULL ||
+      meta[idx].stats->count == 0)
+    return st;
+  nmea_stats_window_t *w = meta[idx].stats;
+  st.count = w->count;
+  st.min = w->data[w->minq[w->minFront]];
+  st.max = w->data[w->maxq[w->maxFront]];
+  st.mean = w->mean;
+  if (w->count > 1 && w->m2 > 0)
+    st.stddev = sqrt(w->m2 / (w->count - 1));
+  return st;
+}
+
+/**************************************************************************/
+/*!
+    @brief Have a function called when a data value changes by more than a
+    deadband, instead of polling get() for it. The change needed is the
+    larger of absBand and relBand times the value last passed on, and is
+    measured the short way round for angles. With both bands 0 the callback
+    is called for every value that differs from the last one passed on. The
+    first value always gets through.
+
+    The callback is called from newDataValue(), in whatever parses the
+    sentence: parse(), the getters that wait for a fix, or read() and poll()
+    with setStreamDecode(). With INA_READER_TASK the reader task only queues
+    the raw sentences, so the callback still runs in the code that takes
+    them off the queue and parses them, and holds it up until it returns. A
+    callback may unsubscribe() itself or any other subscription, but should
+    not subscribe().
+    @param idx The data index of the value
+    @param callback The function to call
+    @param arg Passed back to the callback
+    @param absBand Least change to pass on, in the units of the value
+    @param relBand Least change to pass on, as a fraction of the value
+    @param minInterval Least ms between two calls; a change held back by it
+    is passed on with the first value after the interval that is still far
+    enough from the last one passed on
+    @return An id for unsubscribe(), or -1 if the callback is NULL, the
+    index is out of range or all NMEA_MAX_SUBSCRIPTIONS are in use
+*/
+/**************************************************************************/
+int8_t INA_Core::subscribe(nmea_index_t idx, nmea_data_callback_t callback,
+                           void *arg, nmea_float_t absBand,
+                           nmea_float_t relBand, uint32_t minInterval) {
+  if (idx >= NMEA_MAX_INDEX || callback == NULL)
+    return -1;
+  for (uint8_t i = 0; i < NMEA_MAX_SUBSCRIPTIONS; i++) {
+    if (subs[i].callback != NULL)
+      continue;
+    subs[i] = nmea_subscription_t();
+    subs[i].arg = arg;
+    subs[i].absBand = absBand;
+    subs[i].relBand = relBand;
+    subs[i].minInterval = minInterval;
+    subs[i].idx = idx;
+    subs[i].next = meta[idx].sub;
+    subs[i].callback = callback;
+    meta[idx].sub = i + 1; // newest first
+    return i;
+  }
+  return -1;
+}
+
+/**************************************************************************/
+/*!
+    @brief Stop calling a callback registered with subscribe()
+    @param id The id subscribe() returned
+*/
+/**************************************************************************/
+void INA_Core::unsubscribe(int8_t id) {
+  if (id < 0 || id >= NMEA_MAX_SUBSCRIPTIONS || subs[id].callback == NULL)
+    return;
+  // unlink it from the chain of its data value
+  uint8_t *link = &meta[subs[id].idx].sub;
+  while (*link != id + 1)
+    link = &subs[*link - 1].next;
+  *link = subs[id].next;
+  subs[id].callback = NULL;
+}
+
+/**************************************************************************/
+/*!
+    @brief Pass a new value on to the callbacks subscribed to it whose
+    deadband and interval it clears
+    @param idx The data index of the value
+    @param v The new value
+    @param now millis() of the value
+*/
+/**************************************************************************/
+void INA_Core::dispatch(nmea_index_t idx, nmea_float_t v, uint32_t now) {
+  uint8_t type = getDataDef(idx)->type;
+  bool angle = type < NMEA_DDMM && (type % 10) != 0;
+  for (uint8_t i = meta[idx].sub; i != 0; i = subs[i - 1].next) {
+    nmea_subscription_t *s = &subs[i - 1];
+    if (s->called) {
+      if (now - s->lastCall < s->minInterval)
+        continue;
+      nmea_float_t change = fabs(v - s->lastValue);
+      if (angle && change > 180)
+        change = 360 - change;
+      nmea_float_t band = max(s->absBand, s->relBand * fabs(s->lastValue));
+      if (change == 0 || change < band)
+        continue;
+    }
+    s->called = true;
+    s->lastValue = v;
+    s->lastCall = now;
+    s->callback(idx, v, s->arg);
   }
 }
 
@@ -411,35 +1004,36 @@ void INA::removeHistory(nmea_index_t idx) {
     @return none
 */
 /**************************************************************************/
-void INA::showDataValue(nmea_index_t idx, int n) {
+void INA_Core::showDataValue(nmea_index_t idx, int n) {
   Serial.print("idx: ");
   if (idx < 10)
     Serial.print(" ");
   Serial.print(idx);
   Serial.print(", ");
-  Serial.print(val[idx].label);
+  const nmea_datadef_t *def = getDataDef(idx);
+  Serial.print(def->label ? def->label : "NUL");
   Serial.print(", ");
-  Serial.print(val[idx].latest, 4);
+  Serial.print(state.latest[idx], 4);
   Serial.print(", ");
-  Serial.print(val[idx].smoothed, 4);
+  Serial.print(getSmoothed(idx), 4);
   Serial.print(", at ");
-  Serial.print(val[idx].lastUpdate);
+  Serial.print(state.lastUpdate[idx]);
   Serial.print(" ms, tau = ");
-  Serial.print(val[idx].response);
+  Serial.print(def->response);
   Serial.print(" ms, type:");
-  Serial.print(val[idx].type);
+  Serial.print(def->type);
   Serial.print(",  ockam:");
-  Serial.print(val[idx].ockam);
-  if (val[idx].hist) {
+  Serial.print(def->ockam);
+  if (meta[idx].hist) {
     Serial.print("\n     History at ");
-    Serial.print(val[idx].hist->historyInterval);
+    Serial.print(meta[idx].hist->historyInterval);
     Serial.print(" second intervals:  ");
-    Serial.print(val[idx].hist->data[val[idx].hist->n - 1]);
-    for (unsigned i = val[idx].hist->n - 2;
-         i >= max(val[idx].hist->n - n, (unsigned)0);
-         i--) { // most recent first
-      Serial.print(", ");
-      Serial.print(val[idx].hist->data[i]);
+    unsigned count = historyCount(idx);
+    // most recent first
+    for (unsigned i = 0; i < count && i < (unsigned)n; i++) {
+      if (i > 0)
+        Serial.print(", ");
+      Serial.print(historyValue(idx, count - 1 - i));
     }
   }
   Serial.print("\n");
@@ -472,8 +1066,9 @@ void INA::showDataValue(nmea_index_t idx, int n) {
     @return true if a compound angle requiring 3 contiguos data values.
 */
 /**************************************************************************/
-bool INA::isCompoundAngle(nmea_index_t idx) {
-  if ((int)(val[idx].type / 10) == 1) // angle with sin/cos component recording
+bool INA_Core::isCompoundAngle(nmea_index_t idx) {
+  if ((int)(getDataDef(idx)->type / 10) ==
+      1) // angle with sin/cos component recording
     return true;
   return false;
 }
@@ -487,7 +1082,7 @@ bool INA::isCompoundAngle(nmea_index_t idx) {
     @return The angle in -180 to 180 degree range.
 */
 /**************************************************************************/
-nmea_float_t INA::boatAngle(nmea_float_t s, nmea_float_t c) {
+nmea_float_t INA_Core::boatAngle(nmea_float_t s, nmea_float_t c) {
   // put the sin angle in -90 to 90 range
   nmea_float_t sAng = asin(s) * (nmea_float_t)RAD_TO_DEG;
   while (sAng < -90)
@@ -528,7 +1123,7 @@ nmea_float_t INA::boatAngle(nmea_float_t s, nmea_float_t c) {
     @return The angle in 0 to 360 degree range.
 */
 /**************************************************************************/
-nmea_float_t INA::compassAngle(nmea_float_t s, nmea_float_t c) {
+nmea_float_t INA_Core::compassAngle(nmea_float_t s, nmea_float_t c) {
   nmea_float_t ang = boatAngle(s, c);
   if (ang < 5000) { // if reasonable range
     while (ang < 0)
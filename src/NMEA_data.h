@@ -20,6 +20,42 @@
 typedef NMEA_FLOAT_T
     nmea_float_t; ///< the type of variables to use for floating point
 
+#ifndef NMEA_HISTORY_TIERS
+#define NMEA_HISTORY_TIERS                                                     \
+  2 ///< most coarser tiers a history can have on top of its own samples
+#endif
+
+/**************************************************************************/
+/*!
+  One point of a coarse history tier, summarizing the samples of the tier
+  below it that fell in its interval. Same scaled integers as the history.
+ **************************************************************************/
+typedef struct {
+  int16_t min;  ///< smallest sample in the interval
+  int16_t mean; ///< average of the samples in the interval
+  int16_t max;  ///< largest sample in the interval
+} nmea_history_point_t;
+
+/**************************************************************************/
+/*!
+  A coarser tier of a history, added with addHistoryTier(). Every factor
+  points of the tier below are rolled up into one min/mean/max point here,
+  so each tier reaches further back in time than the one below it for
+  the same amount of memory. Stored as a ring, like the history itself.
+ **************************************************************************/
+typedef struct {
+  nmea_history_point_t *data = NULL; ///< ring of points, oldest at head once
+                                     ///< full
+  unsigned n = 0;                    ///< number of points in the ring
+  unsigned head = 0;                 ///< point the next roll up goes into
+  unsigned count = 0;                ///< number of points recorded, up to n
+  uint16_t factor = 1; ///< points of the tier below per point of this one
+  uint16_t taken = 0;  ///< points of the tier below in the current roll up
+  int32_t sum = 0;     ///< sum of their means so far
+  int16_t min = 0;     ///< smallest of their mins so far
+  int16_t max = 0;     ///< largest of their maxes so far
+} nmea_history_tier_t;
+
 /**************************************************************************/
 /*!
   Struct to contain all the details associated with the history of an NMEA
@@ -32,17 +68,77 @@ typedef NMEA_FLOAT_T
   Only some tags have history in order to save memory. Most of the memory
   cost is directly in the array.
 
+  The array is a ring: a new value overwrites the oldest one at head, so
+  recording a value costs the same whatever the size of the history. Use
+  historyValue() or copyHistory() to read it back oldest first.
+
   192 history values taken every 20 seconds covers just over an hour.
+  Coarser tiers from addHistoryTier() can stretch that, e.g. 144 points of
+  5 minutes and 168 of an hour give half a day and a week of trend.
  **************************************************************************/
 typedef struct {
-  int16_t *data = NULL;          ///< array of ints, oldest first
+  int16_t *data = NULL;          ///< ring of ints, oldest at head once full
   unsigned n = 0;                ///< number of history array elements
+  unsigned head = 0;             ///< element the next value goes into
+  unsigned count = 0;            ///< number of values recorded, up to n
   uint32_t lastHistory = 0;      ///< millis() when history was last updated
   uint16_t historyInterval = 20; ///< seconds between history updates
   nmea_float_t scale = 1.0;      ///< history = (smoothed - offset) * scale
   nmea_float_t offset = 0.0;     ///< value = (float) history / scale + offset
+  uint8_t nTiers = 0;            ///< number of coarser tiers in use
+  nmea_history_tier_t tiers[NMEA_HISTORY_TIERS]; ///< coarser tiers, finest
+                                                 ///< first
 } nmea_history_t;
 
+/**************************************************************************/
+/*!
+  Why the last initHistory() or addHistoryTier() call failed, from
+  historyError().
+ **************************************************************************/
+typedef enum {
+  NMEA_HISTORY_OK = 0,        ///< the last call succeeded
+  NMEA_HISTORY_BAD_INDEX,     ///< no such data value, or it has no history
+  NMEA_HISTORY_BAD_TIER,      ///< factor < 2, n == 0 or no tiers left
+  NMEA_HISTORY_NO_HEAP,       ///< malloc() failed
+  NMEA_HISTORY_ARENA_FULL     ///< not enough left in the history arena
+} nmea_history_error_t;
+
+/**************************************************************************/
+/*!
+  Running statistics over the last n raw values of a data value, added with
+  initStats() and kept up to date by newDataValue() at a constant cost per
+  value. Mean and variance are sliding Welford moments; min and max come
+  from monotonic queues of positions in the value ring, so the oldest
+  value drops out of all of them in one step.
+ **************************************************************************/
+typedef struct {
+  nmea_float_t *data = NULL; ///< ring of the last n values
+  uint16_t *minq = NULL;     ///< ring of positions in data, values rising
+  uint16_t *maxq = NULL;     ///< ring of positions in data, values falling
+  uint16_t n = 0;            ///< values in the window
+  uint16_t head = 0;         ///< position the next value goes into
+  uint16_t count = 0;        ///< values recorded, up to n
+  uint16_t minFront = 0;     ///< oldest entry of minq
+  uint16_t minCount = 0;     ///< entries in minq
+  uint16_t maxFront = 0;     ///< oldest entry of maxq
+  uint16_t maxCount = 0;     ///< entries in maxq
+  double mean = 0;           ///< mean of the values in the window
+  double m2 = 0; ///< sum of squared differences from the mean, in double as
+                 ///< a value leaving the window cancels most of it
+} nmea_stats_window_t;
+
+/**************************************************************************/
+/*!
+  The statistics of a data value over its window, from getStats().
+ **************************************************************************/
+typedef struct {
+  uint16_t count;      ///< values the statistics cover, 0 if none
+  nmea_float_t min;    ///< smallest value
+  nmea_float_t max;    ///< largest value
+  nmea_float_t mean;   ///< average value
+  nmea_float_t stddev; ///< sample standard deviation, 0 for under 2 values
+} nmea_stats_t;
+
 /**************************************************************************/
 /*!
     Type to characterize the type of value stored in a data value struct.
@@ -71,29 +167,6 @@ typedef enum {
       30 ///< A time stored in HHMMSS format like it comes in from the GPS
 } nmea_value_type_t;
 
-/**************************************************************************/
-/*!
-    Struct to contain all the details associated with an NMEA data value that
-    can be tracked through time to see how it changes, carries a label, units,
-    and a format string to determine how it is displayed. Memory footprint
-    of about 32 bytes per data value, so not tenable in small memory spaces.
-*/
-/**************************************************************************/
-typedef struct {
-  nmea_float_t latest = 0.0; ///< the most recently obtained value
-  nmea_float_t smoothed =
-      0.0;                  ///< smoothed value based on weight of dt/response
-  uint32_t lastUpdate = 0;  ///< millis() when latest was last set
-  uint16_t response = 1000; ///< time constant in millis for smoothing
-  nmea_value_type_t type =
-      NMEA_SIMPLE_FLOAT; ///< type of float data value represented
-  byte ockam = 0; ///< the corresponding Ockam Instruments tag number, 0-128
-  nmea_history_t *hist = NULL; ///< pointer to history, if any
-  char *label = NULL;          ///< pointer to quantity label, if any
-  char *unit = NULL;           ///< pointer to units label, if any
-  char *fmt = NULL;            ///< pointer to format string, if any
-} nmea_datavalue_t;
-
 /**************************************************************************/
 /*!
     Type to provide an index into the array of data values for different
@@ -177,4 +250,126 @@ typedef enum {
                  ///< but does define size of data value array required.
 } nmea_index_t;  ///< Indices for data values expected to change often with time
 
+#ifndef NMEA_DATA_OVERRIDES
+#define NMEA_DATA_OVERRIDES                                                    \
+  4 ///< data values before NMEA_USR_00 initDataValue() can change from their
+    ///< definition; the user data values each have a slot of their own
+#endif
+#ifndef NMEA_MAX_SUBSCRIPTIONS
+#define NMEA_MAX_SUBSCRIPTIONS                                                 \
+  8 ///< callbacks subscribe() can register across all data values
+#endif
+#define NMEA_USR_COUNT                                                         \
+  (NMEA_MAX_INDEX - NMEA_USR_00) ///< number of data values for the sketch
+
+/**************************************************************************/
+/*!
+    What an NMEA data value is: the label, units and format string that
+    determine how it is displayed, and how it is smoothed. The library
+    keeps these in a constexpr table in flash, and takes the ones for
+    NMEA_USR_00 onwards from nmeaUserDefs[]. Make them with nmeaDataDef().
+*/
+/**************************************************************************/
+typedef struct {
+  const char *label;      ///< pointer to quantity label, if any
+  const char *fmt;        ///< pointer to format string, if any
+  const char *unit;       ///< pointer to units label, if any
+  uint16_t response;      ///< time constant in millis for smoothing
+  nmea_value_type_t type; ///< type of float data value represented
+  byte ockam; ///< the corresponding Ockam Instruments tag number, 0-128
+} nmea_datadef_t;
+
+/**************************************************************************/
+/*!
+    @brief Describe a data value at compile time
+    @param label The quantity label
+    @param fmt A sprintf format for the value, e.g. "%6.2f"
+    @param unit The units, e.g. "Deg Mag"
+    @param type The type of data contained in the value. A compound angle
+    type needs the next two data values to be simple floats for its sine
+    and cosine.
+    @param response Time constant for smoothing in ms, 0 for none
+    @param ockam The corresponding Ockam Instruments tag number
+    @return The definition
+*/
+/**************************************************************************/
+constexpr nmea_datadef_t nmeaDataDef(const char *label, const char *fmt = NULL,
+                                     const char *unit = NULL,
+                                     nmea_value_type_t type = NMEA_SIMPLE_FLOAT,
+                                     uint16_t response = 1000, byte ockam = 0) {
+  return {label, fmt, unit, response, type, ockam};
+}
+
+/**************************************************************************/
+/*!
+    Describes the data values NMEA_USR_00 onwards. The library has a weak
+    definition with every entry nmeaDataDef("NUL"); define the array in the
+    sketch to give them labels, formats and smoothing at compile time:
+
+      const nmea_datadef_t nmeaUserDefs[NMEA_USR_COUNT] = {
+          nmeaDataDef("Tank", "%6.0f", "%"), ...};
+*/
+/**************************************************************************/
+extern const nmea_datadef_t nmeaUserDefs[NMEA_USR_COUNT];
+
+/**************************************************************************/
+/*!
+    The parts of an NMEA data value that are set up at run time, all zero
+    until then so construction is a plain fill.
+*/
+/**************************************************************************/
+typedef struct {
+  nmea_history_t *hist = NULL; ///< pointer to history, if any
+  nmea_stats_window_t *stats = NULL; ///< running statistics, if any
+  uint8_t custom = 0; ///< 1 + the initDataValue() override in use, or 0 for
+                      ///< the compile time definition. NMEA_USR_00 onwards
+                      ///< use their own slot in userDefs, so it is 0 or 1.
+  uint8_t sub = 0;    ///< 1 + the first subscription to the value, or 0
+} nmea_datameta_t;
+
+/**************************************************************************/
+/*!
+    A function subscribe() calls when a data value changes significantly.
+    It gets the data index, the new value and the arg it was registered
+    with.
+*/
+/**************************************************************************/
+typedef void (*nmea_data_callback_t)(nmea_index_t idx, nmea_float_t value,
+                                     void *arg);
+
+/**************************************************************************/
+/*!
+    A callback registered with subscribe(), and what it was last sent.
+*/
+/**************************************************************************/
+typedef struct {
+  nmea_data_callback_t callback = NULL; ///< function to call, NULL if unused
+  void *arg = NULL;                     ///< passed back to the callback
+  nmea_float_t absBand = 0; ///< change needed, in the units of the value
+  nmea_float_t relBand = 0; ///< change needed, as a fraction of the value
+  uint32_t minInterval = 0; ///< least ms between two calls
+  nmea_float_t lastValue = 0; ///< value the callback was last called with
+  uint32_t lastCall = 0;      ///< millis() of the last call
+  bool called = false;        ///< true once the callback has been called
+  uint8_t idx = 0;            ///< the data value subscribed to
+  uint8_t next = 0;           ///< 1 + the next subscription to it, or 0
+} nmea_subscription_t;
+
+/**************************************************************************/
+/*!
+    The parts of all the NMEA data values that change as new values come
+    in, one array per field indexed by nmea_index_t. Updates and reads only
+    touch these few contiguous arrays, not the display details in
+    nmea_datadef_t, and all the latest values can be copied out at once.
+*/
+/**************************************************************************/
+typedef struct {
+  nmea_float_t latest[NMEA_MAX_INDEX];   ///< the most recently obtained values
+  nmea_float_t smoothed[NMEA_MAX_INDEX]; ///< smoothed values based on weight
+                                         ///< of dt/response
+  uint32_t lastUpdate[NMEA_MAX_INDEX];   ///< millis() when latest was last set
+  uint32_t lastSmoothed[NMEA_MAX_INDEX]; ///< millis() when smoothed was last
+                                         ///< worked out
+} nmea_datastate_t;
+
 #endif // _NMEA_DATA_H
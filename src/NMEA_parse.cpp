@@ -32,184 +32,120 @@
     @return True if successfully parsed, false if fails check or parsing
 */
 /**************************************************************************/
-bool INA::parse(char *nmea) {
+bool INA_Core::parse(char *nmea) {
   if (!check(nmea))
     return false;
-  // passed the check, so there's a valid source in thisSource and a valid
-  // sentence in thisSentence
-  char *p = nmea; // Pointer to move through the sentence -- good parsers are
-                  // non-destructive
-  p = strchr(p, ',') + 1; // Skip to char after the next comma, then check.
-
-  // This may look inefficient, but an M0 will get down the list in about 1 us /
-  // strcmp()! Put the GPS sentences from INA at the top to make
-  // pruning excess code easier. Otherwise, keep them alphabetical for ease of
-  // reading.
-  if (!strcmp(thisSentence, "GGA")) { //************************************GGA
-    parseTime(p);
-    p = strchr(p, ',') + 1; // parse time with specialized function
-    // parse out both latitude and direction, then go to next field, or fail
-    if (parseCoord(p, &latitudeDegrees, &latitude, &latitude_fixed, &lat))
-      newDataValue(NMEA_LAT, latitudeDegrees);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    // parse out both longitude and direction, then go to next field, or fail
-    if (parseCoord(p, &longitudeDegrees, &longitude, &longitude_fixed, &lon))
-      newDataValue(NMEA_LON, longitudeDegrees);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p)) { // if it's a , (or a * at end of sentence) the value is
-                       // not included
-      fixquality = atoi(p); // needs additional processing
-      if (fixquality > 0) {
-        fix = true;
-        lastFix = sentTime;
-      } else
-        fix = false;
-    }
-    p = strchr(p, ',') + 1; // then move on to the next
-    // Most can just be parsed with atoi() or atof(), then move on to the next.
-    if (!isEmpty(p))
-      satellites = atoi(p);
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      newDataValue(NMEA_HDOP, HDOP = atof(p));
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      altitude = atof(p);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1; // skip the units
-    if (!isEmpty(p))
-      geoidheight = atof(p); // skip the rest
-
-  } else if (!strcmp(thisSentence, "RMC")) { //*****************************RMC
-    parseTime(p);
-    p = strchr(p, ',') + 1;
-    parseFix(p);
-    p = strchr(p, ',') + 1;
-    // parse out both latitude and direction, then go to next field, or fail
-    if (parseCoord(p, &latitudeDegrees, &latitude, &latitude_fixed, &lat))
-      newDataValue(NMEA_LAT, latitudeDegrees);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    // parse out both longitude and direction, then go to next field, or fail
-    if (parseCoord(p, &longitudeDegrees, &longitude, &longitude_fixed, &lon))
-      newDataValue(NMEA_LON, longitudeDegrees);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      newDataValue(NMEA_SOG, speed = atof(p));
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      newDataValue(NMEA_COG, angle = atof(p));
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p)) {
-      uint32_t fulldate = atof(p);
-      day = fulldate / 10000;
-      month = (fulldate % 10000) / 100;
-      year = (fulldate % 100);
-      lastDate = sentTime;
-    } // skip the rest
-
-  } else if (!strcmp(thisSentence, "GLL")) { //*****************************GLL
-    // parse out both latitude and direction, then go to next field, or fail
-    if (parseCoord(p, &latitudeDegrees, &latitude, &latitude_fixed, &lat))
-      newDataValue(NMEA_LAT, latitudeDegrees);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    // parse out both longitude and direction, then go to next field, or fail
-    if (parseCoord(p, &longitudeDegrees, &longitude, &longitude_fixed, &lon))
-      newDataValue(NMEA_LON, longitudeDegrees);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    parseTime(p);
-    p = strchr(p, ',') + 1;
-    parseFix(p); // skip the rest
-
-  } else if (!strcmp(thisSentence, "GSA")) { //*****************************GSA
-    p = strchr(p, ',') + 1; // skip selection mode
-    if (!isEmpty(p))
-      fixquality_3d = atoi(p);
-    p = strchr(p, ',') + 1;
-    // skip 12 Satellite PDNs without interpreting them
-    for (int i = 0; i < 12; i++)
-      p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      PDOP = atof(p);
-    p = strchr(p, ',') + 1;
-    // parse out HDOP, we also parse this from the GGA sentence. Chipset should
-    // report the same for both
-    if (!isEmpty(p))
-      newDataValue(NMEA_HDOP, HDOP = atof(p));
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      VDOP = atof(p); // last before checksum
-
-  } else if (!strcmp(thisSentence, "TOP")) { //*****************************TOP
-    p = strchr(p, ',') + 1;
-    parseAntenna(p);
+  return parseSeq();
+}
+
+/**************************************************************************/
+/*!
+    @brief Run parseFields() inside the write side of the sequence lock
+    snapshot() reads with. The writer never waits: it makes the count odd,
+    updates the values and makes it even again, and a reader that saw the
+    count change copies again.
+    @return What parseFields() returned
+*/
+/**************************************************************************/
+bool INA_Core::parseSeq(void) {
+  uint32_t seq = snapSeq.load(std::memory_order_relaxed);
+  snapSeq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  bool parsed = parseFields();
+  snapSeq.store(seq + 2, std::memory_order_release);
+  return parsed;
+}
+
+/**************************************************************************/
+/*!
+    @brief Run the handler for a sentence that has passed check(), or the
+    streaming decoder, and update the relevant variables. There's a valid
+    source in thisSource, a valid sentence in thisSentence, and the start of
+    every field in fields. field(n) is the n-th comma separated field after
+    the sentence id, and reads as an empty field if the sentence is too
+    short to have it.
+    @return True if successfully parsed, false if the sentence isn't handled
+*/
+/**************************************************************************/
+bool INA_Core::parseFields(void) {
+  // check() left the sentence id packed in thisKey, so a single switch finds
+  // the handler, however far down the list it is. Put the GPS sentences from
+  // INA at the top to make pruning excess code easier. Otherwise, keep them
+  // alphabetical for ease of reading.
+  switch (thisKey) {
+  case nmeaKey("GGA"): //****************************************************GGA
+  case nmeaKey("RMC"): //****************************************************RMC
+  case nmeaKey("GLL"): //****************************************************GLL
+  case nmeaKey("GSA"): //****************************************************GSA
+  case nmeaKey("GSV"): //****************************************************GSV
+    if (!parseGPS())
+      return false;
+    break;
+
+  case nmeaKey("TOP"): { //**************************************************TOP
+    parseAntenna(field(2));
+    break;
   }
 
 #ifdef NMEA_EXTENSIONS // Sentences not required for basic GPS functionality
-  else if (!strcmp(thisSentence, "APB")) { //*******************************APB
+  case nmeaKey("APB"): { //**************************************************APB
     // from Actisense NGW-1 from SH CP150C
     return false;
+  }
 
-  } else if (!strcmp(thisSentence, "DBT")) { //*****************************DBT
+  case nmeaKey("DBT"): { //**************************************************DBT
     // from Actisense NGW-1
     // feet, metres, fathoms below transducer coerced to water depth from
     // surface in metres
-    if (!isEmpty(p))
+    char *p;
+    if (!isEmpty(p = field(1)))
       newDataValue(NMEA_DEPTH,
-                   (nmea_float_t)atof(p) * 0.3048f + depthToTransducer);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      newDataValue(NMEA_DEPTH, (nmea_float_t)atof(p) + depthToTransducer);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
+                   parseFloat(p) * 0.3048f + depthToTransducer);
+    if (!isEmpty(p = field(3)))
+      newDataValue(NMEA_DEPTH, parseFloat(p) + depthToTransducer);
+    if (!isEmpty(p = field(5)))
       newDataValue(NMEA_DEPTH,
-                   (nmea_float_t)atof(p) * 6 * 0.3048f + depthToTransducer);
-
-  } else if (!strcmp(thisSentence, "DPT")) { //*****************************DPT
-    // from Actisense NGW-1
-    return false;
+                   parseFloat(p) * 6 * 0.3048f + depthToTransducer);
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "GSV")) { //*****************************GSV
+  case nmeaKey("DPT"): { //**************************************************DPT
     // from Actisense NGW-1
     return false;
+  }
 
-  } else if (!strcmp(thisSentence, "HDG")) { //*****************************HDG
+  case nmeaKey("HDG"): { //**************************************************HDG
     // from Actisense NGW-1 from SH CP150C
     return false;
+  }
 
-  } else if (!strcmp(thisSentence, "HDM")) { //*****************************HDM
-    if (!isEmpty(p))
-      newDataValue(NMEA_HDG, atof(p)); // skip the rest
+  case nmeaKey("HDM"): { //**************************************************HDM
+    char *p;
+    if (!isEmpty(p = field(1)))
+      newDataValue(NMEA_HDG, parseFloat(p)); // skip the rest
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "HDT")) { //*****************************HDT
-    if (!isEmpty(p))
-      newDataValue(NMEA_HDT, atof(p)); // skip the rest
+  case nmeaKey("HDT"): { //**************************************************HDT
+    char *p;
+    if (!isEmpty(p = field(1)))
+      newDataValue(NMEA_HDT, parseFloat(p)); // skip the rest
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "MDA")) { //*****************************MDA
+  case nmeaKey("MDA"): { //**************************************************MDA
     // from Actisense NGW-1
-    if (!isEmpty(p))
-      newDataValue(NMEA_BAROMETER, atof(p) * 3386.39);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      newDataValue(NMEA_BAROMETER, atof(p) * 100000);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
+    char *p;
+    if (!isEmpty(p = field(1)))
+      newDataValue(NMEA_BAROMETER, parseFloat(p) * 3386.39);
+    if (!isEmpty(p = field(3)))
+      newDataValue(NMEA_BAROMETER, parseFloat(p) * 100000);
     nmea_float_t T = 100000.;
     char u = 'C';
-    if (!isEmpty(p))
-      T = atof(p);
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
+    if (!isEmpty(p = field(5)))
+      T = parseFloat(p);
+    if (!isEmpty(p = field(6)))
       u = *p;
-    p = strchr(p, ',') + 1;
     if (u != 'C') {
       T = (T - 32) / 1.8f;
       u = 'C';
@@ -218,28 +154,28 @@ bool INA::parse(char *nmea) {
       newDataValue(NMEA_TEMPERATURE_AIR, T);
     T = 100000.;
     u = 'C';
-    if (!isEmpty(p))
-      T = atof(p);
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
+    if (!isEmpty(p = field(7)))
+      T = parseFloat(p);
+    if (!isEmpty(p = field(8)))
       u = *p;
-    p = strchr(p, ',') + 1;
     if (u != 'C') {
       T = (T - 32) / 1.8f;
       u = 'C';
     }
     if (T < 1000)
       newDataValue(NMEA_TEMPERATURE_WATER, T);
-    if (!isEmpty(p))
-      newDataValue(NMEA_HUMIDITY, atof(p)); // skip the rest
+    if (!isEmpty(p = field(9)))
+      newDataValue(NMEA_HUMIDITY, parseFloat(p)); // skip the rest
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "MTW")) { //*****************************MTW
+  case nmeaKey("MTW"): { //**************************************************MTW
+    char *p;
     nmea_float_t T = 100000.;
     char u = 'C';
-    if (!isEmpty(p))
-      T = atof(p);
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
+    if (!isEmpty(p = field(1)))
+      T = parseFloat(p);
+    if (!isEmpty(p = field(2)))
       u = *p; // last before checksum
     if (u != 'C') {
       T = (T - 32) / 1.8f;
@@ -247,31 +183,31 @@ bool INA::parse(char *nmea) {
     }
     if (T < 1000)
       newDataValue(NMEA_TEMPERATURE_WATER, T);
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "MWD")) { //*****************************MWD
+  case nmeaKey("MWD"): { //**************************************************MWD
     // from Actisense NGW-1
     return false;
+  }
 
-  } else if (!strcmp(thisSentence, "MWV")) { //*****************************MWV
+  case nmeaKey("MWV"): { //**************************************************MWV
     // from Actisense NGW-1
+    char *p;
     nmea_float_t ang = 100000.;
     char ref = 'T';
-    if (!isEmpty(p))
-      ang = atof(p);
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
+    if (!isEmpty(p = field(1)))
+      ang = parseFloat(p);
+    if (!isEmpty(p = field(2)))
       ref = *p;
-    p = strchr(p, ',') + 1;
     nmea_float_t spd = 100000.;
-    if (!isEmpty(p))
-      spd = atof(p);
-    p = strchr(p, ',') + 1;
+    if (!isEmpty(p = field(3)))
+      spd = parseFloat(p);
     char units = 'N';
-    if (!isEmpty(p))
+    if (!isEmpty(p = field(4)))
       units = *p;
-    p = strchr(p, ',') + 1;
     char stat = 'A';
-    if (!isEmpty(p))
+    if (!isEmpty(p = field(5)))
       stat = *p; // last before checksum
     if (units == 'K') {
       spd /= 1.6f;
@@ -294,8 +230,10 @@ bool INA::parse(char *nmea) {
       if (spd < 1000.0f && stat == 'A')
         newDataValue(NMEA_TWS, spd);
     }
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "RMB")) { //*****************************RMB
+  case nmeaKey("RMB"): { //**************************************************RMB
     // from Actisense NGW-1 from SH CP150C
     // RMB Recommended Minimum Navigation Information
     //       1 2   3 4    5    6       7 8        9 10  11 12  13 14
@@ -312,26 +250,22 @@ bool INA::parse(char *nmea) {
     // 11) Bearing to destination in degrees True
     // 12) Destination closing velocity in knots
     // 13) Arrival Status, A = Arrival Circle Entered 14) Checksum
-    p = strchr(p, ',') + 1; // skip status
+    char *p;
     nmea_float_t xte = 100000.;
     char xteDir = 'X';
-    if (!isEmpty(p))
-      xte = atof(p);
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
+    if (!isEmpty(p = field(2))) // skip status
+      xte = parseFloat(p);
+    if (!isEmpty(p = field(3)))
       xteDir = *p;
-    p = strchr(p, ',') + 1;
     if (xte < 10000.0f && xteDir != 'X') {
       if (xteDir == 'L')
         xte *= -1.0f;
       newDataValue(NMEA_XTE, xte);
     }
-    if (!isEmpty(p))
+    if (!isEmpty(p = field(4)))
       parseStr(toID, p, NMEA_MAX_WP_ID);
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
+    if (!isEmpty(p = field(5)))
       parseStr(fromID, p, NMEA_MAX_WP_ID);
-    p = strchr(p, ',') + 1;
     nmea_float_t latitudeWP = 0;
     nmea_float_t longitudeWP = 0;
     int32_t latitude_fixedWP = 0;
@@ -341,133 +275,128 @@ bool INA::parse(char *nmea) {
     char latWP = 'X';
     char lonWP = 'X';
 
-    // parse out both latitude and direction for WayPoint, then go to next
-    // field, or fail
-    if (!isEmpty(p)) {
-      if (!parseCoord(p, &latitudeDegreesWP, &latitudeWP, &latitude_fixedWP,
-                      &latWP))
+    // parse out both latitude and direction for WayPoint, or fail
+    if (!isEmpty(p = field(6))) {
+      if (!parseCoord(p, field(7), &latitudeDegreesWP, &latitudeWP,
+                      &latitude_fixedWP, &latWP))
         return false;
       else
         newDataValue(NMEA_LATWP, latitudeDegreesWP);
     }
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    // parse out both longitude and direction for WayPoint, then go to next
-    // field, or fail
-    if (!isEmpty(p)) {
-      if (!parseCoord(p, &longitudeDegreesWP, &longitudeWP, &longitude_fixedWP,
-                      &lonWP))
+    // parse out both longitude and direction for WayPoint, or fail
+    if (!isEmpty(p = field(8))) {
+      if (!parseCoord(p, field(9), &longitudeDegreesWP, &longitudeWP,
+                      &longitude_fixedWP, &lonWP))
         return false;
       else
         newDataValue(NMEA_LONWP, longitudeDegreesWP);
     }
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      newDataValue(NMEA_DISTWP, atof(p));
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      newDataValue(NMEA_COGWP, atof(p));
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      newDataValue(NMEA_VMGWP, atof(p)); // skip arrival flag
-
-  } else if (!strcmp(thisSentence, "ROT")) { //*****************************ROT
+    if (!isEmpty(p = field(10)))
+      newDataValue(NMEA_DISTWP, parseFloat(p));
+    if (!isEmpty(p = field(11)))
+      newDataValue(NMEA_COGWP, parseFloat(p));
+    if (!isEmpty(p = field(12)))
+      newDataValue(NMEA_VMGWP, parseFloat(p)); // skip arrival flag
+    break;
+  }
+
+  case nmeaKey("ROT"): { //**************************************************ROT
     return false;
+  }
 
-  } else if (!strcmp(thisSentence, "RPM")) { //*****************************RPM
+  case nmeaKey("RPM"): { //**************************************************RPM
     return false;
+  }
 
-  } else if (!strcmp(thisSentence, "RSA")) { //*****************************RSA
+  case nmeaKey("RSA"): { //**************************************************RSA
     // from Actisense NGW-1
     return false;
+  }
 
-  } else if (!strcmp(thisSentence, "TXT")) { //*****************************TXT
-    if (!isEmpty(p))
-      txtTot = atoi(p);
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      txtN = atoi(p);
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      txtID = atoi(p);
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
+  case nmeaKey("TXT"): { //**************************************************TXT
+    char *p;
+    if (!isEmpty(p = field(1)))
+      txtTot = parseInt(p);
+    if (!isEmpty(p = field(2)))
+      txtN = parseInt(p);
+    if (!isEmpty(p = field(3)))
+      txtID = parseInt(p);
+    if (!isEmpty(p = field(4)))
       parseStr(txtTXT, p, 61); // copy the text to NMEA TXT max of 61 characters
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "VDR")) { //*****************************VDR
+  case nmeaKey("VDR"): { //**************************************************VDR
     // from Actisense NGW-1
     return false;
+  }
 
-  } else if (!strcmp(thisSentence, "VHW")) { //*****************************VHW
+  case nmeaKey("VHW"): { //**************************************************VHW
     // from Actisense NGW-1
-    if (!isEmpty(p))
-      newDataValue(NMEA_HDT, atof(p));
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      newDataValue(NMEA_HDG, atof(p));
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      newDataValue(NMEA_VTW, atof(p)); // skip the other units
-
-  } else if (!strcmp(thisSentence, "VLW")) { //*****************************VLW
+    char *p;
+    if (!isEmpty(p = field(1)))
+      newDataValue(NMEA_HDT, parseFloat(p));
+    if (!isEmpty(p = field(3)))
+      newDataValue(NMEA_HDG, parseFloat(p));
+    if (!isEmpty(p = field(5)))
+      newDataValue(NMEA_VTW, parseFloat(p)); // skip the other units
+    break;
+  }
+
+  case nmeaKey("VLW"): { //**************************************************VLW
     // from Actisense NGW-1
-    if (!isEmpty(p))
-      newDataValue(NMEA_LOG, atof(p));
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      newDataValue(NMEA_LOGR, atof(p)); // skip the other units
-
-  } else if (!strcmp(thisSentence, "VPW")) { //*****************************VPW
+    char *p;
+    if (!isEmpty(p = field(1)))
+      newDataValue(NMEA_LOG, parseFloat(p));
+    if (!isEmpty(p = field(3)))
+      newDataValue(NMEA_LOGR, parseFloat(p)); // skip the other units
+    break;
+  }
+
+  case nmeaKey("VPW"): { //**************************************************VPW
     // knots, metres/s coerced to knots
+    char *p;
     nmea_float_t vmg = 100000.;
-    if (!isEmpty(p))
-      vmg = atof(p);
-    p = strchr(p, ',') + 1;
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      vmg = atof(p) * 0.3048 * 3600. / 6000.; // skip units
+    if (!isEmpty(p = field(1)))
+      vmg = parseFloat(p);
+    if (!isEmpty(p = field(3)))
+      vmg = parseFloat(p) * 0.3048 * 3600. / 6000.; // skip units
     if (vmg < 1000.0f)
       newDataValue(NMEA_VMG, vmg);
-  } else if (!strcmp(thisSentence, "VTG")) { //*****************************VTG
+    break;
+  }
+
+  case nmeaKey("VTG"): { //**************************************************VTG
     // from Actisense NGW-1 from SH CP150C
     return false;
+  }
 
-  } else if (!strcmp(thisSentence, "VWR")) { //*****************************VWR
+  case nmeaKey("VWR"): { //**************************************************VWR
     // from Actisense NGW-1
+    char *p;
     nmea_float_t ang = 1000.;
-    if (!isEmpty(p))
-      ang = atof(p);
-    p = strchr(p, ',') + 1;
+    if (!isEmpty(p = field(1)))
+      ang = parseFloat(p);
     char ref = ' ';
-    if (!isEmpty(p))
+    if (!isEmpty(p = field(2)))
       ref = *p;
-    p = strchr(p, ',') + 1;
     if (ref == 'L')
       ang *= -1;
     if (ang < 1000.0f)
       newDataValue(NMEA_AWA, ang);
     nmea_float_t ws = 0.0;
     char units = 'X';
-    if (!isEmpty(p))
-      ws = atof(p);
-    p = strchr(p, ',') + 1; // knots
-    if (!isEmpty(p))
-      units = *p;
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
-      ws = atof(p);
-    p = strchr(p, ',') + 1; // meters / second
-    if (!isEmpty(p))
+    if (!isEmpty(p = field(3)))
+      ws = parseFloat(p); // knots
+    if (!isEmpty(p = field(4)))
       units = *p;
-    p = strchr(p, ',') + 1; // M
-    if (!isEmpty(p))
-      ws = atof(p);
-    p = strchr(p, ',') + 1; // kilometers / hour can be converted back to knots
-    if (!isEmpty(p))
+    if (!isEmpty(p = field(5)))
+      ws = parseFloat(p); // meters / second
+    if (!isEmpty(p = field(6)))
+      units = *p; // M
+    if (!isEmpty(p = field(7)))
+      ws = parseFloat(p); // kilometers / hour can be converted back to knots
+    if (!isEmpty(p = field(8)))
       units = *p; // last before checksum
     if (units == 'M') {
       ws *= 3.6f;
@@ -483,37 +412,41 @@ bool INA::parse(char *nmea) {
     } // convert miles / hr to knots
     if (units == 'N')
       newDataValue(NMEA_AWS, ws); // store the final result
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "WCV")) { //*****************************WCV
+  case nmeaKey("WCV"): { //**************************************************WCV
     // from SH CP150C
-    if (!isEmpty(p))
-      newDataValue(NMEA_VMGWP, atof(p)); // skip the rest
+    char *p;
+    if (!isEmpty(p = field(1)))
+      newDataValue(NMEA_VMGWP, parseFloat(p)); // skip the rest
+    break;
+  }
 
-  } else if (!strcmp(thisSentence, "XTE")) { //*****************************XTE
+  case nmeaKey("XTE"): { //**************************************************XTE
     // from Actisense NGW-1 from SH CP150C
-    p = strchr(p, ',') + 1; // skip status 1
-    p = strchr(p, ',') + 1; // skip status 2
+    char *p;
     nmea_float_t xte = 100000.;
     char xteDir = 'X';
-    if (!isEmpty(p))
-      xte = atof(p);
-    p = strchr(p, ',') + 1;
-    if (!isEmpty(p))
+    if (!isEmpty(p = field(3))) // skip status 1 and 2
+      xte = parseFloat(p);
+    if (!isEmpty(p = field(4)))
       xteDir = *p;
-    p = strchr(p, ',') + 1;
     if (xte < 10000.0f && xteDir != 'X') {
       if (xteDir == 'L')
         xte *= -1.0f;
       newDataValue(NMEA_XTE, xte);
     } // skip units
-
-  } else if (!strcmp(thisSentence, "ZDA")) { //*****************************ZDA
-    // from Actisense NGW-1
-    return false;
+    break;
   }
+
+  case nmeaKey("ZDA"): //****************************************************ZDA
+    if (!parseGPS())
+      return false;
+    break;
 #endif // NMEA_EXTENSIONS
 
-  else {
+  default:
     return false; // didn't find the required sentence definition
   }
 
@@ -524,42 +457,60 @@ bool INA::parse(char *nmea) {
   return true;
 }
 
+/**************************************************************************/
+/*!
+    @brief Latitude at the full resolution of latitude_fixed, which a float
+    latitudeDegrees can only hold to about a metre.
+    @return Latitude in signed decimal degrees
+*/
+/**************************************************************************/
+double INA_Core::latitudeDouble(void) { return latitude_fixed / 10000000.0; }
+
+/**************************************************************************/
+/*!
+    @brief Longitude at the full resolution of longitude_fixed, which a float
+    longitudeDegrees can only hold to about a metre.
+    @return Longitude in signed decimal degrees
+*/
+/**************************************************************************/
+double INA_Core::longitudeDouble(void) { return longitude_fixed / 10000000.0; }
+
 /**************************************************************************/
 /*!
     @brief Check an NMEA string for basic format, valid source ID and valid
     and valid sentence ID. Update the values of thisCheck, thisSource and
-    thisSentence.
+    thisSentence. The checksum is verified in the same single pass that
+    records where every field starts, so parse() can reach any field with
+    field() instead of walking the sentence again.
     @param nmea Pointer to the NMEA string
     @return True if well formed, false if it has problems
 */
 /**************************************************************************/
-bool INA::check(char *nmea) {
+bool INA_Core::check(char *nmea) {
   thisCheck = 0; // new check
   *thisSentence = *thisSource = 0;
-  if (*nmea != '$' && *nmea != '!')
+  if (*nmea != '$' && *nmea != '!') {
+    fields.base = nmea;
+    fields.n = 0;
     return false; // doesn't start with $ or !
-  else
-    thisCheck += NMEA_HAS_DOLLAR;
-  // do checksum check -- first look if we even have one -- ignore all but last
-  // *
-  char *ast = nmea; // not strchr(nmea,'*'); for first *
-  while (*ast)
-    ast++; // go to the end
-  while (*ast != '*' && ast > nmea)
-    ast--; // then back to * if it's there
-  if (*ast != '*')
-    return false; // there is no asterisk
-  else {
-    uint16_t sum = parseHex(*(ast + 1)) * 16; // extract checksum
-    sum += parseHex(*(ast + 2));
-    char *p = nmea; // check checksum
-    for (char *p1 = p + 1; p1 < ast; p1++)
-      sum ^= *p1;
-    if (sum != 0)
-      return false; // bad checksum :(
-    else
-      thisCheck += NMEA_HAS_CHECKSUM;
   }
+  thisCheck += NMEA_HAS_DOLLAR;
+  if (!nmea::split(nmea, NULL, fields))
+    return false;
+  thisCheck += NMEA_HAS_CHECKSUM;
+  return checkIds(nmea);
+}
+
+/**************************************************************************/
+/*!
+    @brief The part of check() that follows the checksum: find the source
+    and sentence ids, and decide if parse() handles the sentence. Updates
+    thisCheck, thisSource, thisSentence and thisKey.
+    @param nmea Pointer to the NMEA string
+    @return True if the ids are valid and the sentence is parseable
+*/
+/**************************************************************************/
+bool INA_Core::checkIds(char *nmea) {
   // extract source of variable length
   char *p = nmea + 1;
   const char *src = tokenOnList(p, sources);
@@ -570,24 +521,145 @@ bool INA::check(char *nmea) {
     return false;
   p += strlen(src);
   // extract sentence id and check if parsed
-  const char *snc = tokenOnList(p, sentences_parsed);
-  if (snc) {
-    strcpy(thisSentence, snc);
-    thisCheck += NMEA_HAS_SENTENCE_P + NMEA_HAS_SENTENCE;
-  } else { // check if known
-    snc = tokenOnList(p, sentences_known);
-    if (snc) {
-      strcpy(thisSentence, snc);
-      thisCheck += NMEA_HAS_SENTENCE;
+  thisKey = nmeaKey(p);
+  int known = sentenceCheck(thisKey);
+  if (known) {
+    strncpy(thisSentence, p, 3);
+    thisSentence[3] = 0;
+    thisCheck += known;
+    if (known != NMEA_HAS_SENTENCE_P + NMEA_HAS_SENTENCE)
       return false; // known but not parsed
-    } else {
-      parseStr(thisSentence, p, NMEA_MAX_SENTENCE_ID);
-      return false; // unknown
-    }
+  } else {
+    parseStr(thisSentence, p, NMEA_MAX_SENTENCE_ID);
+    return false; // unknown
   }
   return true; // passed all the tests
 }
 
+/**************************************************************************/
+/*!
+    @brief Advance the streaming decoder by one character of the line being
+    received. The checksum and the field table are built up as characters
+    arrive, so the sentence goes to the same handlers parse() uses the moment
+    its second checksum digit lands, without waiting for the end of the line
+    or scanning it again. Unlike check(), the first * ends the sentence.
+    @param c The character just stored in currentline
+    @param i Index of the character in currentline
+    @param t millis() when the character was received
+    @return True if the character completed a sentence that was parsed
+*/
+/**************************************************************************/
+bool INA_Core::streamChar(char c, uint8_t i, uint32_t t) {
+  if (i == 0) { // start of a new sentence
+    streamOK = (c == '$' || c == '!');
+    streamSum = 0;
+    streamAst = 0;
+    streamFields.base = currentline;
+    streamFields.start[0] = 1;
+    streamFields.n = 1;
+    return false;
+  }
+  if (!streamOK)
+    return false; // wait for the next line
+  if (i >= MAXLINELENGTH - 2) {
+    streamOK = false; // too long to end with a checksum
+    return false;
+  }
+  if (streamAst == 0) { // still in the body of the sentence
+    if (c < ' ' || c > '~')
+      streamOK = false; // not printable, so not NMEA
+    else if (c == '*')
+      streamAst = i;
+    else {
+      if (c == ',' && streamFields.n < NMEA_MAX_FIELDS)
+        streamFields.start[streamFields.n++] = i + 1;
+      streamSum ^= c;
+    }
+    return false;
+  }
+  if (!isxdigit(c)) {
+    streamOK = false; // checksum is not two hex digits
+    return false;
+  }
+  if (i < streamAst + 2)
+    return false; // wait for the second digit
+  streamOK = false; // only one try per sentence
+  currentline[i + 1] = 0; // end it here for the handlers, as parse() would
+
+  thisCheck = NMEA_HAS_DOLLAR;
+  *thisSentence = *thisSource = 0;
+  if (streamSum != parseHex(currentline[i - 1]) * 16 + parseHex(c))
+    return false; // bad checksum :(
+  thisCheck += NMEA_HAS_CHECKSUM;
+  fields = streamFields;
+  if (!checkIds(currentline))
+    return false;
+  sentTime = firstChar;
+  recvdTime = t;
+  if (!parseSeq())
+    return false;
+  streamParsed++;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Look up how far parse() gets with a sentence id. A single switch
+    on the packed id replaces searching lists of parsed and known names.
+    @param key The sentence id packed with nmeaKey()
+    @return NMEA_HAS_SENTENCE_P + NMEA_HAS_SENTENCE if parse() handles it,
+    NMEA_HAS_SENTENCE if it is known but not parsed, 0 if unknown
+*/
+/**************************************************************************/
+int INA_Core::sentenceCheck(uint32_t key) {
+  switch (key) {
+  case nmeaKey("GGA"): // parseable sentence ids
+  case nmeaKey("GLL"):
+  case nmeaKey("GSA"):
+  case nmeaKey("GSV"):
+  case nmeaKey("RMC"):
+  case nmeaKey("TOP"):
+#ifdef NMEA_EXTENSIONS
+  case nmeaKey("DBT"):
+  case nmeaKey("HDM"):
+  case nmeaKey("HDT"):
+  case nmeaKey("MDA"):
+  case nmeaKey("MTW"):
+  case nmeaKey("MWV"):
+  case nmeaKey("RMB"):
+  case nmeaKey("TXT"):
+  case nmeaKey("VHW"):
+  case nmeaKey("VLW"):
+  case nmeaKey("VPW"):
+  case nmeaKey("VWR"):
+  case nmeaKey("WCV"):
+  case nmeaKey("XTE"):
+  case nmeaKey("ZDA"):
+#endif
+    return NMEA_HAS_SENTENCE_P + NMEA_HAS_SENTENCE;
+
+#ifdef NMEA_EXTENSIONS
+  case nmeaKey("APB"): // known, but not parseable
+  case nmeaKey("DPT"):
+  case nmeaKey("HDG"):
+  case nmeaKey("MWD"):
+  case nmeaKey("ROT"):
+  case nmeaKey("RPM"):
+  case nmeaKey("RSA"):
+  case nmeaKey("VDR"):
+  case nmeaKey("VTG"):
+#else // make the lists short to save memory
+  case nmeaKey("DBT"): // known, but not parseable
+  case nmeaKey("HDM"):
+  case nmeaKey("HDT"):
+#endif
+    return NMEA_HAS_SENTENCE;
+
+  default:
+    return 0;
+  }
+}
+
 /**************************************************************************/
 /*!
     @brief Check if a token at the start of a string is on a list.
@@ -596,7 +668,7 @@ bool INA::check(char *nmea) {
     @return Pointer to the found token, or NULL if it fails
 */
 /**************************************************************************/
-const char *INA::tokenOnList(char *token, const char **list) {
+const char *INA_Core::tokenOnList(char *token, const char **list) {
   int i = 0; // index in the list
   while (strncmp(list[i], "ZZ", 2) &&
          i < 1000) { // stop at terminator and don't crash without it
@@ -617,13 +689,13 @@ const char *INA::tokenOnList(char *token, const char **list) {
     @return True if on the list, false if it fails check or is not on the list
 */
 /**************************************************************************/
-bool INA::onList(char *nmea, const char **list) {
+bool INA_Core::onList(char *nmea, const char **list) {
   if (!check(nmea)) // sets thisSentence if valid
     return false;   // not a valid sentence
   // stop at terminator with first two letters ZZ and don't crash without it
   for (int i = 0; strncmp(list[i], "ZZ", 2) && i < 1000; i++) {
-    // test for a match on the sentence name
-    if (!strcmp((const char *)list[i], (const char *)thisSentence))
+    // test for a match on the packed sentence name
+    if (strlen(list[i]) == 3 && nmeaKey(list[i]) == thisKey)
       return true;
   }
   return false; // couldn't find a match
@@ -639,8 +711,10 @@ bool INA::onList(char *nmea, const char **list) {
     angle range.
 
     Supersedes private functions parseLat(), parseLon(), parseLatDir(),
-    parseLonDir(), all previously called from parse().
+    parseLonDir(), all previously called from parse(). The decoding itself
+    is nmea::parseCoord().
     @param pStart Pointer to the location of the token in the NMEA string
+    @param pDir Pointer to the location of the direction token that follows
     @param angle Pointer to the angle to fill with value in degrees/minutes as
       received from the GPS (DDDMM.MMMM), unsigned
     @param angle_fixed Pointer to the fix point version latitude in decimal
@@ -652,64 +726,21 @@ bool INA::onList(char *nmea, const char **list) {
     @return true if successful, false if failed or no value
 */
 /**************************************************************************/
-bool INA::parseCoord(char *pStart, nmea_float_t *angleDegrees,
-                              nmea_float_t *angle, int32_t *angle_fixed,
-                              char *dir) {
-  char *p = pStart;
-  if (!isEmpty(p)) {
-    // get the number in DDDMM.mmmm format and break into components
-    char degreebuff[10] = {0}; // Ensure string is terminated after strncpy
-    char *e = strchr(p, '.');
-    if (e == NULL || e - p > 6)
-      return false;                // no decimal point in range
-    strncpy(degreebuff, p, e - p); // get DDDMM
-    long dddmm = atol(degreebuff);
-    long degrees = (dddmm / 100);         // truncate the minutes
-    long minutes = dddmm - degrees * 100; // remove the degrees
-    p = e;                                // start from the decimal point
-    nmea_float_t decminutes = atof(e); // the fraction after the decimal point
-    p = strchr(p, ',') + 1;            // go to the next field
-
-    // get the NSEW direction as a character
-    char nsew = 'X';
-    if (!isEmpty(p))
-      nsew = *p; // field is not empty
-    else
-      return false; // no direction provided
-
-    // set the various numerical formats to their values
-    long fixed = degrees * 10000000 + (minutes * 10000000) / 60 +
-                 (decminutes * 10000000) / 60;
-    nmea_float_t ang = degrees * 100 + minutes + decminutes;
-    nmea_float_t deg = fixed / (nmea_float_t)10000000.;
-    if (nsew == 'S' ||
-        nsew == 'W') { // fixed and deg are signed, but DDDMM.mmmm is not
-      fixed = -fixed;
-      deg = -deg;
-    }
-
-    // reject directions that are not NSEW
-    if (nsew != 'N' && nsew != 'S' && nsew != 'E' && nsew != 'W')
-      return false;
-
-    // reject angles that are out of range
-    if (nsew == 'N' || nsew == 'S')
-      if (abs(deg) > 90)
-        return false;
-    if (abs(deg) > 180)
-      return false;
-
-    // store in locations passed as args
-    if (angle != NULL)
-      *angle = ang;
-    if (angle_fixed != NULL)
-      *angle_fixed = fixed;
-    if (angleDegrees != NULL)
-      *angleDegrees = deg;
-    if (dir != NULL)
-      *dir = nsew;
-  } else
-    return false; // no number
+bool INA_Core::parseCoord(char *pStart, char *pDir, nmea_float_t *angleDegrees,
+                     nmea_float_t *angle, int32_t *angle_fixed, char *dir) {
+  int32_t fixed;
+  char nsew;
+  if (!nmea::parseCoord(pStart, pDir, &fixed, &nsew))
+    return false;
+  // store in locations passed as args
+  if (angle != NULL)
+    *angle = parseFloat(pStart);
+  if (angle_fixed != NULL)
+    *angle_fixed = fixed;
+  if (angleDegrees != NULL)
+    *angleDegrees = fixed / (nmea_float_t)10000000.;
+  if (dir != NULL)
+    *dir = nsew;
   return true;
 }
 
@@ -723,7 +754,7 @@ bool INA::parseCoord(char *pStart, nmea_float_t *angleDegrees,
     @return Pointer to the string buffer
 */
 /**************************************************************************/
-char *INA::parseStr(char *buff, char *p, int n) {
+char *INA_Core::parseStr(char *buff, char *p, int n) {
   char *e = strchr(p, ',');
   int len = 0;
   if (e) {
@@ -746,51 +777,261 @@ char *INA::parseStr(char *buff, char *p, int n) {
 
 /**************************************************************************/
 /*!
-    @brief Parse a part of an NMEA string for time. Independent of number
-    of decimal places after the '.'
-    @param p Pointer to the location of the token in the NMEA string
-    @return true if successful, false otherwise
+    @brief Turn a latitude or longitude in degrees * 10000000 back into the
+    DDDMM.mmmm form the GPS sent it in, for latitude and longitude
+    @param fixed The angle, signed
+    @return The angle as DDDMM.mmmm, unsigned
+*/
+/**************************************************************************/
+static nmea_float_t degreesMinutes(int32_t fixed) {
+  uint32_t angle = fixed < 0 ? -(uint32_t)fixed : fixed;
+  // 60 minutes in 10000000 parts of a degree
+  return (angle / 10000000) * 100 + (angle % 10000000) * (nmea_float_t)6e-6;
+}
+
+/**************************************************************************/
+/*!
+    @brief Decode a GPS sentence with nmea::decode(), the same code that
+    nmea::parse() uses, and copy what it found into the variables, the data
+    values and the epoch being gathered. The time goes first, so the rest
+    joins the right epoch. Only the fields the sentence actually carried are
+    copied, so an empty course or HDOP keeps the last one, as the getters and
+    the epoch have always shown.
+    @return True if the sentence was decoded
 */
 /**************************************************************************/
-bool INA::parseTime(char *p) {
-  if (!isEmpty(p)) { // get time
-    uint32_t time = atol(p);
-    hour = time / 10000;
-    minute = (time % 10000) / 100;
-    seconds = (time % 100);
-    char *dec = strchr(p, '.');
-    char *comstar = min(strchr(p, ','), strchr(p, '*'));
-    if (dec != NULL && comstar != NULL && dec < comstar)
-      milliseconds = atof(dec) * 1000;
-    else
-      milliseconds = 0;
+bool INA_Core::parseGPS(void) {
+  nmea_fix_t got;
+  if (!nmea::decode(thisKey, fields, got))
+    return false;
+  if (got.have & NMEA_FIX_TIME) {
+    hour = got.hour;
+    minute = got.minute;
+    seconds = got.seconds;
+    milliseconds = got.milliseconds;
     lastTime = sentTime;
-    return true;
+    epochTime();
   }
-  return false;
+  if (got.have & NMEA_FIX_DATE) {
+    day = got.day;
+    month = got.month;
+    year = got.year;
+    if (month >= 1 && month <= 12)
+      epochDay = nmea::daysFromCivil(2000 + year, month, day);
+    lastDate = sentTime;
+  }
+  if (got.have & NMEA_FIX_STATUS) {
+    fix = got.fix;
+    if (fix)
+      lastFix = sentTime;
+  }
+  if (got.have & NMEA_FIX_POSITION) {
+    latitude_fixed = got.latitude_fixed;
+    latitudeDegrees = latitude_fixed / (nmea_float_t)10000000.;
+    latitude = degreesMinutes(latitude_fixed);
+    lat = latitude_fixed < 0 ? 'S' : 'N';
+    newDataValue(NMEA_LAT, latitudeDegrees);
+    longitude_fixed = got.longitude_fixed;
+    longitudeDegrees = longitude_fixed / (nmea_float_t)10000000.;
+    longitude = degreesMinutes(longitude_fixed);
+    lon = longitude_fixed < 0 ? 'W' : 'E';
+    newDataValue(NMEA_LON, longitudeDegrees);
+  }
+  if (got.have & NMEA_FIX_ALTITUDE) {
+    altitude_fixed = got.altitude_fixed;
+    altitude = altitude_fixed / (nmea_float_t)10.;
+  }
+  if (got.have & NMEA_FIX_GEOID) {
+    geoidheight_fixed = got.geoidheight_fixed;
+    geoidheight = geoidheight_fixed / (nmea_float_t)10.;
+  }
+  if (got.have & NMEA_FIX_VELOCITY) {
+    speed_fixed = got.speed_fixed;
+    newDataValue(NMEA_SOG, speed = speed_fixed / (nmea_float_t)1000.);
+  }
+  if (got.have & NMEA_FIX_COURSE) { // empty when stationary, so keep the last
+    angle_fixed = got.angle_fixed;
+    newDataValue(NMEA_COG, angle = angle_fixed / (nmea_float_t)100.);
+  }
+  if (got.have & NMEA_FIX_QUALITY)
+    fixquality = got.fixquality;
+  if (got.have & NMEA_FIX_SATS)
+    satellites = got.satellites;
+  if (got.have & NMEA_FIX_DOP)
+    fixquality_3d = got.fixquality_3d;
+  if (got.have & NMEA_FIX_PDOP)
+    PDOP = got.PDOP;
+  if (got.have & NMEA_FIX_VDOP)
+    VDOP = got.VDOP;
+  if (got.have & NMEA_FIX_HDOP) // GGA and GSA both have it
+    newDataValue(NMEA_HDOP, HDOP = got.HDOP);
+  if (got.have & NMEA_FIX_INVIEW)
+    satellitesInView = got.satellitesInView;
+  epochSet(got.have & ~(NMEA_FIX_TIME | NMEA_FIX_PRESENT));
+  return true;
 }
 
 /**************************************************************************/
 /*!
-    @brief Parse a part of an NMEA string for whether there is a fix
-    @param p Pointer to the location of the token in the NMEA string
-    @return True if we parsed it, false if it has invalid data
+    @brief Start a new epoch if the time parseGPS() just found differs from
+    the one being gathered, publishing the old one first if it wasn't
+    already, then add the time to the epoch. Sentences without a time join
+    the epoch of the last time received.
 */
 /**************************************************************************/
-bool INA::parseFix(char *p) {
-  if (!isEmpty(p)) {
-    if (p[0] == 'A') {
-      fix = true;
-      lastFix = sentTime;
-    } else if (p[0] == 'V')
-      fix = false;
-    else
-      return false;
-    return true;
+void INA_Core::epochTime(void) {
+  if ((epochBuild.have & NMEA_FIX_TIME) &&
+      (epochBuild.hour != hour || epochBuild.minute != minute ||
+       epochBuild.seconds != seconds ||
+       epochBuild.milliseconds != milliseconds)) {
+    epochPublish(); // whatever the last epoch collected
+    epochBuild = nmea_fix_t();
+    epochPublished = false;
   }
-  return false;
+  epochSet(NMEA_FIX_TIME);
+}
+
+/**************************************************************************/
+/*!
+    @brief Copy a group of just parsed values into the epoch being gathered,
+    and publish the epoch as soon as it holds all the groups required.
+    @param bits The nmea_fix_fields_t groups to copy
+*/
+/**************************************************************************/
+void INA_Core::epochSet(uint16_t bits) {
+  nmea_fix_t &f = epochBuild;
+  if (bits & NMEA_FIX_TIME) {
+    f.hour = hour;
+    f.minute = minute;
+    f.seconds = seconds;
+    f.milliseconds = milliseconds;
+  }
+  if (bits & NMEA_FIX_DATE) {
+    f.year = year;
+    f.month = month;
+    f.day = day;
+  }
+  if (bits & NMEA_FIX_STATUS)
+    f.fix = fix;
+  if (bits & NMEA_FIX_POSITION) {
+    f.latitude_fixed = latitude_fixed;
+    f.longitude_fixed = longitude_fixed;
+  }
+  if (bits & NMEA_FIX_ALTITUDE) {
+    f.altitude_fixed = altitude_fixed;
+    f.geoidheight_fixed = geoidheight_fixed;
+  }
+  if (bits & NMEA_FIX_VELOCITY) {
+    f.speed_fixed = speed_fixed;
+    f.angle_fixed = angle_fixed;
+  }
+  if (bits & NMEA_FIX_QUALITY) {
+    f.fixquality = fixquality;
+    f.satellites = satellites;
+    f.HDOP = HDOP;
+  }
+  if (bits & NMEA_FIX_DOP) {
+    f.fixquality_3d = fixquality_3d;
+    f.HDOP = HDOP;
+    f.VDOP = VDOP;
+    f.PDOP = PDOP;
+  }
+  if (bits & NMEA_FIX_INVIEW)
+    f.satellitesInView = satellitesInView;
+  f.have |= bits;
+  if ((f.have & epochRequired) == epochRequired)
+    epochPublish();
+}
+
+/**************************************************************************/
+/*!
+    @brief Publish the epoch being gathered for getFix(), unless it is empty
+    or was published already with the same groups. A sentence that arrives
+    after its epoch was published, such as a GSA or GSV after the RMC, adds
+    its groups to the published record, which is then published again.
+*/
+/**************************************************************************/
+void INA_Core::epochPublish(void) {
+  if (epochBuild.have == 0 ||
+      (epochPublished && epochDone.have == epochBuild.have))
+    return;
+  epochDone = epochBuild;
+  epochPublished = true;
+  fixCount++;
+}
+
+/**************************************************************************/
+/*!
+    @brief Get the most recent complete epoch: everything the GPS reported
+    for one UTC time, gathered from all its sentences. An epoch is published
+    as soon as it has every group set with setEpochFields(), or when the
+    next epoch starts if it never does, so the values never mix two epochs
+    the way the individual variables can between sentences. A later
+    sentence of the same epoch that adds a group, such as a GSA after the
+    RMC and GGA, publishes it again with that group added.
+    @param record The record to fill
+    @return True if this epoch is new since the last call
+*/
+/**************************************************************************/
+bool INA_Core::getFix(nmea_fix_t &record) {
+  record = epochDone;
+  bool fresh = (fixCount != fixSeen);
+  fixSeen = fixCount;
+  return fresh;
+}
+
+/**************************************************************************/
+/*!
+    @brief Copy the most recent complete epoch, and optionally the latest
+    data values, safely while another task or core may be parsing. Unlike
+    getFix() it keeps no state of its own, so any number of readers can use
+    it, and the parsing side never waits for them: a copy that overlapped a
+    sentence being parsed is simply made again. Only one task may parse.
+    @param record The record to fill, as getFix() would
+    @param latest Buffer of NMEA_MAX_INDEX values to copy the latest data
+    values into, as copyLatest() would, or NULL. Ignored without
+    NMEA_EXTENSIONS.
+    @return The number of epochs published so far, which changes when the
+    record holds a new epoch
+*/
+/**************************************************************************/
+uint32_t INA_Core::snapshot(nmea_fix_t &record, nmea_float_t *latest) {
+  uint32_t seq, count;
+  uint8_t spins = 0;
+  do {
+    // wait out a sentence being parsed, then copy and check it didn't start
+    while ((seq = snapSeq.load(std::memory_order_acquire)) & 1) {
+      if (spins < 100) {
+        spins++;
+        yield();
+      } else {
+        delay(1); // the parser may be on this core, give it time to finish
+      }
+    }
+    record = epochDone;
+    count = fixCount;
+#ifdef NMEA_EXTENSIONS
+    if (latest != NULL)
+      memcpy(latest, state.latest, sizeof(state.latest));
+#endif
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while (snapSeq.load(std::memory_order_relaxed) != seq);
+  return count;
 }
 
+/**************************************************************************/
+/*!
+    @brief Choose which groups of fields complete an epoch, so it can be
+    published the moment the last of them arrives instead of when the next
+    epoch starts. The default suits the RMC and GGA sentences begin() asks
+    the GPS for. If the GPS also sends GSA or GSV, adding NMEA_FIX_DOP or
+    NMEA_FIX_INVIEW here has each epoch published once with them, instead
+    of once without and again as they arrive.
+    @param required nmea_fix_fields_t bits that make an epoch complete
+*/
+/**************************************************************************/
+void INA_Core::setEpochFields(uint16_t required) { epochRequired = required; }
+
 /**************************************************************************/
 /*!
     @brief Parse a part of an NMEA string for antenna that is used
@@ -798,7 +1039,7 @@ bool INA::parseFix(char *p) {
     @return 3=external 2=internal 1=there was an antenna short or problem
 */
 /**************************************************************************/
-bool INA::parseAntenna(char *p) {
+bool INA_Core::parseAntenna(char *p) {
   if (!isEmpty(p)) {
     if (p[0] == '3') {
       antenna = 3;
@@ -815,19 +1056,62 @@ bool INA::parseAntenna(char *p) {
 
 /**************************************************************************/
 /*!
-    @brief Is the field empty, or should we try conversion? Won't work
-    for a text field that starts with an asterisk or a comma, but that
-    probably violates the NMEA-183 standard.
+    @brief Find a field of the sentence last passed to check() from the
+    offsets it recorded, without walking the sentence.
+    @param i Index of the field, 1 for the first field after the sentence id
+    @return Pointer to the start of the field, or to an empty field if the
+    sentence does not have that many
+*/
+/**************************************************************************/
+char *INA_Core::field(uint8_t i) {
+  static char none[] = "*"; // reads as an empty field to isEmpty()
+  if (i >= fields.n)
+    return none;
+  // fields only ever refers to a line in one of our own buffers
+  return (char *)fields.base + fields.start[i];
+}
+
+/**************************************************************************/
+/*!
+    @brief Parse a decimal field straight into a scaled integer, see
+    nmea::parseFixed()
+    @param p Pointer to the location of the token in the NMEA string
+    @param decimals Number of decimal places to keep, 0 to 9
+    @param value Pointer to fill with the scaled integer, only on success
+    @return True if the field was a number that fits, false otherwise
+*/
+/**************************************************************************/
+bool INA_Core::parseFixed(char *p, uint8_t decimals, int32_t *value) {
+  return nmea::parseFixed(p, decimals, value);
+}
+
+/**************************************************************************/
+/*!
+    @brief Parse a decimal field into a float, see nmea::parseFloat()
+    @param p Pointer to the location of the token in the NMEA string
+    @return The value, or 0 if the field is not a number
+*/
+/**************************************************************************/
+nmea_float_t INA_Core::parseFloat(char *p) { return nmea::parseFloat(p); }
+
+/**************************************************************************/
+/*!
+    @brief Parse the integer part of a decimal field, see nmea::parseInt()
+    @param p Pointer to the location of the token in the NMEA string
+    @return The value, or 0 if the field is not a number
+*/
+/**************************************************************************/
+int32_t INA_Core::parseInt(char *p) { return nmea::parseInt(p); }
+
+/**************************************************************************/
+/*!
+    @brief Is the field empty, or should we try conversion? See
+    nmea::isEmpty()
     @param pStart Pointer to the location of the token in the NMEA string
     @return true if empty field, false if something there
 */
 /**************************************************************************/
-bool INA::isEmpty(char *pStart) {
-  if (',' != *pStart && '*' != *pStart && pStart != NULL)
-    return false;
-  else
-    return true;
-}
+bool INA_Core::isEmpty(char *pStart) { return nmea::isEmpty(pStart); }
 
 /**************************************************************************/
 /*!
@@ -837,16 +1121,4 @@ bool INA::isEmpty(char *pStart) {
    character
 */
 /**************************************************************************/
-// read a Hex value and return the decimal equivalent
-uint8_t INA::parseHex(char c) {
-  if (c < '0')
-    return 0;
-  if (c <= '9')
-    return c - '0';
-  if (c < 'A')
-    return 0;
-  if (c <= 'F')
-    return (c - 'A') + 10;
-  // if (c > 'F')
-  return 0;
-}
+uint8_t INA_Core::parseHex(char c) { return nmea::parseHex(c); }
@@ -0,0 +1,135 @@
+/**************************************************************************/
+/*!
+  @file NMEA_queue.h
+*/
+/**************************************************************************/
+#ifndef _NMEA_QUEUE_H
+#define _NMEA_QUEUE_H
+#include "Arduino.h"
+#include <atomic>
+
+#ifndef NMEA_QUEUE_DEPTH
+#define NMEA_QUEUE_DEPTH                                                       \
+  8 ///< number of sentences the queue can hold, must be a power of 2
+#endif
+
+/**************************************************************************/
+/*!
+  Lock-free single-producer / single-consumer ring of fixed size sentence
+  slots. One side (read(), poll() or the reader task) pushes complete
+  sentences, the other (the application) pops them in order of arrival,
+  and neither ever waits on the other. Each slot carries the millis() time
+  stamps of the first and last character of its sentence. The slots are
+  part of the object, so there is no allocation after construction.
+
+  When the ring is full the newest sentence is dropped and counted in
+  overflows(), so the consumer always sees an unbroken run of the oldest
+  sentences.
+ **************************************************************************/
+template <uint8_t DEPTH, uint8_t LEN> class NMEA_Queue {
+  static_assert(DEPTH > 0 && DEPTH <= 128 && (DEPTH & (DEPTH - 1)) == 0,
+                "NMEA_Queue depth must be a power of 2 no larger than 128");
+
+public:
+  /**************************************************************************/
+  /*!
+      @brief Copy a sentence into the next free slot and publish it. Only
+      call from the producer thread.
+      @param line Pointer to the 0 terminated sentence
+      @param sentTime millis() when the first character was received
+      @param recvdTime millis() when the last character was received
+      @return True if queued, false if the queue was full
+  */
+  /**************************************************************************/
+  bool push(const char *line, uint32_t sentTime = 0,
+            uint32_t recvdTime = 0) {
+    uint8_t head = _head.load(std::memory_order_relaxed);
+    if ((uint8_t)(head - _tail.load(std::memory_order_acquire)) >= DEPTH) {
+      _overflows.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    slot_t *slot = &_slots[head & (DEPTH - 1)];
+    strncpy(slot->text, line, LEN - 1);
+    slot->text[LEN - 1] = 0;
+    slot->sentTime = sentTime;
+    slot->recvdTime = recvdTime;
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**************************************************************************/
+  /*!
+      @brief Copy the oldest sentence out of the queue and free its slot.
+      Only call from the consumer thread.
+      @param buff Pointer to the buffer to copy the sentence into
+      @param len Size of the buffer including the terminating 0
+      @param sentTime Pointer to fill with the time of the first character,
+      if not NULL
+      @param recvdTime Pointer to fill with the time of the last character,
+      if not NULL
+      @return True if a sentence was copied, false if the queue was empty
+  */
+  /**************************************************************************/
+  bool pop(char *buff, size_t len, uint32_t *sentTime = NULL,
+           uint32_t *recvdTime = NULL) {
+    uint8_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire))
+      return false;
+    const slot_t *slot = &_slots[tail & (DEPTH - 1)];
+    if (len > 0) {
+      strncpy(buff, slot->text, len - 1);
+      buff[len - 1] = 0;
+    }
+    if (sentTime != NULL)
+      *sentTime = slot->sentTime;
+    if (recvdTime != NULL)
+      *recvdTime = slot->recvdTime;
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**************************************************************************/
+  /*!
+      @brief Discard every queued sentence by popping them one at a time,
+      so the producer may go on pushing while it runs. Only call from the
+      consumer thread.
+  */
+  /**************************************************************************/
+  void drain() {
+    while (pop(NULL, 0)) {
+    }
+  }
+
+  /**************************************************************************/
+  /*!
+      @brief Number of sentences waiting in the queue
+      @return Count of queued sentences, 0 to DEPTH
+  */
+  /**************************************************************************/
+  uint8_t count() {
+    return _head.load(std::memory_order_acquire) -
+           _tail.load(std::memory_order_acquire);
+  }
+
+  /**************************************************************************/
+  /*!
+      @brief Number of sentences dropped because the queue was full
+      @return Count of dropped sentences since construction
+  */
+  /**************************************************************************/
+  uint32_t overflows() { return _overflows.load(std::memory_order_relaxed); }
+
+private:
+  typedef struct {
+    char text[LEN];     ///< the sentence
+    uint32_t sentTime;  ///< millis() when the first character was received
+    uint32_t recvdTime; ///< millis() when the last character was received
+  } slot_t;
+
+  slot_t _slots[DEPTH];                 ///< the sentence buffers
+  std::atomic<uint8_t> _head{0};        ///< next slot to fill, producer owned
+  std::atomic<uint8_t> _tail{0};        ///< next slot to empty, consumer owned
+  std::atomic<uint32_t> _overflows{0};  ///< sentences dropped when full
+};
+
+#endif // _NMEA_QUEUE_H
@@ -0,0 +1,150 @@
+/*!
+ * @file Arduino.h
+ * @brief The small part of the Arduino core the library uses, for building
+ * it and its tests on a desktop with the PlatformIO native platform
+ * @n Time comes from std::chrono, Serial writes to stdout and nothing talks
+ * to real hardware. Run the tests with: pio test -e native
+ * @copyright   MIT License
+ */
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <ctype.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define RAD_TO_DEG 57.295779513082320876798154814105
+#define constrain(amt, low, high) \
+    ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef uint8_t byte;
+using std::max;
+using std::min;
+
+/// The steady clock every host millis() and micros() is measured from
+inline std::chrono::steady_clock::time_point hostStart() {
+    static const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    return start;
+}
+
+/// ms since the program started, wrapping like the Arduino one
+inline uint32_t millis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - hostStart())
+        .count();
+}
+
+/// us since the program started, wrapping like the Arduino one
+inline uint32_t micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - hostStart())
+        .count();
+}
+
+inline void delay(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline void yield() { std::this_thread::yield(); }
+
+inline bool isDigit(int c) { return isdigit(c); }
+
+inline bool isAlpha(int c) { return isalpha(c); }
+
+/// Arduino String, enough of it for String(value, decimals) and +
+class String {
+   public:
+    String() {}
+    String(const char *s) : str(s) {}
+    String(double v, unsigned char decimals = 2) {
+        char buff[40];
+        snprintf(buff, sizeof(buff), "%.*f", decimals, v);
+        str = buff;
+    }
+    const char *c_str() const { return str.c_str(); }
+    size_t length() const { return str.length(); }
+    friend String operator+(String a, const String &b) {
+        a.str += b.str;
+        return a;
+    }
+
+   private:
+    std::string str;
+};
+
+/// Arduino Print, formatting through snprintf()
+class Print {
+   public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buff, size_t len) {
+        size_t n = 0;
+        while (len--)
+            n += write(*buff++);
+        return n;
+    }
+    size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+
+    size_t print(const char *s) { return write(s); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return printf("%d", v); }
+    size_t print(unsigned v) { return printf("%u", v); }
+    size_t print(long v) { return printf("%ld", v); }
+    size_t print(unsigned long v) { return printf("%lu", v); }
+    size_t print(double v, int decimals = 2) {
+        return printf("%.*f", decimals, v);
+    }
+    template <class T>
+    size_t println(T v) {
+        return print(v) + write("\r\n");
+    }
+    size_t println(double v, int decimals) {
+        return print(v, decimals) + write("\r\n");
+    }
+    size_t println(void) { return write("\r\n"); }
+
+   private:
+    template <class... Args>
+    size_t printf(const char *format, Args... args) {
+        char buff[40];
+        snprintf(buff, sizeof(buff), format, args...);
+        return write(buff);
+    }
+};
+
+/// Arduino Stream, with nothing to read
+class Stream : public Print {
+   public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    size_t readBytes(char *buff, size_t len) {
+        size_t n = 0;
+        for (int c; n < len && (c = read()) >= 0; n++)
+            buff[n] = c;
+        return n;
+    }
+};
+
+/// A serial port that writes to stdout
+class HardwareSerial : public Stream {
+   public:
+    void begin(unsigned long baud) { (void)baud; }
+    size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+    using Print::write;
+};
+
+inline HardwareSerial Serial;  ///< stdout
+
+#endif  // HOST_ARDUINO_H
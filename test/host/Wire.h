@@ -0,0 +1,60 @@
+/*!
+ * @file Wire.h
+ * @brief An I2C bus for building I2CTransport on a desktop. Nothing is on
+ * it unless replay() puts a GPS there, which answers every request with
+ * the next bytes of a text, padded with 0x0A filler like the L76-L.
+ * @copyright   MIT License
+ */
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include "Arduino.h"
+
+/// Arduino TwoWire, with at most a GPS replaying text on it
+class TwoWire : public Stream {
+   public:
+    bool begin() { return true; }
+    bool end() { return true; }
+    size_t setBufferSize(size_t len) { return len; }
+    void beginTransmission(uint8_t addr) { (void)addr; }
+    uint8_t endTransmission(bool stop = true) {
+        (void)stop;
+        return _text ? 0 : 2;  // 2 is address not acknowledged
+    }
+    uint8_t requestFrom(uint8_t addr, uint8_t len, uint8_t stop) {
+        (void)addr;
+        (void)stop;
+        requests++;
+        if (_text == NULL)
+            return 0;
+        for (_len = 0; _len < len; _len++)
+            _packet[_len] = *_text ? *_text++ : 0x0A;
+        _pos = 0;
+        return len;
+    }
+    int available() override { return _len - _pos; }
+    int read() override { return _pos < _len ? (uint8_t)_packet[_pos++] : -1; }
+    size_t write(uint8_t c) override {
+        (void)c;
+        return 1;
+    }
+    using Print::write;
+
+    /// Put a GPS on the bus that sends text, then only filler
+    void replay(const char *text) {
+        _text = text;
+        requests = 0;
+    }
+
+    uint32_t requests = 0;  ///< requestFrom() calls since replay()
+
+   private:
+    const char *_text = NULL;  ///< what the GPS has still to send
+    char _packet[255];         ///< the last packet requested
+    uint8_t _len = 0;          ///< bytes in _packet
+    uint8_t _pos = 0;          ///< the next byte of _packet to read
+};
+
+inline TwoWire Wire;  ///< the default bus
+
+#endif  // HOST_WIRE_H
@@ -0,0 +1,120 @@
+/*!
+ * @file test_main.cpp
+ * @brief Host benchmark of the size and speed of the three records of a
+ * fix: fixPacked() and unpackFix(), fixMsgPack() and unpackMsgPack(), and
+ * fixJSON(), read back with deserializeJson() since the library has no
+ * reader of its own for it. Each record is written and read back RUNS
+ * times, from a fix that changes a little every time, as a logger would.
+ * @n Run with: pio test -e native -f test_bench_binary
+ * @copyright   MIT License
+ */
+#include <INA.h>
+#include <unity.h>
+
+#define RUNS 20000  ///< records written and read back with each encoding
+
+static volatile uint32_t sink;  ///< keeps the timed work from being dropped
+
+/// Fix i of a boat going north at 5 knots, one per second
+static nmea_fix_t sample(uint32_t i) {
+    nmea_fix_t f;
+    f.have = NMEA_FIX_DEFAULT | NMEA_FIX_DOP;
+    f.year = 26;
+    f.month = 9;
+    f.day = 17;
+    f.hour = 12;
+    f.minute = i / 60 % 60;
+    f.seconds = i % 60;
+    f.latitude_fixed = -338688000 + i * 23;
+    f.longitude_fixed = 1512093333;
+    f.altitude_fixed = 12;
+    f.speed_fixed = 5000 + i % 100;
+    f.angle_fixed = 35900 + i % 100;
+    f.HDOP = 0.9;
+    f.fix = true;
+    f.fixquality = 1;
+    f.fixquality_3d = 3;
+    f.satellites = 8 + i % 4;
+    return f;
+}
+
+/// The size of a record and ns per write and per read of it
+typedef struct {
+    size_t bytes;  ///< size of the record of the last fix
+    double write;  ///< ns per record written
+    double read;   ///< ns per record read back
+} run_t;
+
+/// Time writing RUNS records with one encoder, then reading them back
+template <class Write, class Read>
+static run_t timeRecord(Write write, Read read) {
+    static uint8_t buff[512];
+    run_t r = {};
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < RUNS; i++)
+        r.bytes = write(sample(i), buff, sizeof(buff));
+    r.write = (micros() - start) * 1e3 / RUNS;
+    TEST_ASSERT_GREATER_THAN(0, r.bytes);
+    start = micros();
+    for (uint32_t i = 0; i < RUNS; i++) {
+        nmea_fix_t f;
+        TEST_ASSERT_TRUE(read(buff, r.bytes, f));
+        sink += f.satellites;
+    }
+    r.read = (micros() - start) * 1e3 / RUNS;
+    return r;
+}
+
+/// Report a run as a test message
+static void report(const char *name, const run_t &r) {
+    char msg[120];
+    snprintf(msg, sizeof(msg), "%s: %u bytes, write %.1f ns, read %.1f ns",
+             name, (unsigned)r.bytes, r.write, r.read);
+    TEST_MESSAGE(msg);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_time_the_records(void) {
+    run_t packed = timeRecord(
+        [](const nmea_fix_t &f, uint8_t *b, size_t n) {
+            return INA_Core::fixPacked(f, b, n);
+        },
+        [](const uint8_t *b, size_t n, nmea_fix_t &f) {
+            return INA_Core::unpackFix(b, n, f);
+        });
+    run_t msgpack = timeRecord(
+        [](const nmea_fix_t &f, uint8_t *b, size_t n) {
+            return INA_Core::fixMsgPack(f, b, n);
+        },
+        [](const uint8_t *b, size_t n, nmea_fix_t &f) {
+            return INA_Core::unpackMsgPack(b, n, f);
+        });
+    run_t json = timeRecord(
+        [](const nmea_fix_t &f, uint8_t *b, size_t n) {
+            return INA_Core::fixJSON(f, (char *)b, n);
+        },
+        [](const uint8_t *b, size_t n, nmea_fix_t &f) {
+            JsonDocument doc;
+            if (deserializeJson(doc, (const char *)b, n))
+                return false;
+            f.satellites = doc["INA"].size();  // entries, for the sink
+            return true;
+        });
+    report("fixPacked()", packed);
+    report("fixMsgPack()", msgpack);
+    report("fixJSON()", json);
+    TEST_ASSERT_EQUAL(INA_PACKED_SIZE, packed.bytes);
+    TEST_ASSERT_LESS_THAN(json.bytes, msgpack.bytes);
+    TEST_ASSERT_LESS_THAN(msgpack.bytes, packed.bytes);
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_time_the_records);
+    return UNITY_END();
+}
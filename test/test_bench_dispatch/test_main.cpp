@@ -0,0 +1,94 @@
+/*!
+ * @file test_main.cpp
+ * @brief Host benchmark of finding what to do with a sentence id. check()
+ * packs the id with nmeaKey() and classifies it with one switch, where
+ * parse() used to walk a chain of strcmp() calls, GGA first and ZDA last.
+ * The old chain is kept here to time against.
+ * @n Run with: pio test -e native -f test_bench_dispatch
+ * @copyright   MIT License
+ */
+#include <INA.h>
+#include <unity.h>
+
+#define RUNS 1000000  ///< lookups timed for each id
+
+/// The sentence ids in the order parse() used to strcmp() them
+static const char *const chain[] = {
+    "GGA", "RMC", "GLL", "GSA", "TOP", "APB", "DBT", "DPT", "GSV", "HDG",
+    "HDM", "HDT", "MDA", "MTW", "MWD", "MWV", "RMB", "ROT", "RPM", "RSA",
+    "TXT", "VDR", "VHW", "VLW", "VPW", "VTG", "VWR", "WCV", "XTE", "ZDA",
+};
+static const uint8_t CHAIN = sizeof(chain) / sizeof(chain[0]);
+
+static INA_Receiver<ReplayTransport> gps("");
+static volatile uint32_t sink;  ///< keeps the timed work from being dropped
+
+/// Where an id is in the old chain, found the way parse() used to
+static uint8_t chainIndex(const char *id) {
+    for (uint8_t i = 0; i < CHAIN; i++) {
+        if (!strcmp(id, chain[i]))
+            return i;
+    }
+    return CHAIN;
+}
+
+/// ns per lookup of an id in the old chain
+static double timeChain(const char *id) {
+    char buff[4];
+    strcpy(buff, id);
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < RUNS; i++) {
+        buff[0] = id[0] + (sink & 0);  // as if it had just been received
+        sink += chainIndex(buff);
+    }
+    return (micros() - start) * 1e3 / RUNS;
+}
+
+/// ns per check() of an empty sentence with an id, which is the checksum,
+/// the source and the sentence lookup
+static double timeCheck(const char *id) {
+    char buff[16];
+    uint8_t sum = 0;
+    snprintf(buff, sizeof(buff), "GP%s,", id);
+    for (char *p = buff; *p; p++)
+        sum ^= *p;
+    snprintf(buff, sizeof(buff), "$GP%s,*%02X", id, sum);
+    TEST_ASSERT_TRUE(gps.check(buff));
+    TEST_ASSERT_EQUAL(NMEA_HAS_DOLLAR + NMEA_HAS_CHECKSUM + NMEA_HAS_SOURCE +
+                          NMEA_HAS_SENTENCE + NMEA_HAS_SENTENCE_P,
+                      gps.thisCheck);
+    TEST_ASSERT_EQUAL_STRING(id, gps.thisSentence);
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < RUNS; i++)
+        sink += gps.check(buff);
+    return (micros() - start) * 1e3 / RUNS;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_dispatch_first_and_last(void) {
+    TEST_ASSERT_EQUAL_UINT8(0, chainIndex("GGA"));
+    TEST_ASSERT_EQUAL_UINT8(CHAIN - 1, chainIndex("ZDA"));
+    gps.begin();
+
+    double chainFirst = timeChain("GGA"), chainLast = timeChain("ZDA");
+    double checkFirst = timeCheck("GGA"), checkLast = timeCheck("ZDA");
+    char msg[120];
+    snprintf(msg, sizeof(msg), "strcmp() chain: GGA %.1f ns, ZDA %.1f ns",
+             chainFirst, chainLast);
+    TEST_MESSAGE(msg);
+    snprintf(msg, sizeof(msg),
+             "check() with the switch: GGA %.1f ns, ZDA %.1f ns", checkFirst,
+             checkLast);
+    TEST_MESSAGE(msg);
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_dispatch_first_and_last);
+    return UNITY_END();
+}
@@ -0,0 +1,110 @@
+/*!
+ * @file test_main.cpp
+ * @brief Host benchmark of recording data value history at N = 192, 1024
+ * and 8192. The history is a ring, so a sample costs the same at any N,
+ * where the array it replaced shifted all N values down for every sample.
+ * That shift is kept here to time against, and to check that the ring
+ * reads back the same values oldest first.
+ * @n Run with: pio test -e native -f test_bench_history
+ * @copyright   MIT License
+ */
+#include <INA.h>
+#include <unity.h>
+
+#define SAMPLES 100000  ///< samples timed at each N
+
+static INA_Receiver<ReplayTransport> gps("");
+
+#ifdef NMEA_EXTENSIONS
+/// The value for update i, varying so the history has something to show
+static nmea_float_t value(uint32_t i) { return 10 + (i % 97) / 10.0; }
+
+/// A history on NMEA_DEPTH that takes a sample on every update
+static nmea_history_t *history(unsigned n) {
+    nmea_history_t *h = gps.initHistory(NMEA_DEPTH, 10.0, 0.0, 20, n);
+    TEST_ASSERT_NOT_NULL(h);
+    h->historyInterval = 0;
+    return h;
+}
+
+/// Record a sample the way history was recorded before the ring
+static void shiftIn(int16_t *data, unsigned n, int16_t v) {
+    for (unsigned i = 0; i < n - 1; i++)
+        data[i] = data[i + 1];
+    data[n - 1] = v;
+}
+#endif
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_ring_reads_back_like_the_shifted_array(void) {
+#ifdef NMEA_EXTENSIONS
+    const unsigned n = 192;
+    static int16_t shifted[n];
+    gps.begin();
+    history(n);
+    for (uint32_t i = 0; i < 3 * n + 17; i++) {
+        gps.newDataValue(NMEA_DEPTH, value(i));
+        unsigned count = gps.historyCount(NMEA_DEPTH);
+        shiftIn(shifted, n, gps.historyValue(NMEA_DEPTH, count - 1));
+    }
+    TEST_ASSERT_EQUAL(n, gps.historyCount(NMEA_DEPTH));
+    static int16_t ring[n];
+    TEST_ASSERT_EQUAL(n, gps.copyHistory(NMEA_DEPTH, ring, n));
+    TEST_ASSERT_EQUAL_INT16_ARRAY(shifted, ring, n);
+    for (unsigned i = 0; i < n; i++)
+        TEST_ASSERT_EQUAL_INT16(shifted[i], gps.historyValue(NMEA_DEPTH, i));
+    gps.removeHistory(NMEA_DEPTH);
+#else
+    TEST_IGNORE_MESSAGE("needs NMEA_EXTENSIONS");
+#endif
+}
+
+void test_time_a_sample(void) {
+#ifdef NMEA_EXTENSIONS
+    const unsigned sizes[] = {192, 1024, 8192};
+    static int16_t shifted[8192];
+    static volatile int16_t sink;
+    gps.begin();
+    for (unsigned n : sizes) {
+        history(n);
+        uint32_t start = micros();
+        for (uint32_t i = 0; i < SAMPLES; i++)
+            gps.newDataValue(NMEA_DEPTH, value(i));
+        double ring = (micros() - start) * 1e3 / SAMPLES;
+        TEST_ASSERT_EQUAL(n, gps.historyCount(NMEA_DEPTH));
+        gps.removeHistory(NMEA_DEPTH);
+
+        // the update without history, and the shift the ring replaced
+        start = micros();
+        for (uint32_t i = 0; i < SAMPLES; i++)
+            gps.newDataValue(NMEA_DEPTH, value(i));
+        double update = (micros() - start) * 1e3 / SAMPLES;
+        start = micros();
+        for (uint32_t i = 0; i < SAMPLES; i++)
+            shiftIn(shifted, n, i);
+        double shift = (micros() - start) * 1e3 / SAMPLES;
+        sink = shifted[0];
+
+        char msg[120];
+        snprintf(msg, sizeof(msg),
+                 "N = %u: update with a ring sample %.1f ns, without %.1f "
+                 "ns, shifting the array %.1f ns",
+                 n, ring, update, shift);
+        TEST_MESSAGE(msg);
+    }
+#else
+    TEST_IGNORE_MESSAGE("needs NMEA_EXTENSIONS");
+#endif
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_ring_reads_back_like_the_shifted_array);
+    RUN_TEST(test_time_a_sample);
+    return UNITY_END();
+}
@@ -0,0 +1,93 @@
+/*!
+ * @file test_main.cpp
+ * @brief Host benchmark of writing the time of a fix in ISO 8601: the
+ * sprintf() getData() and the JSON encoders used, against nmea::isoTime()
+ * from epochMillis(), without and with the nmea_iso_date_t cache. The fixes
+ * come at 10 Hz for nearly three hours, from the evening of a leap day into
+ * the next, so the cache is mostly hit and once missed. All three must
+ * write the same text.
+ * @n Run with: pio test -e native -f test_bench_iso
+ * @copyright   MIT License
+ */
+#include <INA.h>
+#include <unity.h>
+
+#define FIXES 100000  ///< fixes at 10 Hz, from 2024-02-29 22:00
+
+static volatile uint32_t sink;  ///< keeps the timed work from being dropped
+
+/// Fix i of the run
+static nmea_fix_t fix(uint32_t i) {
+    nmea_fix_t f;
+    nmea::fromEpochMillis(
+        nmea::daysFromCivil(2024, 2, 29) * 86400000ULL + 22 * 3600000ULL +
+            i * 100ULL + i % 7,  // a few ms of jitter, for the padding
+        f);
+    return f;
+}
+
+/// Write the time of a fix as getData() used to
+static void withSprintf(const nmea_fix_t &f, char *ts) {
+    sprintf(ts, "20%02d-%02d-%02dT%02d:%02d:%02d.%03dZ", f.year, f.month,
+            f.day, f.hour, f.minute, f.seconds, f.milliseconds);
+}
+
+static nmea_fix_t fixes[FIXES];  ///< made up front, so only writing is timed
+
+/// ns per timestamp of a pass over all the fixes
+template <class Write>
+static double timeFixes(Write write) {
+    char ts[32];
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < FIXES; i++) {
+        write(fixes[i], ts);
+        sink += ts[22];
+    }
+    return (micros() - start) * 1e3 / FIXES;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_all_write_the_same(void) {
+    nmea_iso_date_t cache;
+    char want[32], plain[NMEA_ISO_TIME_SIZE], cached[NMEA_ISO_TIME_SIZE];
+    for (uint32_t i = 0; i < FIXES; i++) {
+        fixes[i] = fix(i);
+        withSprintf(fixes[i], want);
+        uint64_t ms = nmea::epochMillis(fixes[i]);
+        nmea::isoTime(ms, plain);
+        nmea::isoTime(ms, cached, &cache);
+        TEST_ASSERT_EQUAL_STRING(want, plain);
+        TEST_ASSERT_EQUAL_STRING(want, cached);
+    }
+    TEST_ASSERT_EQUAL_UINT8(3, fixes[FIXES - 1].month);  // past midnight
+}
+
+void test_time_the_writers(void) {
+    double printed = timeFixes(withSprintf);
+    double plain = timeFixes([](const nmea_fix_t &f, char *ts) {
+        nmea::isoTime(nmea::epochMillis(f), ts);
+    });
+    static nmea_iso_date_t cache;
+    double cached = timeFixes([](const nmea_fix_t &f, char *ts) {
+        nmea::isoTime(nmea::epochMillis(f), ts, &cache);
+    });
+
+    char msg[120];
+    snprintf(msg, sizeof(msg),
+             "ns per timestamp: sprintf() %.1f, isoTime() %.1f, with the "
+             "date cached %.1f",
+             printed, plain, cached);
+    TEST_MESSAGE(msg);
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_all_write_the_same);
+    RUN_TEST(test_time_the_writers);
+    return UNITY_END();
+}
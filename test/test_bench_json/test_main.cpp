@@ -0,0 +1,178 @@
+/*!
+ * @file test_main.cpp
+ * @brief Host benchmark of the two JSON getters on the same fix:
+ * getJSON(char *, size_t), which writes it with fixJSON(), against
+ * getJSON(JsonDocument &) and serializeJson(). Both must give the same
+ * document, apart from how the numbers are written:
+ * @n fixJSON() writes the fixed point values with the decimals the GPS
+ * sends and trailing zeros trimmed, e.g. "Alt":545.4 and "SoG":0.051.
+ * getJSON(JsonDocument &) goes through floats, and ArduinoJson writes what
+ * the float holds with up to 9 significant digits, e.g. "SoG":0.0514444008
+ * and "HDOP":0.899999976. The location string has 6 decimals from both, but
+ * the float one can be off by a few in the last.
+ * @n Run with: pio test -e native -f test_bench_json
+ * @copyright   MIT License
+ */
+#include <INA.h>
+#include <unity.h>
+
+#define RUNS 5000  ///< times each getter is timed
+
+static char text[2 * MAXLINELENGTH];  ///< the epoch being replayed
+static INA_Receiver<ReplayTransport> gps(text);
+
+/// Add a sentence to text, with its checksum and CR LF
+static void add(const char *body) {
+    uint8_t sum = 0;
+    for (const char *p = body; *p; p++)
+        sum ^= *p;
+    size_t n = strlen(text);
+    snprintf(text + n, sizeof(text) - n, "$%s*%02X\r\n", body, sum);
+}
+
+/// Put epoch n in text, one GGA and RMC that differ from n - 1 in the time
+/// only, then replay it from the start
+static void replay(uint32_t n) {
+    char body[MAXLINELENGTH];
+    text[0] = 0;
+    snprintf(body, sizeof(body),
+             "GPGGA,1200%02u.00,4807.0380,S,01131.0000,W,1,08,0.9,545.4,M,"
+             "46.9,M,,",
+             (unsigned)(n % 60));
+    add(body);
+    snprintf(body, sizeof(body),
+             "GPRMC,1200%02u.00,A,4807.0380,S,01131.0000,W,0.10,54.70,"
+             "170926,,,A",
+             (unsigned)(n % 60));
+    add(body);
+    gps.begin();
+}
+
+/// One {"name":..,"value":..,"unit":..} entry of the INA array
+typedef struct {
+    char name[16];   ///< the name
+    char value[48];  ///< the value as written, without quotes
+    char unit[16];   ///< the unit
+} entry_t;
+
+/// Copy what is between p and the first stop into out, and skip past stop
+static const char *copyUntil(const char *p, const char *stop, char *out,
+                             size_t len) {
+    const char *end = p ? strstr(p, stop) : NULL;
+    if (end == NULL)
+        return NULL;
+    snprintf(out, len, "%.*s", (int)(end - p), p);
+    return end + strlen(stop);
+}
+
+/// Split the INA array of a JSON document into its entries
+static uint8_t entries(const char *json, entry_t *e, uint8_t max) {
+    uint8_t n = 0;
+    const char *p = json;
+    while (n < max && (p = strstr(p, "{\"name\":\"")) != NULL) {
+        p = copyUntil(p + 9, "\",\"value\":", e[n].name, sizeof(e[n].name));
+        p = copyUntil(p, ",\"unit\":\"", e[n].value, sizeof(e[n].value));
+        p = copyUntil(p, "\"}", e[n].unit, sizeof(e[n].unit));
+        if (p == NULL)
+            break;
+        n++;
+    }
+    return n;
+}
+
+/// The decimals fixJSON() writes each value with, -1 for strings
+static int8_t decimals(const char *name) {
+    const char *names[] = {"Alt", "SoG", "CoG", "Sat", "HDOP"};
+    const int8_t places[] = {1, 3, 2, 0, 2};
+    for (uint8_t i = 0; i < 5; i++) {
+        if (strcmp(name, names[i]) == 0)
+            return places[i];
+    }
+    return -1;
+}
+
+/// Time RUNS epochs through a getter, in us per epoch
+template <class Getter>
+static double timeRuns(Getter get) {
+    uint32_t start = micros();
+    for (uint16_t i = 0; i < RUNS; i++) {
+        replay(i + 1);  // never the epoch the last run ended with
+        TEST_ASSERT_TRUE(get());
+    }
+    return (micros() - start) / (double)RUNS;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_both_getters_give_the_same_document(void) {
+    char fixed[512], floats[512];
+    replay(0);
+    TEST_ASSERT_GREATER_THAN(0, gps.getJSON(fixed, sizeof(fixed)));
+    uint8_t packed[INA_PACKED_SIZE];
+    replay(1);  // another epoch in between, so epoch 0 is new again
+    gps.getPacked(packed, sizeof(packed));
+    JsonDocument doc;
+    replay(0);
+    TEST_ASSERT_TRUE(gps.getJSON(doc));
+    serializeJson(doc, floats, sizeof(floats));
+    TEST_MESSAGE(fixed);
+    TEST_MESSAGE(floats);
+
+    entry_t a[10], b[10];
+    uint8_t n = entries(fixed, a, 10);
+    TEST_ASSERT_EQUAL_UINT8(8, n);
+    TEST_ASSERT_EQUAL_UINT8(n, entries(floats, b, 10));
+    for (uint8_t i = 0; i < n; i++) {
+        TEST_ASSERT_EQUAL_STRING(a[i].name, b[i].name);
+        TEST_ASSERT_EQUAL_STRING(a[i].unit, b[i].unit);
+        int8_t places = decimals(a[i].name);
+        if (places >= 0) {
+            // rounded to the decimals the GPS sends, against a float
+            TEST_ASSERT_FLOAT_WITHIN(0.5 * pow(10, -places) + 1e-4,
+                                     atof(b[i].value), atof(a[i].value));
+        } else if (strcmp(a[i].name, "location") == 0) {
+            double lon[2], lat[2];
+            TEST_ASSERT_EQUAL(2, sscanf(a[i].value, "\"POINT (%lf,%lf)\"",
+                                        &lon[0], &lat[0]));
+            TEST_ASSERT_EQUAL(2, sscanf(b[i].value, "\"POINT (%lf,%lf)\"",
+                                        &lon[1], &lat[1]));
+            TEST_ASSERT_FLOAT_WITHIN(1e-5, lon[1], lon[0]);
+            TEST_ASSERT_FLOAT_WITHIN(1e-5, lat[1], lat[0]);
+        } else {
+            TEST_ASSERT_EQUAL_STRING(a[i].value, b[i].value);
+        }
+    }
+}
+
+void test_time_the_getters(void) {
+    uint8_t packed[INA_PACKED_SIZE];
+    char buff[512];
+    // getPacked() costs the replay and the parse, and next to nothing else,
+    // so what the others take on top of it is the JSON
+    double parse = timeRuns(
+        [&] { return gps.getPacked(packed, sizeof(packed)) > 0; });
+    double fixed =
+        timeRuns([&] { return gps.getJSON(buff, sizeof(buff)) > 0; });
+    double floats = timeRuns([&] {
+        JsonDocument doc;
+        return gps.getJSON(doc) && serializeJson(doc, buff, sizeof(buff)) > 0;
+    });
+
+    char msg[120];
+    snprintf(msg, sizeof(msg),
+             "us per epoch: parse %.2f, fixJSON +%.2f, "
+             "JsonDocument + serializeJson +%.2f",
+             parse, fixed - parse, floats - parse);
+    TEST_MESSAGE(msg);
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_both_getters_give_the_same_document);
+    RUN_TEST(test_time_the_getters);
+    return UNITY_END();
+}
@@ -0,0 +1,186 @@
+/*!
+ * @file test_main.cpp
+ * @brief Host benchmark of the number parsers of the NMEA core against the
+ * atof() and atoi() they replaced: parseFloat(), parseInt(), parseFixed()
+ * and parseCoord(), which used to go through atol() and atof(). The old
+ * parseCoord() is kept here to time against. The coordinates are checked
+ * against their exact values in degrees * 10000000, truncated, which the
+ * old code missed by its float rounding.
+ * @n Run with: pio test -e native -f test_bench_numbers
+ * @copyright   MIT License
+ */
+#include <INA.h>
+#include <unity.h>
+
+#define RUNS 200000  ///< passes over each set of fields
+
+/// Numeric fields as the GPS sends them, each 0 terminated
+static const char *const floats[] = {
+    "0.9",   "1.23",   "545.4",  "-12.3", "46.9",    "0.10",
+    "54.70", "12.340", "359.99", "2.5",   "99.9",    "0.001",
+    "3.658", "18.5",   "6.50",   "-0.66", "1013.25", "100.00",
+};
+static const uint8_t FLOATS = sizeof(floats) / sizeof(floats[0]);
+
+static const char *const ints[] = {
+    "1", "08", "12", "3", "0", "170926", "2", "40", "270", "44", "2024", "7",
+};
+static const uint8_t INTS = sizeof(ints) / sizeof(ints[0]);
+
+/// A latitude or longitude field, its direction and its exact fixed value
+typedef struct {
+    const char *value;  ///< DDMM.mmmm or DDDMM.mmmm
+    const char *dir;    ///< N, S, E or W
+    int32_t fixed;      ///< degrees * 10000000, truncated
+} coord_t;
+
+static const coord_t coords[] = {
+    {"4807.038", "N", 481173000},       {"01131.000", "E", 115166666},
+    {"4807.0390", "N", 481173166},      {"01131.0010", "E", 115166833},
+    {"3352.1280", "S", -338688000},     {"15112.5600", "E", 1512093333},
+    {"5130.4853", "N", 515080883},      {"00007.6540", "W", -1275666},
+    {"0000.0001", "S", -16},            {"00000.0001", "W", -16},
+    {"8959.999999", "N", 899999999},    {"17959.999999", "W", -1799999999},
+    {"3723.2475", "N", 373874583},      {"12158.3416", "W", -1219723600},
+    {"2232.123456", "S", -225353909},   {"04345.67891", "W", -437613151},
+};
+static const uint8_t COORDS = sizeof(coords) / sizeof(coords[0]);
+
+static volatile int64_t sink;  ///< keeps the timed work from being dropped
+
+/// The fixed point part of parseCoord() as it was, with atol() and atof()
+static bool oldCoord(const char *p, const char *pDir, int32_t *angle_fixed) {
+    char degreebuff[10] = {0};
+    const char *e = strchr(p, '.');
+    if (e == NULL || e - p > 6)
+        return false;
+    strncpy(degreebuff, p, e - p);
+    long dddmm = atol(degreebuff);
+    long degrees = (dddmm / 100);
+    long minutes = dddmm - degrees * 100;
+    nmea_float_t decminutes = atof(e);
+    long fixed = degrees * 10000000 + (minutes * 10000000) / 60 +
+                 (decminutes * 10000000) / 60;
+    if (*pDir == 'S' || *pDir == 'W')
+        fixed = -fixed;
+    *angle_fixed = fixed;
+    return true;
+}
+
+/// ns per field of a pass over a set of fields
+template <typename F>
+static double timeFields(uint8_t n, F parse) {
+    uint32_t start = micros();
+    for (uint32_t r = 0; r < RUNS; r++) {
+        for (uint8_t i = 0; i < n; i++)
+            sink += parse(i);
+    }
+    return (micros() - start) * 1e3 / RUNS / n;
+}
+
+/// Report a timing against the one it replaced as a test message
+static void report(const char *name, double now, double was,
+                   const char *wasName) {
+    char msg[120];
+    snprintf(msg, sizeof(msg), "%s %.1f ns, %s %.1f ns per field", name, now,
+             wasName, was);
+    TEST_MESSAGE(msg);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_numbers_match_the_library_functions(void) {
+    for (uint8_t i = 0; i < FLOATS; i++) {
+        double want = atof(floats[i]);
+        TEST_ASSERT_FLOAT_WITHIN(fabs(want) * 1e-6, want,
+                                 nmea::parseFloat(floats[i]));
+        // none has more than 3 decimals, so the scaled value is exact
+        int32_t fixed;
+        TEST_ASSERT_TRUE(nmea::parseFixed(floats[i], 3, &fixed));
+        TEST_ASSERT_EQUAL_INT32(lround(want * 1000), fixed);
+    }
+    for (uint8_t i = 0; i < INTS; i++)
+        TEST_ASSERT_EQUAL_INT32(atoi(ints[i]), nmea::parseInt(ints[i]));
+}
+
+void test_coords_are_exact(void) {
+    int32_t worst = 0;
+    for (uint8_t i = 0; i < COORDS; i++) {
+        const coord_t &c = coords[i];
+        int32_t fixed = 0, old = 0;
+        TEST_ASSERT_TRUE_MESSAGE(nmea::parseCoord(c.value, c.dir, &fixed),
+                                 c.value);
+        TEST_ASSERT_EQUAL_INT32_MESSAGE(c.fixed, fixed, c.value);
+        oldCoord(c.value, c.dir, &old);
+        worst = max(worst, (int32_t)abs(old - c.fixed));
+    }
+    // and whole sentences give the same through parse() and the receiver
+    static const char *const sentences[] = {
+        "$GPGGA,120000.00,4807.0380,N,01131.0000,E,1,08,0.9,545.4,M,46.9,M,,"
+        "*67",
+        "$GPRMC,120001.00,A,4807.0390,N,01131.0010,E,0.11,54.80,170926,,,A"
+        "*6C",
+    };
+    const int32_t lat[] = {481173000, 481173166}, lon[] = {115166666,
+                                                           115166833};
+    INA_Receiver<ReplayTransport> gps("");
+    gps.begin();
+    for (uint8_t i = 0; i < 2; i++) {
+        nmea_fix_t f;
+        TEST_ASSERT_TRUE(nmea::parse(sentences[i], NULL, f));
+        TEST_ASSERT_EQUAL_INT32(lat[i], f.latitude_fixed);
+        TEST_ASSERT_EQUAL_INT32(lon[i], f.longitude_fixed);
+        char buff[MAXLINELENGTH];
+        strcpy(buff, sentences[i]);
+        TEST_ASSERT_TRUE(gps.parse(buff));
+        TEST_ASSERT_EQUAL_INT32(lat[i], gps.latitude_fixed);
+        TEST_ASSERT_EQUAL_INT32(lon[i], gps.longitude_fixed);
+    }
+    char msg[80];
+    snprintf(msg, sizeof(msg), "old parseCoord() off by up to %ld",
+             (long)worst);
+    TEST_MESSAGE(msg);
+}
+
+void test_time_the_parsers(void) {
+    double parseFloatNs = timeFields(FLOATS, [](uint8_t i) {
+        return (int64_t)(nmea::parseFloat(floats[i]) * 1000);
+    });
+    double atofNs = timeFields(
+        FLOATS, [](uint8_t i) { return (int64_t)(atof(floats[i]) * 1000); });
+    double parseFixedNs = timeFields(FLOATS, [](uint8_t i) {
+        int32_t v = 0;
+        nmea::parseFixed(floats[i], 3, &v);
+        return (int64_t)v;
+    });
+    double parseIntNs = timeFields(
+        INTS, [](uint8_t i) { return (int64_t)nmea::parseInt(ints[i]); });
+    double atoiNs =
+        timeFields(INTS, [](uint8_t i) { return (int64_t)atoi(ints[i]); });
+    double coordNs = timeFields(COORDS, [](uint8_t i) {
+        int32_t v = 0;
+        nmea::parseCoord(coords[i].value, coords[i].dir, &v);
+        return (int64_t)v;
+    });
+    double oldCoordNs = timeFields(COORDS, [](uint8_t i) {
+        int32_t v = 0;
+        oldCoord(coords[i].value, coords[i].dir, &v);
+        return (int64_t)v;
+    });
+    report("parseFloat()", parseFloatNs, atofNs, "atof()");
+    report("parseFixed()", parseFixedNs, atofNs, "atof()");
+    report("parseInt()", parseIntNs, atoiNs, "atoi()");
+    report("parseCoord()", coordNs, oldCoordNs, "with atol() and atof()");
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_numbers_match_the_library_functions);
+    RUN_TEST(test_coords_are_exact);
+    RUN_TEST(test_time_the_parsers);
+    return UNITY_END();
+}
@@ -0,0 +1,116 @@
+/*!
+ * @file test_main.cpp
+ * @brief Host benchmark of reading the GPS over I2C: read() one character
+ * per call, as getData() used to spin on it, against poll() fetching all
+ * the packets the receiver has ready and splitting the lines in bulk.
+ * The bus is the test/host Wire, replaying 10 Hz RMC, GGA, GSA and GSV.
+ * @n Run with: pio test -e native -f test_bench_poll
+ * @copyright   MIT License
+ */
+#include <INA.h>
+#include <time.h>
+#include <unity.h>
+
+#define EPOCHS 2000  ///< epochs of four sentences the GPS sends
+
+static char text[EPOCHS * 4 * 80];  ///< everything the GPS sends
+static size_t textLen = 0;          ///< bytes in text
+
+static INA_Receiver<I2CTransport> gps(&Wire);
+
+/// Add a sentence to text, with its checksum and CR LF
+static void add(const char *body) {
+    uint8_t sum = 0;
+    for (const char *p = body; *p; p++)
+        sum ^= *p;
+    textLen += snprintf(text + textLen, sizeof(text) - textLen,
+                        "$%s*%02X\r\n", body, sum);
+}
+
+/// Wall and CPU time of a read of the whole text
+typedef struct {
+    double us;         ///< wall time
+    double cpu;        ///< CPU time in us
+    uint32_t lines;    ///< sentences produced
+    uint32_t calls;    ///< read() or poll() calls
+    uint32_t fetches;  ///< I2C requests
+} run_t;
+
+/// Replay the text over the bus and time reading it with one of the paths
+static run_t timeRead(bool bulk) {
+    run_t r = {};
+    Wire.replay(text);
+    gps.begin();
+    clock_t cpu = clock();
+    uint32_t start = micros();
+    while (r.lines < EPOCHS * 4) {
+        r.calls++;
+        if (bulk) {
+            r.lines += gps.poll();
+        } else {
+            gps.read();
+            if (gps.newNMEAreceived())
+                r.lines++;
+        }
+        while (gps.newNMEAreceived())
+            gps.lastNMEA();
+    }
+    r.us = micros() - start;
+    r.cpu = (clock() - cpu) * 1e6 / CLOCKS_PER_SEC;
+    r.fetches = Wire.requests;
+    return r;
+}
+
+/// Report a run as a test message
+static void report(const char *name, const run_t &r) {
+    char msg[160];
+    snprintf(msg, sizeof(msg),
+             "%s: %.0f kB/s, %.1f us CPU per sentence, %u calls, "
+             "%u I2C requests",
+             name, textLen / r.us * 1e3, r.cpu / r.lines, (unsigned)r.calls,
+             (unsigned)r.fetches);
+    TEST_MESSAGE(msg);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_bulk_poll_against_read(void) {
+    for (uint16_t i = 0; i < EPOCHS; i++) {
+        char body[MAXLINELENGTH];
+        uint8_t s = i / 10 % 60, cs = i % 10;
+        snprintf(body, sizeof(body),
+                 "GPRMC,1200%02u.%u0,A,4807.038,N,01131.000,E,0.10,54.70,"
+                 "170926,,,A",
+                 s, cs);
+        add(body);
+        snprintf(body, sizeof(body),
+                 "GPGGA,1200%02u.%u0,4807.038,N,01131.000,E,1,08,0.9,545.4,"
+                 "M,46.9,M,,",
+                 s, cs);
+        add(body);
+        add("GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1");
+        add("GPGSV,1,1,04,04,15,270,40,05,01,010,38,09,06,292,41,12,40,100,"
+            "44");
+    }
+
+    run_t perChar = timeRead(false);
+    run_t bulk = timeRead(true);
+    report("read() per character", perChar);
+    report("poll() in bulk", bulk);
+    TEST_ASSERT_EQUAL_UINT32(EPOCHS * 4, perChar.lines);
+    TEST_ASSERT_EQUAL_UINT32(EPOCHS * 4, bulk.lines);
+    TEST_ASSERT_LESS_THAN(perChar.calls / 100, bulk.calls);
+    // both fetch the same packets, poll() just takes more of them per call
+    TEST_ASSERT_UINT32_WITHIN(bulk.fetches / 100 + 2, perChar.fetches,
+                              bulk.fetches);
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_bulk_poll_against_read);
+    return UNITY_END();
+}
@@ -0,0 +1,142 @@
+/*!
+ * @file test_main.cpp
+ * @brief Host tests and benchmark of smoothing on every update, the
+ * default, against setLazySmoothing(), which smooths each value for the
+ * time it held. Both should follow a step alike, and lazy smoothing must
+ * not depend on how often it is read. One workload updates 100 times per
+ * read, as a sketch logging the GPS now and then, the other reads 100
+ * times per update, as a display would.
+ * @n Run with: pio test -e native -f test_bench_smoothing, and add
+ * -D NMEA_FAST_TRIG to the build_flags of the native env to time the
+ * polynomial sine and cosine.
+ * @copyright   MIT License
+ */
+#include <INA.h>
+#include <unity.h>
+
+#define ROUNDS 10000  ///< rounds of each workload
+#define BURST 100     ///< the calls of the busy side in one round
+
+static INA_Receiver<ReplayTransport> gps("");
+
+#ifdef NMEA_EXTENSIONS
+static volatile nmea_float_t sink;  ///< keeps the reads from being dropped
+
+/// ns per call for ROUNDS rounds of updates and reads of NMEA_COG
+static double timeRounds(uint16_t updates, uint16_t reads) {
+    uint32_t start = micros();
+    for (uint32_t r = 0; r < ROUNDS; r++) {
+        for (uint16_t i = 0; i < updates; i++)
+            gps.newDataValue(NMEA_COG, (r * 7 + i) % 360);
+        for (uint16_t i = 0; i < reads; i++)
+            sink = gps.getSmoothed(NMEA_COG);
+    }
+    return (micros() - start) * 1e3 / ROUNDS / (updates + reads);
+}
+
+/// Feed a steady angle for a few time constants and read it back smoothed
+static nmea_float_t settle(nmea_float_t angle) {
+    for (uint8_t i = 0; i < 60; i++) {
+        gps.newDataValue(NMEA_COG, angle);
+        delay(1);
+    }
+    return gps.getSmoothed(NMEA_COG);
+}
+#endif
+
+void setUp(void) {
+#ifdef NMEA_EXTENSIONS
+    gps.begin();
+    gps.setLazySmoothing(false);
+    // a tau of 10 ms, for the angle and the sine and cosine it comes from
+    for (uint8_t i = NMEA_COG; i <= NMEA_COG_COS; i++) {
+        nmea_index_t idx = (nmea_index_t)i;
+        gps.initDataValue(idx, NULL, NULL, NULL, 10, gps.getDataDef(idx)->type);
+    }
+#endif
+}
+
+void tearDown(void) {}
+
+void test_both_modes_settle_on_the_angle(void) {
+#ifdef NMEA_EXTENSIONS
+    TEST_ASSERT_TRUE(gps.isCompoundAngle(NMEA_COG));
+    TEST_ASSERT_FLOAT_WITHIN(0.5, 350, settle(350));
+    TEST_ASSERT_FLOAT_WITHIN(0.5, 10, settle(10));  // the short way round
+    gps.setLazySmoothing(true);
+    TEST_ASSERT_FLOAT_WITHIN(0.5, 350, settle(350));
+    TEST_ASSERT_FLOAT_WITHIN(0.5, 10, settle(10));
+#else
+    TEST_IGNORE_MESSAGE("needs NMEA_EXTENSIONS");
+#endif
+}
+
+void test_lazy_and_eager_agree_on_a_step(void) {
+#ifdef NMEA_EXTENSIONS
+    // eager, lazy read on every update, and lazy read once at the end
+    INA_Receiver<ReplayTransport> eager(""), lazy(""), lazyOnce("");
+    INA_Receiver<ReplayTransport> *all[] = {&eager, &lazy, &lazyOnce};
+    for (INA_Receiver<ReplayTransport> *r : all) {
+        r->begin();
+        r->initDataValue(NMEA_SOG, NULL, NULL, NULL, 50);
+    }
+    lazy.setLazySmoothing(true);
+    lazyOnce.setLazySmoothing(true);
+    // 0 for a while, then a step to 100 for about two time constants
+    uint32_t start = millis(), step = 0;
+    while (millis() - start < 200) {
+        nmea_float_t v = millis() - start < 100 ? 0 : 100;
+        if (v > 0 && step == 0)
+            step = millis();
+        for (INA_Receiver<ReplayTransport> *r : all)
+            r->newDataValue(NMEA_SOG, v);
+        lazy.getSmoothed(NMEA_SOG);
+        delay(1);
+    }
+    nmea_float_t expected = 100 * (1 - exp(-(double)(millis() - step) / 50));
+    TEST_ASSERT_FLOAT_WITHIN(4, expected, eager.getSmoothed(NMEA_SOG));
+    TEST_ASSERT_FLOAT_WITHIN(4, expected, lazy.getSmoothed(NMEA_SOG));
+    TEST_ASSERT_FLOAT_WITHIN(4, expected, lazyOnce.getSmoothed(NMEA_SOG));
+    TEST_ASSERT_FLOAT_WITHIN(0.5, lazy.getSmoothed(NMEA_SOG),
+                             lazyOnce.getSmoothed(NMEA_SOG));
+#else
+    TEST_IGNORE_MESSAGE("needs NMEA_EXTENSIONS");
+#endif
+}
+
+void test_time_the_workloads(void) {
+#ifdef NMEA_EXTENSIONS
+#ifdef NMEA_FAST_TRIG
+    const char *trig = "NMEA_FAST_TRIG";
+#else
+    const char *trig = "sin() and cos()";
+#endif
+    double eagerUpdates = timeRounds(BURST, 1);
+    double eagerReads = timeRounds(1, BURST);
+    gps.setLazySmoothing(true);
+    double lazyUpdates = timeRounds(BURST, 1);
+    double lazyReads = timeRounds(1, BURST);
+
+    char msg[120];
+    snprintf(msg, sizeof(msg),
+             "%s, ns per call: update heavy %.1f eager, %.1f lazy", trig,
+             eagerUpdates, lazyUpdates);
+    TEST_MESSAGE(msg);
+    snprintf(msg, sizeof(msg),
+             "%s, ns per call: read heavy %.1f eager, %.1f lazy", trig,
+             eagerReads, lazyReads);
+    TEST_MESSAGE(msg);
+#else
+    TEST_IGNORE_MESSAGE("needs NMEA_EXTENSIONS");
+#endif
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_both_modes_settle_on_the_angle);
+    RUN_TEST(test_lazy_and_eager_agree_on_a_step);
+    RUN_TEST(test_time_the_workloads);
+    return UNITY_END();
+}
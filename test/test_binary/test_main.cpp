@@ -0,0 +1,187 @@
+/*!
+ * @file test_main.cpp
+ * @brief Host tests of the fixPacked() and fixMsgPack() records: what goes
+ * in comes back out, what they can't carry reads back as 0, and anything
+ * that isn't a whole record of this version is refused.
+ * @n Run with: pio test -e native -f test_binary
+ * @copyright   MIT License
+ */
+#include <INA.h>
+#include <unity.h>
+
+/// A DGPS fix south of the equator and west of Greenwich
+static nmea_fix_t sample(void) {
+    nmea_fix_t f;
+    f.have = NMEA_FIX_DEFAULT | NMEA_FIX_DOP;
+    f.year = 26;
+    f.month = 9;
+    f.day = 17;
+    f.hour = 12;
+    f.minute = 34;
+    f.seconds = 56;
+    f.milliseconds = 780;
+    f.latitude_fixed = -338688000;    // Sydney's latitude
+    f.longitude_fixed = -1183600000;  // and a longitude in the west
+    f.altitude_fixed = -123;
+    f.speed_fixed = 4567;
+    f.angle_fixed = 35999;
+    f.HDOP = 1.23;
+    f.fix = true;
+    f.fixquality = 2;
+    f.fixquality_3d = 3;
+    f.satellites = 9;
+    return f;
+}
+
+/// Check that b holds what a has in the groups of fields b has
+static void assertSame(const nmea_fix_t &a, const nmea_fix_t &b) {
+    TEST_ASSERT_EQUAL_UINT16(a.have, b.have);
+    TEST_ASSERT_EQUAL_UINT64(nmea::epochMillis(a), nmea::epochMillis(b));
+    TEST_ASSERT_EQUAL(a.fix, b.fix);
+    TEST_ASSERT_EQUAL_INT32(a.latitude_fixed, b.latitude_fixed);
+    TEST_ASSERT_EQUAL_INT32(a.longitude_fixed, b.longitude_fixed);
+    TEST_ASSERT_EQUAL_INT32(a.altitude_fixed, b.altitude_fixed);
+    TEST_ASSERT_EQUAL_INT32(a.speed_fixed, b.speed_fixed);
+    TEST_ASSERT_EQUAL_INT32(a.angle_fixed, b.angle_fixed);
+    TEST_ASSERT_EQUAL_UINT8(a.fixquality, b.fixquality);
+    TEST_ASSERT_EQUAL_UINT8(a.fixquality_3d, b.fixquality_3d);
+    TEST_ASSERT_EQUAL_UINT8(a.satellites, b.satellites);
+    TEST_ASSERT_FLOAT_WITHIN(0.005, a.HDOP, b.HDOP);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_packed_round_trip(void) {
+    nmea_fix_t f = sample(), g;
+    uint8_t buff[INA_PACKED_SIZE];
+    TEST_ASSERT_EQUAL(INA_PACKED_SIZE,
+                      INA_Core::fixPacked(f, buff, sizeof(buff)));
+    TEST_ASSERT_TRUE(INA_Core::unpackFix(buff, sizeof(buff), g));
+    assertSame(f, g);
+    TEST_ASSERT_EQUAL_UINT8(780 / 10, g.milliseconds / 10);
+}
+
+void test_msgpack_round_trip(void) {
+    nmea_fix_t f = sample(), g;
+    uint8_t buff[128];
+    size_t n = INA_Core::fixMsgPack(f, buff, sizeof(buff));
+    TEST_ASSERT_GREATER_THAN(0, n);
+    TEST_ASSERT_TRUE(INA_Core::unpackMsgPack(buff, n, g));
+    assertSame(f, g);
+}
+
+void test_missing_groups_read_back_as_zero(void) {
+    nmea_fix_t f = sample(), g;
+    f.have = NMEA_FIX_TIME | NMEA_FIX_DATE | NMEA_FIX_STATUS;
+    uint8_t buff[128];
+    size_t n = INA_Core::fixMsgPack(f, buff, sizeof(buff));
+    TEST_ASSERT_TRUE(INA_Core::unpackMsgPack(buff, n, g));
+    TEST_ASSERT_EQUAL_UINT16(f.have, g.have);
+    TEST_ASSERT_EQUAL_UINT64(nmea::epochMillis(f), nmea::epochMillis(g));
+    TEST_ASSERT_EQUAL_INT32(0, g.latitude_fixed);
+    TEST_ASSERT_EQUAL_INT32(0, g.longitude_fixed);
+    TEST_ASSERT_EQUAL_INT32(0, g.altitude_fixed);
+    TEST_ASSERT_EQUAL_INT32(0, g.speed_fixed);
+    TEST_ASSERT_EQUAL_INT32(0, g.angle_fixed);
+    TEST_ASSERT_EQUAL_UINT8(0, g.satellites);
+    TEST_ASSERT_EQUAL_FLOAT(0, g.HDOP);
+
+    // the packed record always has room for them, and keeps them
+    TEST_ASSERT_EQUAL(INA_PACKED_SIZE,
+                      INA_Core::fixPacked(f, buff, sizeof(buff)));
+    TEST_ASSERT_TRUE(INA_Core::unpackFix(buff, INA_PACKED_SIZE, g));
+    assertSame(f, g);
+
+    // fields no record carries are 0
+    f.geoidheight_fixed = 469;
+    f.VDOP = 2.1;
+    f.satellitesInView = 12;
+    INA_Core::fixPacked(f, buff, sizeof(buff));
+    INA_Core::unpackFix(buff, INA_PACKED_SIZE, g);
+    TEST_ASSERT_EQUAL_INT32(0, g.geoidheight_fixed);
+    TEST_ASSERT_EQUAL_FLOAT(0, g.VDOP);
+    TEST_ASSERT_EQUAL_UINT8(0, g.satellitesInView);
+}
+
+void test_hdop_is_clamped(void) {
+    nmea_fix_t f = sample(), g;
+    uint8_t packed[INA_PACKED_SIZE], buff[128];
+    const nmea_float_t hdop[] = {655.35, 999.9, -1.5, 0};
+    const nmea_float_t want[] = {655.35, 655.35, 0, 0};
+    for (uint8_t i = 0; i < 4; i++) {
+        f.HDOP = hdop[i];
+        INA_Core::fixPacked(f, packed, sizeof(packed));
+        TEST_ASSERT_TRUE(INA_Core::unpackFix(packed, sizeof(packed), g));
+        TEST_ASSERT_FLOAT_WITHIN(0.005, want[i], g.HDOP);
+        size_t n = INA_Core::fixMsgPack(f, buff, sizeof(buff));
+        TEST_ASSERT_TRUE(INA_Core::unpackMsgPack(buff, n, g));
+        TEST_ASSERT_FLOAT_WITHIN(0.005, want[i], g.HDOP);
+    }
+}
+
+void test_refuses_other_records(void) {
+    nmea_fix_t f = sample(), g;
+    g.satellites = 42;
+    uint8_t buff[128];
+    INA_Core::fixPacked(f, buff, sizeof(buff));
+    buff[0] = 'X';
+    TEST_ASSERT_FALSE(INA_Core::unpackFix(buff, INA_PACKED_SIZE, g));
+    buff[0] = 'I';
+    buff[1] = INA_PACKED_VERSION + 1;
+    TEST_ASSERT_FALSE(INA_Core::unpackFix(buff, INA_PACKED_SIZE, g));
+    TEST_ASSERT_FALSE(INA_Core::unpackFix(NULL, INA_PACKED_SIZE, g));
+
+    // a map of another version, and bytes that aren't MessagePack
+    const uint8_t v2[] = {0x81, 0xA1, 'v', 0x02};
+    TEST_ASSERT_FALSE(INA_Core::unpackMsgPack(v2, sizeof(v2), g));
+    const uint8_t garbage[] = {0xC1, 0xFF, 0x00, 0x13};
+    TEST_ASSERT_FALSE(INA_Core::unpackMsgPack(garbage, sizeof(garbage), g));
+    TEST_ASSERT_FALSE(INA_Core::unpackMsgPack(NULL, 8, g));
+    TEST_ASSERT_EQUAL_UINT8(42, g.satellites);  // untouched on failure
+}
+
+void test_refuses_short_buffers(void) {
+    nmea_fix_t f = sample(), g;
+    uint8_t buff[128];
+    TEST_ASSERT_EQUAL(0, INA_Core::fixPacked(f, buff, INA_PACKED_SIZE - 1));
+    TEST_ASSERT_EQUAL(0, INA_Core::fixPacked(f, NULL, INA_PACKED_SIZE));
+    INA_Core::fixPacked(f, buff, sizeof(buff));
+    TEST_ASSERT_FALSE(INA_Core::unpackFix(buff, INA_PACKED_SIZE - 1, g));
+
+    size_t n = INA_Core::fixMsgPack(f, buff, sizeof(buff));
+    TEST_ASSERT_GREATER_THAN(0, n);
+    TEST_ASSERT_EQUAL(0, INA_Core::fixMsgPack(f, buff, n - 1));
+    TEST_ASSERT_FALSE(INA_Core::unpackMsgPack(buff, n - 1, g));
+}
+
+void test_records_are_smaller_than_json(void) {
+    nmea_fix_t f = sample();
+    char json[512];
+    uint8_t buff[128];
+    size_t text = INA_Core::fixJSON(f, json, sizeof(json));
+    size_t packed = INA_Core::fixPacked(f, buff, sizeof(buff));
+    size_t msgpack = INA_Core::fixMsgPack(f, buff, sizeof(buff));
+    char msg[80];
+    snprintf(msg, sizeof(msg), "JSON %u, packed %u, MessagePack %u bytes",
+             (unsigned)text, (unsigned)packed, (unsigned)msgpack);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN(sizeof(json), text);  // not cut short
+    TEST_ASSERT_LESS_THAN(text / 3, packed);
+    TEST_ASSERT_LESS_THAN(text / 2, msgpack);
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_packed_round_trip);
+    RUN_TEST(test_msgpack_round_trip);
+    RUN_TEST(test_missing_groups_read_back_as_zero);
+    RUN_TEST(test_hdop_is_clamped);
+    RUN_TEST(test_refuses_other_records);
+    RUN_TEST(test_refuses_short_buffers);
+    RUN_TEST(test_records_are_smaller_than_json);
+    return UNITY_END();
+}
@@ -0,0 +1,162 @@
+/*!
+ * @file test_main.cpp
+ * @brief Host tests of the stateless NMEA core: coordinates, and the epoch
+ * times and the ISO 8601 text written from them, which must read as the
+ * sprintf() they replaced did
+ * @n Run with: pio test -e native -f test_core
+ * @copyright   MIT License
+ */
+#include <INA.h>
+#include <unity.h>
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_coord_in_range(void) {
+    int32_t fixed;
+    char dir;
+    TEST_ASSERT_TRUE(nmea::parseCoord("4807.038", "N", &fixed, &dir));
+    TEST_ASSERT_EQUAL_INT32(481173000, fixed);
+    TEST_ASSERT_EQUAL_CHAR('N', dir);
+    TEST_ASSERT_TRUE(nmea::parseCoord("01131.000", "W", &fixed));
+    TEST_ASSERT_EQUAL_INT32(-115166666, fixed);
+    TEST_ASSERT_TRUE(nmea::parseCoord("9000.0", "S", &fixed));
+    TEST_ASSERT_EQUAL_INT32(-900000000, fixed);
+    TEST_ASSERT_TRUE(nmea::parseCoord("18000.0", "E", &fixed));
+    TEST_ASSERT_EQUAL_INT32(1800000000, fixed);
+}
+
+void test_coord_rejects_too_many_digits(void) {
+    int32_t fixed = 12345;
+    TEST_ASSERT_FALSE(nmea::parseCoord("04807.038", "N", &fixed));
+    TEST_ASSERT_FALSE(nmea::parseCoord("001131.000", "E", &fixed));
+    TEST_ASSERT_FALSE(nmea::parseCoord("999900.0", "E", &fixed));
+    TEST_ASSERT_EQUAL_INT32(12345, fixed);  // untouched on failure
+}
+
+void test_coord_rejects_out_of_range(void) {
+    int32_t fixed = 12345;
+    TEST_ASSERT_FALSE(nmea::parseCoord("9100.0", "N", &fixed));
+    TEST_ASSERT_FALSE(nmea::parseCoord("9000.1", "S", &fixed));
+    TEST_ASSERT_FALSE(nmea::parseCoord("18100.0", "E", &fixed));
+    TEST_ASSERT_FALSE(nmea::parseCoord("18000.5", "W", &fixed));
+    TEST_ASSERT_FALSE(nmea::parseCoord("99999.9", "W", &fixed));
+    TEST_ASSERT_EQUAL_INT32(12345, fixed);
+}
+
+void test_coord_rejects_bad_fields(void) {
+    int32_t fixed;
+    TEST_ASSERT_FALSE(nmea::parseCoord(",", "N", &fixed));
+    TEST_ASSERT_FALSE(nmea::parseCoord("4807.038", ",", &fixed));
+    TEST_ASSERT_FALSE(nmea::parseCoord("4807.038", "X", &fixed));
+    TEST_ASSERT_FALSE(nmea::parseCoord("4807", "N", &fixed));
+}
+
+/// A record with a time and, if year is not 0xFF, a date
+static nmea_fix_t at(uint8_t year, uint8_t month, uint8_t day, uint8_t hour,
+                     uint8_t minute, uint8_t seconds, uint16_t ms) {
+    nmea_fix_t f;
+    f.have = NMEA_FIX_TIME;
+    if (year != 0xFF) {
+        f.year = year;
+        f.month = month;
+        f.day = day;
+        f.have |= NMEA_FIX_DATE;
+    }
+    f.hour = hour;
+    f.minute = minute;
+    f.seconds = seconds;
+    f.milliseconds = ms;
+    return f;
+}
+
+/// Check isoTime() of a record against the sprintf() it replaced, with and
+/// without a cache, and that epochMillis() and fromEpochMillis() agree
+static void assertIso(const nmea_fix_t &f, nmea_iso_date_t *cache) {
+    char want[32], got[NMEA_ISO_TIME_SIZE];
+    snprintf(want, sizeof(want), "20%02d-%02d-%02dT%02d:%02d:%02d.%03dZ",
+             f.year, f.month, f.day, f.hour, f.minute, f.seconds,
+             f.milliseconds);
+    uint64_t ms = nmea::epochMillis(f);
+    TEST_ASSERT_EQUAL(NMEA_ISO_TIME_SIZE - 1, nmea::isoTime(ms, got));
+    TEST_ASSERT_EQUAL_STRING(want, got);
+    nmea::isoTime(ms, got, cache);
+    TEST_ASSERT_EQUAL_STRING(want, got);
+
+    nmea_fix_t g;
+    nmea::fromEpochMillis(ms, g);
+    TEST_ASSERT_EQUAL_UINT16(f.have, g.have);
+    TEST_ASSERT_EQUAL_UINT64(ms, nmea::epochMillis(g));
+    TEST_ASSERT_EQUAL_UINT8(f.day, g.day);
+    TEST_ASSERT_EQUAL_UINT16(f.milliseconds, g.milliseconds);
+}
+
+void test_days_from_civil(void) {
+    TEST_ASSERT_EQUAL_UINT32(0, nmea::daysFromCivil(1970, 1, 1));
+    TEST_ASSERT_EQUAL_UINT32(10957, nmea::daysFromCivil(2000, 1, 1));
+    TEST_ASSERT_EQUAL_UINT32(nmea::daysFromCivil(2024, 2, 28) + 1,
+                             nmea::daysFromCivil(2024, 2, 29));
+    TEST_ASSERT_EQUAL_UINT32(nmea::daysFromCivil(2024, 2, 29) + 1,
+                             nmea::daysFromCivil(2024, 3, 1));
+    TEST_ASSERT_EQUAL_UINT32(nmea::daysFromCivil(2023, 2, 28) + 1,
+                             nmea::daysFromCivil(2023, 3, 1));
+    TEST_ASSERT_EQUAL_UINT32(nmea::daysFromCivil(2000, 1, 1) + 36524,
+                             nmea::daysFromCivil(2099, 12, 31));
+}
+
+void test_iso_time_matches_sprintf(void) {
+    nmea_iso_date_t cache;
+    assertIso(at(24, 2, 29, 12, 0, 0, 0), &cache);      // a leap day
+    assertIso(at(24, 2, 29, 23, 59, 59, 999), &cache);  // its last ms
+    assertIso(at(24, 3, 1, 0, 0, 0, 0), &cache);        // and the next day
+    assertIso(at(0, 1, 1, 0, 0, 0, 0), &cache);         // year 2000
+    assertIso(at(99, 12, 31, 23, 59, 59, 999), &cache); // and 2099
+    assertIso(at(26, 9, 17, 12, 34, 56, 7), &cache);    // ms under 100
+    assertIso(at(26, 9, 17, 12, 34, 56, 50), &cache);
+    assertIso(at(26, 9, 17, 9, 5, 3, 99), &cache);
+}
+
+void test_iso_time_cache_across_midnight(void) {
+    nmea_iso_date_t cache;
+    // 10 Hz across midnight, then back before it, as a replayed log might
+    for (uint16_t i = 0; i < 20; i++) {
+        uint32_t t = 86399000 + i * 100;  // from 23:59:59.000
+        bool next = t >= 86400000;
+        t %= 86400000;
+        uint8_t h = t / 3600000, m = t / 60000 % 60, s = t / 1000 % 60;
+        assertIso(next ? at(27, 1, 1, h, m, s, t % 1000)
+                       : at(26, 12, 31, h, m, s, t % 1000),
+                  &cache);
+    }
+    assertIso(at(26, 12, 31, 23, 59, 59, 999), &cache);
+    assertIso(at(27, 1, 1, 0, 0, 0, 0), &cache);
+}
+
+void test_iso_time_without_a_date(void) {
+    nmea_iso_date_t cache;
+    nmea_fix_t f = at(0xFF, 0, 0, 12, 34, 56, 78);
+    TEST_ASSERT_LESS_THAN(86400000ULL, nmea::epochMillis(f));
+    assertIso(f, &cache);  // 2000-00-00, as sprintf() gave
+    char got[NMEA_ISO_TIME_SIZE];
+    nmea::isoTime(nmea::epochMillis(f), got);
+    TEST_ASSERT_EQUAL_STRING("2000-00-00T12:34:56.078Z", got);
+    // and a date after it replaces the one cached
+    assertIso(at(26, 9, 17, 12, 34, 56, 78), &cache);
+    assertIso(f, &cache);
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_coord_in_range);
+    RUN_TEST(test_coord_rejects_too_many_digits);
+    RUN_TEST(test_coord_rejects_out_of_range);
+    RUN_TEST(test_coord_rejects_bad_fields);
+    RUN_TEST(test_days_from_civil);
+    RUN_TEST(test_iso_time_matches_sprintf);
+    RUN_TEST(test_iso_time_cache_across_midnight);
+    RUN_TEST(test_iso_time_without_a_date);
+    return UNITY_END();
+}
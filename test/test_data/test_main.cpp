@@ -0,0 +1,410 @@
+/*!
+ * @file test_main.cpp
+ * @brief Host tests of changing data value definitions at run time with
+ * initDataValue(), of their running statistics, subscriptions and history
+ * tiers, and of carving their history and statistics out of an arena
+ * @n Run with: pio test -e native -f test_data
+ * @copyright   MIT License
+ */
+#include <INA.h>
+#include <unity.h>
+
+#include <new>
+
+static uint32_t allocations = 0;  ///< operator new calls so far
+
+void *operator new(size_t size) {
+    allocations++;
+    void *p = malloc(size);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+
+void operator delete(void *p, size_t size) noexcept {
+    (void)size;
+    free(p);
+}
+
+#ifdef NMEA_EXTENSIONS
+static const char *const labels[NMEA_USR_COUNT] = {
+    "U0", "U1", "U2", "U3", "U4", "U5", "U6",
+    "U7", "U8", "U9", "U10", "U11", "U12",
+};
+#endif
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_every_user_value_can_be_changed(void) {
+#ifdef NMEA_EXTENSIONS
+    INA_Receiver<ReplayTransport> gps("");
+    for (uint8_t i = 0; i < NMEA_USR_COUNT; i++) {
+        nmea_index_t idx = (nmea_index_t)(NMEA_USR_00 + i);
+        TEST_ASSERT_EQUAL_STRING("NUL", gps.getDataDef(idx)->label);
+        TEST_ASSERT_TRUE(gps.initDataValue(idx, labels[i], "%4.0f", "l", 500));
+    }
+    for (uint8_t i = 0; i < NMEA_USR_COUNT; i++) {
+        const nmea_datadef_t *d =
+            gps.getDataDef((nmea_index_t)(NMEA_USR_00 + i));
+        TEST_ASSERT_EQUAL_STRING(labels[i], d->label);
+        TEST_ASSERT_EQUAL_STRING("l", d->unit);
+        TEST_ASSERT_EQUAL_UINT16(500, d->response);
+    }
+    // and changing one again keeps what is not given
+    TEST_ASSERT_TRUE(gps.initDataValue(NMEA_USR_12, "Tank"));
+    TEST_ASSERT_EQUAL_STRING("Tank", gps.getDataDef(NMEA_USR_12)->label);
+    TEST_ASSERT_EQUAL_STRING("%4.0f", gps.getDataDef(NMEA_USR_12)->fmt);
+#else
+    TEST_IGNORE_MESSAGE("needs NMEA_EXTENSIONS");
+#endif
+}
+
+void test_other_values_share_the_overrides(void) {
+#ifdef NMEA_EXTENSIONS
+    INA_Receiver<ReplayTransport> gps("");
+    TEST_ASSERT_TRUE(gps.initDataValue(NMEA_USR_00, "Tank"));
+    uint8_t i = 0;
+    for (; i < NMEA_DATA_OVERRIDES; i++)
+        TEST_ASSERT_TRUE(gps.initDataValue((nmea_index_t)(NMEA_HDOP + i),
+                                           NULL, NULL, NULL, 100 + i));
+    TEST_ASSERT_FALSE(gps.initDataValue((nmea_index_t)(NMEA_HDOP + i)));
+    TEST_ASSERT_TRUE(gps.initDataValue(NMEA_HDOP, "HDOP"));  // has its slot
+    TEST_ASSERT_TRUE(gps.initDataValue(NMEA_USR_01, "Bilge"));
+    TEST_ASSERT_EQUAL_STRING("HDOP", gps.getDataDef(NMEA_HDOP)->label);
+    TEST_ASSERT_EQUAL_UINT16(100, gps.getDataDef(NMEA_HDOP)->response);
+    TEST_ASSERT_EQUAL_STRING("Tank", gps.getDataDef(NMEA_USR_00)->label);
+#else
+    TEST_IGNORE_MESSAGE("needs NMEA_EXTENSIONS");
+#endif
+}
+
+#ifdef NMEA_EXTENSIONS
+static uint32_t seed = 12345;  ///< of rnd()
+
+/// A repeatable pseudo random number under n
+static uint32_t rnd(uint32_t n) {
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 8) % n;
+}
+#endif
+
+void test_stats_match_a_rescan(void) {
+#ifdef NMEA_EXTENSIONS
+    INA_Receiver<ReplayTransport> gps("");
+    const uint16_t windows[] = {1, 7, 50};
+    static nmea_float_t seen[2000];
+    for (uint16_t n : windows) {
+        TEST_ASSERT_TRUE(gps.initStats(NMEA_DEPTH, n));
+        TEST_ASSERT_EQUAL_UINT16(0, gps.getStats(NMEA_DEPTH).count);
+        for (uint16_t i = 0; i < 2000; i++) {
+            // random, with runs that rise, fall and repeat to work the
+            // queues, and an offset to work the sliding variance
+            nmea_float_t v;
+            switch (i / 100 % 4) {
+            case 0: v = rnd(1000) / 10.0; break;
+            case 1: v = i % 100; break;
+            case 2: v = 100 - i % 100; break;
+            default: v = 1000 + rnd(3); break;
+            }
+            seen[i] = v;
+            gps.newDataValue(NMEA_DEPTH, v);
+
+            uint16_t count = min<uint16_t>(i + 1, n);
+            double lo = seen[i], hi = seen[i], sum = 0;
+            for (uint16_t j = i + 1 - count; j <= i; j++) {
+                lo = min<double>(lo, seen[j]);
+                hi = max<double>(hi, seen[j]);
+                sum += seen[j];
+            }
+            double mean = sum / count, ss = 0;
+            for (uint16_t j = i + 1 - count; j <= i; j++)
+                ss += (seen[j] - mean) * (seen[j] - mean);
+            double sd = count > 1 ? sqrt(ss / (count - 1)) : 0;
+
+            nmea_stats_t st = gps.getStats(NMEA_DEPTH);
+            TEST_ASSERT_EQUAL_UINT16(count, st.count);
+            TEST_ASSERT_EQUAL_FLOAT(lo, st.min);
+            TEST_ASSERT_EQUAL_FLOAT(hi, st.max);
+            TEST_ASSERT_FLOAT_WITHIN(1e-3 + fabs(mean) * 1e-5, mean, st.mean);
+            TEST_ASSERT_FLOAT_WITHIN(1e-3 + sd * 1e-4, sd, st.stddev);
+        }
+    }
+    gps.removeStats(NMEA_DEPTH);
+    TEST_ASSERT_EQUAL_UINT16(0, gps.getStats(NMEA_DEPTH).count);
+#else
+    TEST_IGNORE_MESSAGE("needs NMEA_EXTENSIONS");
+#endif
+}
+
+#ifdef NMEA_EXTENSIONS
+/// What a subscription's callback has been sent
+typedef struct {
+    INA_Core *gps = NULL;     ///< for unsubscribing from the callback
+    int8_t unsubscribe = -1;  ///< a subscription to end on the first call
+    uint8_t calls = 0;        ///< times called
+    nmea_float_t last = 0;    ///< value last sent
+} received_t;
+
+static void onValue(nmea_index_t idx, nmea_float_t value, void *arg) {
+    (void)idx;
+    received_t *r = (received_t *)arg;
+    r->calls++;
+    r->last = value;
+    if (r->unsubscribe >= 0) {
+        r->gps->unsubscribe(r->unsubscribe);
+        r->unsubscribe = -1;
+    }
+}
+
+/// Send values to a data value, and check which ones got through
+static void expectCalls(INA_Core &gps, nmea_index_t idx, received_t &r,
+                        const nmea_float_t *values, const bool *through,
+                        uint8_t n) {
+    for (uint8_t i = 0; i < n; i++) {
+        uint8_t calls = r.calls;
+        gps.newDataValue(idx, values[i]);
+        TEST_ASSERT_EQUAL_UINT8_MESSAGE(calls + through[i], r.calls,
+                                        "value passed on or held back");
+        if (through[i])
+            TEST_ASSERT_EQUAL_FLOAT(values[i], r.last);
+    }
+}
+#endif
+
+void test_subscriptions_apply_the_deadbands(void) {
+#ifdef NMEA_EXTENSIONS
+    INA_Receiver<ReplayTransport> gps("");
+    received_t abs, rel, any, angle;
+    TEST_ASSERT_GREATER_OR_EQUAL(
+        0, gps.subscribe(NMEA_SOG, onValue, &abs, 1.0));
+    const nmea_float_t sog[] = {5, 5.5, 5.99, 6, 5.2, 4.9};
+    const bool sogThrough[] = {true, false, false, true, false, true};
+    expectCalls(gps, NMEA_SOG, abs, sog, sogThrough, 6);
+
+    gps.subscribe(NMEA_DEPTH, onValue, &rel, 0, 0.1);  // 10% of the last
+    const nmea_float_t depth[] = {100, 105, 110.5, 100, 99};
+    const bool depthThrough[] = {true, false, true, false, true};
+    expectCalls(gps, NMEA_DEPTH, rel, depth, depthThrough, 5);
+
+    gps.subscribe(NMEA_AWS, onValue, &any);  // every change
+    const nmea_float_t aws[] = {1, 1, 2, 2, 1};
+    const bool awsThrough[] = {true, false, true, false, true};
+    expectCalls(gps, NMEA_AWS, any, aws, awsThrough, 5);
+
+    // measured the short way round through north
+    gps.subscribe(NMEA_COG, onValue, &angle, 5);
+    const nmea_float_t cog[] = {358, 2, 4, 0, 357};
+    const bool cogThrough[] = {true, false, true, false, true};
+    expectCalls(gps, NMEA_COG, angle, cog, cogThrough, 5);
+#else
+    TEST_IGNORE_MESSAGE("needs NMEA_EXTENSIONS");
+#endif
+}
+
+void test_subscriptions_keep_the_interval(void) {
+#ifdef NMEA_EXTENSIONS
+    INA_Receiver<ReplayTransport> gps("");
+    received_t r;
+    gps.subscribe(NMEA_AWS, onValue, &r, 0, 0, 50);
+    gps.newDataValue(NMEA_AWS, 1);
+    gps.newDataValue(NMEA_AWS, 2);  // too soon
+    TEST_ASSERT_EQUAL_UINT8(1, r.calls);
+    delay(60);
+    gps.newDataValue(NMEA_AWS, 2);  // the change held back
+    TEST_ASSERT_EQUAL_UINT8(2, r.calls);
+    TEST_ASSERT_EQUAL_FLOAT(2, r.last);
+    gps.newDataValue(NMEA_AWS, 3);  // too soon again
+    delay(60);
+    gps.newDataValue(NMEA_AWS, 2);  // back where it was passed on
+    TEST_ASSERT_EQUAL_UINT8(2, r.calls);
+#else
+    TEST_IGNORE_MESSAGE("needs NMEA_EXTENSIONS");
+#endif
+}
+
+void test_unsubscribe_from_a_callback(void) {
+#ifdef NMEA_EXTENSIONS
+    INA_Receiver<ReplayTransport> gps("");
+    received_t older, self, other;
+    // callbacks of a value are called newest first
+    int8_t olderId = gps.subscribe(NMEA_SOG, onValue, &older);
+    int8_t selfId = gps.subscribe(NMEA_SOG, onValue, &self);
+    self.gps = &gps;
+    self.unsubscribe = selfId;
+    gps.newDataValue(NMEA_SOG, 1);
+    gps.newDataValue(NMEA_SOG, 2);
+    TEST_ASSERT_EQUAL_UINT8(1, self.calls);
+    TEST_ASSERT_EQUAL_UINT8(2, older.calls);
+
+    // and one that ends the subscription it would be followed by
+    gps.subscribe(NMEA_SOG, onValue, &other);
+    other.gps = &gps;
+    other.unsubscribe = olderId;
+    gps.newDataValue(NMEA_SOG, 3);
+    gps.newDataValue(NMEA_SOG, 4);
+    TEST_ASSERT_EQUAL_UINT8(2, other.calls);
+    TEST_ASSERT_EQUAL_UINT8(2, older.calls);
+    gps.unsubscribe(olderId);  // already gone, so nothing happens
+#else
+    TEST_IGNORE_MESSAGE("needs NMEA_EXTENSIONS");
+#endif
+}
+
+void test_subscription_table_fills_without_allocating(void) {
+#ifdef NMEA_EXTENSIONS
+    INA_Receiver<ReplayTransport> gps("");
+    received_t r;
+    int8_t ids[NMEA_MAX_SUBSCRIPTIONS];
+    uint32_t before = allocations;
+    for (uint8_t i = 0; i < NMEA_MAX_SUBSCRIPTIONS; i++) {
+        ids[i] = gps.subscribe((nmea_index_t)(NMEA_HDOP + i), onValue, &r);
+        TEST_ASSERT_EQUAL_INT(i, ids[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(-1, gps.subscribe(NMEA_SOG, onValue, &r));
+    TEST_ASSERT_EQUAL_INT(-1, gps.subscribe(NMEA_SOG, NULL, &r));
+    TEST_ASSERT_EQUAL_INT(-1, gps.subscribe(NMEA_MAX_INDEX, onValue, &r));
+    for (uint8_t i = 0; i < NMEA_MAX_SUBSCRIPTIONS; i++)
+        gps.newDataValue((nmea_index_t)(NMEA_HDOP + i), 1);
+    TEST_ASSERT_EQUAL_UINT8(NMEA_MAX_SUBSCRIPTIONS, r.calls);
+    gps.unsubscribe(ids[3]);
+    TEST_ASSERT_EQUAL_INT(ids[3], gps.subscribe(NMEA_SOG, onValue, &r));
+    TEST_ASSERT_EQUAL_UINT32(before, allocations);
+#else
+    TEST_IGNORE_MESSAGE("needs NMEA_EXTENSIONS");
+#endif
+}
+
+#ifdef NMEA_EXTENSIONS
+/// Roll up factor points of a tier into the points of the next
+static unsigned rollup(const nmea_history_point_t *below, unsigned n,
+                       uint16_t factor, nmea_history_point_t *above) {
+    unsigned m = 0;
+    for (unsigned i = 0; i + factor <= n; i += factor, m++) {
+        nmea_history_point_t p = below[i];
+        int32_t sum = 0;
+        for (unsigned j = i; j < i + factor; j++) {
+            p.min = min(p.min, below[j].min);
+            p.max = max(p.max, below[j].max);
+            sum += below[j].mean;
+        }
+        p.mean = sum / factor;
+        above[m] = p;
+    }
+    return m;
+}
+
+/// Check points against the newest of the ones expected
+static void assertNewest(const nmea_history_point_t *want, unsigned wantN,
+                         const nmea_history_point_t *got, unsigned gotN) {
+    for (unsigned i = 0; i < gotN; i++) {
+        const nmea_history_point_t &w = want[wantN - gotN + i];
+        TEST_ASSERT_EQUAL_INT16(w.min, got[i].min);
+        TEST_ASSERT_EQUAL_INT16(w.mean, got[i].mean);
+        TEST_ASSERT_EQUAL_INT16(w.max, got[i].max);
+    }
+}
+#endif
+
+void test_history_rolls_up_into_tiers(void) {
+#ifdef NMEA_EXTENSIONS
+    INA_Receiver<ReplayTransport> gps("");
+    // a type that is not smoothed, so each sample is the value itself
+    TEST_ASSERT_TRUE(gps.initDataValue(NMEA_USR_00, "Count", NULL, NULL, 0,
+                                       NMEA_HHMMSS));
+    // 10 points of 20 s, 4 of 100 s and 3 of 300 s
+    nmea_history_t *h = gps.initHistory(NMEA_USR_00, 1.0, 0.0, 20, 10);
+    TEST_ASSERT_NOT_NULL(h);
+    TEST_ASSERT_TRUE(gps.addHistoryTier(NMEA_USR_00, 5, 4));
+    TEST_ASSERT_TRUE(gps.addHistoryTier(NMEA_USR_00, 3, 3));
+    TEST_ASSERT_FALSE(gps.addHistoryTier(NMEA_USR_00, 1, 3));
+    TEST_ASSERT_EQUAL(NMEA_HISTORY_BAD_TIER, gps.historyError());
+
+    const unsigned SAMPLES = 100;
+    static nmea_history_point_t base[SAMPLES], tier1[SAMPLES], tier2[SAMPLES];
+    h->historyInterval = 0;  // a sample on every update
+    for (unsigned i = 0; i < SAMPLES; i++) {
+        int16_t v = (i * 7) % 23;
+        base[i] = {v, v, v};
+        gps.newDataValue(NMEA_USR_00, v);
+        unsigned last = gps.historyCount(NMEA_USR_00) - 1;
+        TEST_ASSERT_EQUAL_INT16(v, gps.historyValue(NMEA_USR_00, last));
+    }
+    h->historyInterval = 20;
+    unsigned n1 = rollup(base, SAMPLES, 5, tier1);
+    unsigned n2 = rollup(tier1, n1, 3, tier2);
+    TEST_ASSERT_EQUAL(20, n1);
+    TEST_ASSERT_EQUAL(6, n2);
+    TEST_ASSERT_EQUAL(10, gps.historyCount(NMEA_USR_00));
+    TEST_ASSERT_EQUAL(4, h->tiers[0].count);
+    TEST_ASSERT_EQUAL(3, h->tiers[1].count);
+
+    // the finest tier that reaches back over the span, newest points last
+    nmea_history_point_t got[16];
+    uint32_t interval = 0;
+    TEST_ASSERT_EQUAL(10, gps.getHistory(NMEA_USR_00, 200, got, 16, &interval));
+    TEST_ASSERT_EQUAL_UINT32(20, interval);
+    assertNewest(base, SAMPLES, got, 10);
+    TEST_ASSERT_EQUAL(4, gps.getHistory(NMEA_USR_00, 200, got, 4, &interval));
+    assertNewest(base, SAMPLES, got, 4);
+    TEST_ASSERT_EQUAL(3, gps.getHistory(NMEA_USR_00, 60, got, 16, &interval));
+    TEST_ASSERT_EQUAL_UINT32(20, interval);
+    TEST_ASSERT_EQUAL(3, gps.getHistory(NMEA_USR_00, 201, got, 16, &interval));
+    TEST_ASSERT_EQUAL_UINT32(100, interval);
+    assertNewest(tier1, n1, got, 3);
+    TEST_ASSERT_EQUAL(4, gps.getHistory(NMEA_USR_00, 400, got, 16, &interval));
+    TEST_ASSERT_EQUAL_UINT32(100, interval);
+    assertNewest(tier1, n1, got, 4);
+    TEST_ASSERT_EQUAL(2, gps.getHistory(NMEA_USR_00, 401, got, 16, &interval));
+    TEST_ASSERT_EQUAL_UINT32(300, interval);
+    assertNewest(tier2, n2, got, 2);
+    // past the coarsest tier, all it has
+    TEST_ASSERT_EQUAL(3, gps.getHistory(NMEA_USR_00, 5000, got, 16, &interval));
+    TEST_ASSERT_EQUAL_UINT32(300, interval);
+    assertNewest(tier2, n2, got, 3);
+#else
+    TEST_IGNORE_MESSAGE("needs NMEA_EXTENSIONS");
+#endif
+}
+
+void test_arena_blocks_are_aligned(void) {
+#ifdef NMEA_EXTENSIONS
+    INA_Receiver<ReplayTransport> gps("");
+    static uint8_t arena[1024 + alignof(max_align_t)];
+    TEST_ASSERT_TRUE(gps.setHistoryArena(arena + 1, 1024));  // off boundary
+    // an odd number of int16_t samples, so the next block starts off a
+    // boundary unless it is rounded up to one
+    TEST_ASSERT_NOT_NULL(gps.initHistory(NMEA_DEPTH, 10.0, 0.0, 20, 11));
+    TEST_ASSERT_TRUE(gps.initStats(NMEA_DEPTH, 7));
+    TEST_ASSERT_TRUE(gps.initStats(NMEA_HDOP, 5));
+    const uint8_t idx[] = {NMEA_DEPTH, NMEA_HDOP};
+    for (uint8_t i : idx) {
+        TEST_ASSERT_NOT_NULL(gps.meta[i].stats);
+        TEST_ASSERT_EQUAL(0,
+                          (uintptr_t)gps.meta[i].stats % alignof(max_align_t));
+    }
+    TEST_ASSERT_EQUAL(
+        0, (uintptr_t)gps.meta[NMEA_DEPTH].hist % alignof(max_align_t));
+#else
+    TEST_IGNORE_MESSAGE("needs NMEA_EXTENSIONS");
+#endif
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_every_user_value_can_be_changed);
+    RUN_TEST(test_other_values_share_the_overrides);
+    RUN_TEST(test_stats_match_a_rescan);
+    RUN_TEST(test_subscriptions_apply_the_deadbands);
+    RUN_TEST(test_subscriptions_keep_the_interval);
+    RUN_TEST(test_unsubscribe_from_a_callback);
+    RUN_TEST(test_subscription_table_fills_without_allocating);
+    RUN_TEST(test_history_rolls_up_into_tiers);
+    RUN_TEST(test_arena_blocks_are_aligned);
+    return UNITY_END();
+}
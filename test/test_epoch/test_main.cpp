@@ -0,0 +1,193 @@
+/*!
+ * @file test_main.cpp
+ * @brief Host tests of the epoch assembler and of the getters that wait
+ * for it, with the GPS sending one sentence at a time.
+ * @n Run with: pio test -e native -f test_epoch
+ * @copyright   MIT License
+ */
+#include <INA.h>
+#include <unity.h>
+
+/**************************************************************************/
+/*!
+    Plays back NMEA text one line per fill(), like a GPS whose sentences
+    arrive some ms apart, so a poll() can end partway through an epoch.
+*/
+/**************************************************************************/
+class LineTransport {
+   public:
+    static const uint8_t FILLS_PER_POLL = 1;  ///< one line per poll()
+
+    LineTransport(const char *text) : _text(text), _next(text), _end(text) {}
+
+    bool begin(void) {
+        _next = _end = _text;
+        return true;
+    }
+
+    bool fill(void) {
+        const char *eol = strchr(_end, '\n');
+        if (eol == NULL)
+            return false;
+        _end = eol + 1;
+        return true;
+    }
+
+    size_t available(void) { return _end - _next; }
+
+    int read(void) { return _next < _end ? (uint8_t)*_next++ : -1; }
+
+    size_t write(uint8_t c) {
+        (void)c;
+        return 1;
+    }
+
+    void sendCommand(const char *str) { (void)str; }
+
+   private:
+    const char *_text;  ///< the text to replay
+    const char *_next;  ///< the next byte to replay
+    const char *_end;   ///< the end of the lines released so far
+};
+
+/// Two epochs of GGA and RMC, the first one followed by its GSA and GSV
+static const char text[] =
+    "$GPGGA,120000.00,4807.0380,N,01131.0000,E,1,08,0.9,545.4,M,46.9,M,,*67\r\n"
+    "$GPRMC,120000.00,A,4807.0380,N,01131.0000,E,0.10,54.70,170926,,,A*63\r\n"
+    "$GPGSA,A,3,04,05,09,12,24,,,,,,,,2.5,1.3,2.1*39\r\n"
+    "$GPGSV,1,1,04,04,15,270,40,05,01,010,38,09,06,292,41,12,40,100,44*77\r\n"
+    "$GPGGA,120001.00,4807.0390,N,01131.0010,E,1,08,0.9,545.5,M,46.9,M,,*67\r\n"
+    "$GPRMC,120001.00,A,4807.0390,N,01131.0010,E,0.11,54.80,170926,,,A*6C\r\n";
+
+/// Take the next epoch through a getter that waits for it
+static bool nextFix(INA_Receiver<LineTransport> &gps, nmea_fix_t &f) {
+    uint8_t buff[INA_PACKED_SIZE];
+    return gps.getPacked(buff, sizeof(buff)) == INA_PACKED_SIZE &&
+           INA_Core::unpackFix(buff, sizeof(buff), f);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_getters_wait_for_the_whole_epoch(void) {
+    INA_Receiver<LineTransport> gps(text);
+    gps.begin();
+    nmea_fix_t f;
+    TEST_ASSERT_TRUE(nextFix(gps, f));  // not after the GGA alone
+    TEST_ASSERT_EQUAL_UINT8(0, f.seconds);
+    TEST_ASSERT_EQUAL_UINT16(NMEA_FIX_DEFAULT, f.have);
+    TEST_ASSERT_EQUAL_INT32(481173000, f.latitude_fixed);
+    TEST_ASSERT_EQUAL_INT32(5470, f.angle_fixed);
+}
+
+void test_late_sentences_publish_the_epoch_again(void) {
+    INA_Receiver<LineTransport> gps(text);
+    gps.begin();
+    nmea_fix_t f;
+    nextFix(gps, f);
+
+    TEST_ASSERT_TRUE(nextFix(gps, f));  // the GSA
+    TEST_ASSERT_EQUAL_UINT8(0, f.seconds);
+    TEST_ASSERT_EQUAL_UINT16(NMEA_FIX_DEFAULT | NMEA_FIX_DOP, f.have);
+    TEST_ASSERT_EQUAL_UINT8(3, f.fixquality_3d);
+    TEST_ASSERT_FLOAT_WITHIN(0.005, 1.3, f.HDOP);
+
+    TEST_ASSERT_TRUE(nextFix(gps, f));  // the GSV
+    TEST_ASSERT_EQUAL_UINT8(0, f.seconds);
+    TEST_ASSERT_EQUAL_UINT16(NMEA_FIX_DEFAULT | NMEA_FIX_DOP | NMEA_FIX_INVIEW,
+                             f.have);
+
+    TEST_ASSERT_TRUE(nextFix(gps, f));
+    TEST_ASSERT_EQUAL_UINT8(1, f.seconds);
+    TEST_ASSERT_EQUAL_UINT16(NMEA_FIX_DEFAULT, f.have);
+    TEST_ASSERT_EQUAL_INT32(481173166, f.latitude_fixed);
+}
+
+void test_epoch_fields_include_late_sentences(void) {
+    INA_Receiver<LineTransport> gps(text);
+    gps.begin();
+    gps.setEpochFields(NMEA_FIX_DEFAULT | NMEA_FIX_DOP | NMEA_FIX_INVIEW);
+    nmea_fix_t f;
+    TEST_ASSERT_TRUE(nextFix(gps, f));
+    TEST_ASSERT_EQUAL_UINT8(0, f.seconds);
+    TEST_ASSERT_EQUAL_UINT16(NMEA_FIX_DEFAULT | NMEA_FIX_DOP | NMEA_FIX_INVIEW,
+                             f.have);
+}
+
+/// Parse a sentence body, adding the $ and the checksum
+static bool parseBody(INA_Receiver<LineTransport> &gps, const char *body) {
+    char buff[MAXLINELENGTH];
+    uint8_t sum = 0;
+    for (const char *p = body; *p; p++)
+        sum ^= *p;
+    snprintf(buff, sizeof(buff), "$%s*%02X", body, sum);
+    return gps.parse(buff);
+}
+
+void test_empty_fields_keep_the_last_value(void) {
+    INA_Receiver<LineTransport> gps("");
+    gps.begin();
+    TEST_ASSERT_TRUE(parseBody(
+        gps, "GPGGA,120000.00,4807.0380,N,01131.0000,E,1,08,0.9,545.4,M,46.9,"
+             "M,,"));
+    TEST_ASSERT_TRUE(parseBody(
+        gps, "GPRMC,120000.00,A,4807.0380,N,01131.0000,E,0.10,54.70,170926,,"
+             ",A"));
+    // stationary, so no course, and a GGA without HDOP or geoid height
+    TEST_ASSERT_TRUE(parseBody(
+        gps, "GPGGA,120001.00,4807.0390,N,01131.0010,E,1,,,545.5,M,,M,,"));
+    TEST_ASSERT_TRUE(parseBody(
+        gps, "GPRMC,120001.00,A,4807.0390,N,01131.0010,E,0.00,,170926,,,A"));
+    TEST_ASSERT_EQUAL_INT32(5470, gps.angle_fixed);
+    TEST_ASSERT_FLOAT_WITHIN(0.005, 54.7, gps.angle);
+    TEST_ASSERT_FLOAT_WITHIN(0.005, 0.9, gps.HDOP);
+    TEST_ASSERT_EQUAL_INT32(469, gps.geoidheight_fixed);
+    TEST_ASSERT_EQUAL_UINT8(8, gps.satellites);
+    TEST_ASSERT_EQUAL_INT32(5455, gps.altitude_fixed);
+    TEST_ASSERT_EQUAL_INT32(0, gps.speed_fixed);
+#ifdef NMEA_EXTENSIONS
+    TEST_ASSERT_FLOAT_WITHIN(0.005, 54.7, gps.get(NMEA_COG));
+    TEST_ASSERT_FLOAT_WITHIN(0.005, 0.9, gps.get(NMEA_HDOP));
+#endif
+    nmea_fix_t f;
+    TEST_ASSERT_TRUE(gps.getFix(f));
+    TEST_ASSERT_EQUAL_UINT8(1, f.seconds);
+    TEST_ASSERT_EQUAL_UINT16(NMEA_FIX_DEFAULT, f.have);
+    TEST_ASSERT_EQUAL_INT32(5470, f.angle_fixed);
+    TEST_ASSERT_EQUAL_INT32(469, f.geoidheight_fixed);
+    TEST_ASSERT_FLOAT_WITHIN(0.005, 0.9, f.HDOP);
+
+    // and the stateless core says which of them were there
+    nmea_fix_t got;
+    TEST_ASSERT_TRUE(nmea::parse(
+        "$GPRMC,120001.00,A,4807.0390,N,01131.0010,E,0.00,,170926,,,A*4B",
+        NULL, got));
+    TEST_ASSERT_TRUE(got.have & NMEA_FIX_VELOCITY);
+    TEST_ASSERT_FALSE(got.have & NMEA_FIX_COURSE);
+}
+
+void test_getters_give_up_after_the_timeout(void) {
+    INA_Receiver<LineTransport> gps(text);
+    gps.begin();
+    nmea_fix_t f;
+    for (uint8_t i = 0; i < 4; i++)
+        TEST_ASSERT_TRUE(nextFix(gps, f));
+    uint32_t start = millis();
+    TEST_ASSERT_FALSE(nextFix(gps, f));  // the text has run out
+    uint32_t waited = millis() - start;
+    TEST_ASSERT_GREATER_OR_EQUAL(INA_FIX_TIMEOUT, waited);
+    TEST_ASSERT_LESS_THAN(INA_FIX_TIMEOUT + 500, waited);
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_getters_wait_for_the_whole_epoch);
+    RUN_TEST(test_late_sentences_publish_the_epoch_again);
+    RUN_TEST(test_epoch_fields_include_late_sentences);
+    RUN_TEST(test_empty_fields_keep_the_last_value);
+    RUN_TEST(test_getters_give_up_after_the_timeout);
+    return UNITY_END();
+}
@@ -0,0 +1,420 @@
+/*!
+ * @file test_main.cpp
+ * @brief Host tests of the compact JSON documents. Batching fixes into one
+ * document with setBatch(), batchFix() and batchJSON(): when batchReady()
+ * says to send it, that it never outgrows its buffer, and that it reads
+ * back as JSON with the columns named once and a row per fix. Sending only
+ * what changed with deltaJSON(): the tolerances, the keyframes, the fields
+ * left out without a fix, and that a consumer applying the documents ends
+ * up with what fixJSON() says.
+ * @n Run with: pio test -e native -f test_json
+ * @copyright   MIT License
+ */
+#include <INA.h>
+#include <unity.h>
+
+/// Fix i of a boat going north at 5 knots, one per second
+static nmea_fix_t sample(uint32_t i) {
+    nmea_fix_t f;
+    f.have = NMEA_FIX_DEFAULT | NMEA_FIX_DOP;
+    f.year = 26;
+    f.month = 9;
+    f.day = 17;
+    f.hour = 12;
+    f.minute = i / 60 % 60;
+    f.seconds = i % 60;
+    f.latitude_fixed = -338688000 + i * 23;
+    f.longitude_fixed = 1512093333;
+    f.altitude_fixed = 12;
+    f.speed_fixed = 5000;
+    f.angle_fixed = 35900 + i % 100;
+    f.HDOP = 0.9;
+    f.fix = true;
+    f.fixquality = 1;
+    f.fixquality_3d = 3;
+    f.satellites = 8 + i % 4;
+    return f;
+}
+
+/// Read the batch document back, checking it is whole and has rows rows
+static void assertDocument(INA_Core &gps, uint16_t rows) {
+    size_t len = 0;
+    const char *json = gps.batchJSON(&len);
+    TEST_ASSERT_NOT_NULL(json);
+    TEST_ASSERT_EQUAL(strlen(json), len);
+    JsonDocument doc;
+    TEST_ASSERT_FALSE_MESSAGE(deserializeJson(doc, json, len), json);
+    TEST_ASSERT_EQUAL(9, doc["INA"]["cols"].size());
+    TEST_ASSERT_TRUE(doc["INA"]["rows"].is<JsonArray>());
+    TEST_ASSERT_EQUAL(rows, doc["INA"]["rows"].size());
+    TEST_ASSERT_EQUAL_UINT16(rows, gps.batchCount());
+}
+
+/// One entry of what a deltaJSON() consumer has
+typedef struct {
+    char name[16];   ///< the name of the entry
+    char value[48];  ///< its value, as text
+} entry_t;
+
+/// What a deltaJSON() consumer has, rebuilt from the documents
+typedef struct {
+    entry_t entry[12];  ///< the entries, in the order first seen
+    uint8_t n = 0;      ///< entries in use
+} state_t;
+
+/// The value of an entry as text, whatever its type
+static void valueText(JsonVariant v, char *text, size_t len) {
+    if (v.is<const char *>())
+        snprintf(text, len, "%s", v.as<const char *>());
+    else if (v.is<bool>())
+        snprintf(text, len, "%s", v.as<bool>() ? "true" : "false");
+    else
+        snprintf(text, len, "%.9g", v.as<double>());
+}
+
+/// The entry of a state with a name, NULL if it has none
+static entry_t *findEntry(state_t &st, const char *name) {
+    for (uint8_t i = 0; i < st.n; i++)
+        if (strcmp(st.entry[i].name, name) == 0)
+            return &st.entry[i];
+    return NULL;
+}
+
+/// Read a document into a state, a keyframe replacing all of it
+static bool applyJSON(state_t &st, const char *json) {
+    JsonDocument doc;
+    TEST_ASSERT_FALSE_MESSAGE(deserializeJson(doc, json), json);
+    bool key = doc["delta"].isNull();
+    if (key)
+        st.n = 0;
+    for (size_t i = 0; i < doc["INA"].size(); i++) {
+        JsonVariant e = doc["INA"][(int)i];
+        const char *name = e["name"].as<const char *>();
+        TEST_ASSERT_NOT_NULL(name);
+        entry_t *to = findEntry(st, name);
+        if (to == NULL) {
+            TEST_ASSERT_LESS_THAN(12, st.n);
+            to = &st.entry[st.n++];
+            snprintf(to->name, sizeof(to->name), "%s", name);
+        }
+        valueText(e["value"], to->value, sizeof(to->value));
+    }
+    return key;
+}
+
+/// deltaJSON() a fix into a buffer big enough for any of them
+static const char *sendDelta(const nmea_fix_t &f, nmea_delta_t &d) {
+    static char json[512];
+    TEST_ASSERT_LESS_THAN(sizeof(json), INA_Core::deltaJSON(f, d, json,
+                                                            sizeof(json)));
+    return json;
+}
+
+/// Number of entries in a document
+static size_t entries(const char *json) {
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, json));
+    return doc["INA"].size();
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_batch_reads_back_as_columns_and_rows(void) {
+    INA_Receiver<ReplayTransport> gps("");
+    static char buff[1024];
+    TEST_ASSERT_TRUE(gps.setBatch(buff, sizeof(buff)));
+    assertDocument(gps, 0);
+    nmea_fix_t none;  // no groups, so nulls but for the time
+    none.year = 26;
+    none.month = 9;
+    none.day = 17;
+    TEST_ASSERT_TRUE(gps.batchFix(sample(0)));
+    TEST_ASSERT_TRUE(gps.batchFix(none));
+    assertDocument(gps, 2);
+
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, gps.batchJSON()));
+    static const char *const cols[] = {"t",   "lat", "lon", "alt", "sog",
+                                       "cog", "sat", "fix", "hdop"};
+    for (int i = 0; i < 9; i++)
+        TEST_ASSERT_EQUAL_STRING(cols[i],
+                                 doc["INA"]["cols"][i].as<const char *>());
+    JsonVariant row = doc["INA"]["rows"][0];
+    TEST_ASSERT_EQUAL(9, row.size());
+    TEST_ASSERT_EQUAL_UINT64(nmea::epochMillis(sample(0)),
+                             row[0].as<uint64_t>());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, -33.8688, row[1].as<double>());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 151.209333, row[2].as<double>());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 1.2, row[3].as<double>());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 2.572, row[4].as<double>());  // m/s
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 359.0, row[5].as<double>());
+    TEST_ASSERT_EQUAL(8, row[6].as<int>());
+    TEST_ASSERT_TRUE(row[7].as<bool>());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.9, row[8].as<double>());
+    JsonVariant empty = doc["INA"]["rows"][1];
+    TEST_ASSERT_EQUAL(9, empty.size());
+    TEST_ASSERT_EQUAL_UINT64(nmea::epochMillis(none), empty[0].as<uint64_t>());
+    for (int i = 1; i < 6; i++)
+        TEST_ASSERT_TRUE(empty[i].isNull());
+    TEST_ASSERT_FALSE(empty[7].as<bool>());
+}
+
+void test_batch_ready_on_count(void) {
+    INA_Receiver<ReplayTransport> gps("");
+    static char buff[1024];
+    gps.setBatch(buff, sizeof(buff), 3);
+    TEST_ASSERT_FALSE(gps.batchReady());  // an empty batch never is
+    for (uint32_t i = 0; i < 3; i++) {
+        TEST_ASSERT_FALSE(gps.batchReady());
+        TEST_ASSERT_TRUE(gps.batchFix(sample(i)));
+    }
+    TEST_ASSERT_TRUE(gps.batchReady());
+    assertDocument(gps, 3);
+}
+
+void test_batch_ready_on_bytes(void) {
+    INA_Receiver<ReplayTransport> gps("");
+    static char buff[1024];
+    gps.setBatch(buff, sizeof(buff), 0, 300);
+    size_t len = 0;
+    uint16_t n = 0;
+    while (!gps.batchReady()) {
+        TEST_ASSERT_LESS_OR_EQUAL(300, len);
+        TEST_ASSERT_TRUE(gps.batchFix(sample(n++)));
+        gps.batchJSON(&len);
+    }
+    TEST_ASSERT_GREATER_THAN(300, len);
+    TEST_ASSERT_GREATER_THAN(1, n);
+    assertDocument(gps, n);
+}
+
+void test_batch_ready_on_age(void) {
+    INA_Receiver<ReplayTransport> gps("");
+    static char buff[1024];
+    gps.setBatch(buff, sizeof(buff), 0, 0, 1000);
+    TEST_ASSERT_TRUE(gps.batchFix(sample(0), 5000));
+    TEST_ASSERT_FALSE(gps.batchReady(5999));
+    // the age runs from the first row, not the last
+    TEST_ASSERT_TRUE(gps.batchFix(sample(1), 5900));
+    TEST_ASSERT_FALSE(gps.batchReady(5999));
+    TEST_ASSERT_TRUE(gps.batchReady(6000));
+    gps.clearBatch();
+    TEST_ASSERT_TRUE(gps.batchFix(sample(2), 7000));
+    TEST_ASSERT_FALSE(gps.batchReady(7999));
+    TEST_ASSERT_TRUE(gps.batchReady(8000));
+}
+
+void test_no_limits_but_the_buffer(void) {
+    INA_Receiver<ReplayTransport> gps("");
+    static char buff[4096];
+    gps.setBatch(buff, sizeof(buff), 0);  // no count, bytes or age
+    uint16_t n = 0;
+    while (!gps.batchReady()) {
+        TEST_ASSERT_TRUE(gps.batchFix(sample(n), n * 1000));
+        n++;
+        TEST_ASSERT_LESS_THAN(200, n);
+    }
+    // ready when another row like the last would not fit
+    TEST_ASSERT_GREATER_THAN(40, n);
+    assertDocument(gps, n);
+}
+
+void test_full_batch_refuses_rows(void) {
+    INA_Receiver<ReplayTransport> gps("");
+    static char buff[400];
+    gps.setBatch(buff, sizeof(buff), 0);
+    uint16_t n = 0;
+    while (gps.batchFix(sample(n)))
+        n++;
+    TEST_ASSERT_GREATER_THAN(0, n);
+    TEST_ASSERT_TRUE(gps.batchReady());
+    assertDocument(gps, n);  // the refused row left no trace
+    size_t len = 0;
+    gps.batchJSON(&len);
+    TEST_ASSERT_LESS_THAN(sizeof(buff), len);
+
+    // sent, the batch takes rows from an empty document again
+    gps.clearBatch();
+    TEST_ASSERT_FALSE(gps.batchReady());
+    assertDocument(gps, 0);
+    TEST_ASSERT_TRUE(gps.batchFix(sample(n)));
+    assertDocument(gps, 1);
+}
+
+void test_batch_needs_a_buffer(void) {
+    INA_Receiver<ReplayTransport> gps("");
+    static char buff[16];
+    TEST_ASSERT_FALSE(gps.batchFix(sample(0)));
+    TEST_ASSERT_NULL(gps.batchJSON());
+    TEST_ASSERT_FALSE(gps.setBatch(buff, sizeof(buff)));
+    TEST_ASSERT_FALSE(gps.batchFix(sample(0)));
+    TEST_ASSERT_FALSE(gps.setBatch(NULL, 0));
+    TEST_ASSERT_FALSE(gps.batchReady());
+}
+
+void test_delta_sends_what_moved_past_the_tolerance(void) {
+    nmea_delta_t d;
+    d.keyframe = 0;  // only the first
+    d.tolerance[NMEA_DELTA_SOG] = 100;
+    d.tolerance[NMEA_DELTA_COG] = 50;
+    nmea_fix_t f = sample(0);
+    f.angle_fixed = 35990;
+    const char *json = sendDelta(f, d);
+    TEST_ASSERT_NULL(strstr(json, "\"delta\""));
+    TEST_ASSERT_EQUAL(8, entries(json));
+
+    json = sendDelta(f, d);  // nothing moved
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"delta\":true"));
+    TEST_ASSERT_EQUAL(1, entries(json));  // the timestamp
+    f.speed_fixed += 100;  // by the tolerance
+    TEST_ASSERT_NULL(strstr(sendDelta(f, d), "SoG"));
+    f.speed_fixed += 1;  // and past it
+    TEST_ASSERT_NOT_NULL(strstr(sendDelta(f, d), "SoG"));
+    TEST_ASSERT_EQUAL_INT32(f.speed_fixed, d.last[NMEA_DELTA_SOG]);
+    // a creep adds up against what was last sent
+    f.speed_fixed += 60;
+    TEST_ASSERT_NULL(strstr(sendDelta(f, d), "SoG"));
+    f.speed_fixed += 60;
+    TEST_ASSERT_NOT_NULL(strstr(sendDelta(f, d), "SoG"));
+    // 359.9 to 0.2 is 0.3 degrees, the short way round
+    f.angle_fixed = 20;
+    TEST_ASSERT_NULL(strstr(sendDelta(f, d), "CoG"));
+    f.angle_fixed = 100;
+    TEST_ASSERT_NOT_NULL(strstr(sendDelta(f, d), "CoG"));
+    // the location carries both, so a move in one sends both
+    f.longitude_fixed += 1;
+    json = sendDelta(f, d);
+    TEST_ASSERT_NOT_NULL(strstr(json, "POINT"));
+    TEST_ASSERT_EQUAL(2, entries(json));
+}
+
+void test_delta_keyframes(void) {
+    nmea_delta_t d;
+    d.keyframe = 5;
+    nmea_fix_t f = sample(0);
+    for (uint8_t i = 0; i < 12; i++) {
+        const char *json = sendDelta(f, d);
+        bool key = strstr(json, "\"delta\"") == NULL;
+        TEST_ASSERT_EQUAL_MESSAGE(i % 5 == 0, key, json);
+        TEST_ASSERT_EQUAL(key ? 8 : 1, entries(json));
+    }
+    nmea_delta_t never;
+    never.keyframe = 0;
+    TEST_ASSERT_EQUAL(8, entries(sendDelta(f, never)));
+    for (uint8_t i = 0; i < 100; i++)
+        TEST_ASSERT_EQUAL(1, entries(sendDelta(f, never)));
+}
+
+void test_delta_without_a_fix(void) {
+    nmea_delta_t d;
+    d.keyframe = 4;
+    nmea_fix_t f = sample(0);
+    sendDelta(f, d);
+    int32_t lat = d.last[NMEA_DELTA_LAT];
+
+    nmea_fix_t lost = sample(50);  // moved, but no fix
+    lost.fix = false;
+    const char *json = sendDelta(lost, d);
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"delta\":true"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"Fix\",\"value\":false"));
+    TEST_ASSERT_NULL(strstr(json, "POINT"));
+    TEST_ASSERT_NULL(strstr(json, "Sat"));
+    TEST_ASSERT_EQUAL_INT32(lat, d.last[NMEA_DELTA_LAT]);  // not sent
+    // a keyframe can't carry the position, so they go on until one can
+    for (uint8_t i = 0; i < 2; i++)
+        TEST_ASSERT_NOT_NULL(strstr(sendDelta(lost, d), "\"delta\""));
+    for (uint8_t i = 0; i < 3; i++) {
+        json = sendDelta(lost, d);
+        TEST_ASSERT_NULL(strstr(json, "\"delta\""));
+        TEST_ASSERT_NULL(strstr(json, "POINT"));
+    }
+    json = sendDelta(f, d);
+    TEST_ASSERT_NULL(strstr(json, "\"delta\""));
+    TEST_ASSERT_NOT_NULL(strstr(json, "POINT"));
+    TEST_ASSERT_EQUAL(8, entries(json));
+    TEST_ASSERT_NOT_NULL(strstr(sendDelta(f, d), "\"delta\":true"));
+
+    // back where it was lost, the consumer still has the position
+    lost = f;
+    lost.fix = false;
+    sendDelta(lost, d);
+    json = sendDelta(f, d);
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"Fix\",\"value\":true"));
+    TEST_ASSERT_NULL(strstr(json, "POINT"));
+}
+
+void test_delta_short_buffer_keeps_the_state(void) {
+    nmea_delta_t d;
+    nmea_fix_t f = sample(0);
+    char small[40];
+    size_t n = INA_Core::deltaJSON(f, d, small, sizeof(small));
+    TEST_ASSERT_GREATER_OR_EQUAL(sizeof(small), n);
+    TEST_ASSERT_EQUAL(sizeof(small) - 1, strlen(small));
+    TEST_ASSERT_FALSE(d.primed);  // still owed the keyframe
+    TEST_ASSERT_EQUAL(n, strlen(sendDelta(f, d)));
+    TEST_ASSERT_TRUE(d.primed);
+
+    nmea_delta_t was = d;
+    nmea_fix_t moved = sample(10);
+    TEST_ASSERT_GREATER_OR_EQUAL(
+        sizeof(small), INA_Core::deltaJSON(moved, d, small, sizeof(small)));
+    TEST_ASSERT_EQUAL_INT32_ARRAY(was.last, d.last, NMEA_DELTA_FIELDS);
+    TEST_ASSERT_EQUAL_UINT16(was.sinceKey, d.sinceKey);
+    // so the fix goes again in full, and nothing is lost
+    const char *json = sendDelta(moved, d);
+    TEST_ASSERT_NOT_NULL(strstr(json, "POINT"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "CoG"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "Sat"));
+}
+
+void test_delta_rebuilds_what_fixJSON_says(void) {
+    nmea_delta_t d;
+    d.keyframe = 7;
+    state_t st;
+    uint16_t keys = 0;
+    for (uint32_t i = 0; i < 80; i++) {
+        // moving every third fix, but for a stop while the fix is lost
+        nmea_fix_t f = sample((i < 20 || i >= 40 ? i : 20) / 3);
+        f.speed_fixed = 5000 + i * 37 % 300;
+        f.altitude_fixed = 12 + i / 5;
+        f.HDOP = 0.8 + i % 4 / 10.0;
+        f.fix = i < 20 || i >= 33;  // lost for longer than a keyframe
+        keys += applyJSON(st, sendDelta(f, d));
+
+        char json[512];
+        TEST_ASSERT_LESS_THAN(sizeof(json),
+                              INA_Core::fixJSON(f, json, sizeof(json)));
+        state_t full;
+        applyJSON(full, json);
+        for (uint8_t e = 0; e < full.n; e++) {
+            entry_t *have = findEntry(st, full.entry[e].name);
+            TEST_ASSERT_NOT_NULL_MESSAGE(have, full.entry[e].name);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(full.entry[e].value, have->value,
+                                             full.entry[e].name);
+        }
+        if (f.fix)
+            TEST_ASSERT_EQUAL_UINT8(full.n, st.n);
+    }
+    TEST_ASSERT_GREATER_THAN(8, keys);
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_batch_reads_back_as_columns_and_rows);
+    RUN_TEST(test_batch_ready_on_count);
+    RUN_TEST(test_batch_ready_on_bytes);
+    RUN_TEST(test_batch_ready_on_age);
+    RUN_TEST(test_no_limits_but_the_buffer);
+    RUN_TEST(test_full_batch_refuses_rows);
+    RUN_TEST(test_batch_needs_a_buffer);
+    RUN_TEST(test_delta_sends_what_moved_past_the_tolerance);
+    RUN_TEST(test_delta_keyframes);
+    RUN_TEST(test_delta_without_a_fix);
+    RUN_TEST(test_delta_short_buffer_keeps_the_state);
+    RUN_TEST(test_delta_rebuilds_what_fixJSON_says);
+    return UNITY_END();
+}
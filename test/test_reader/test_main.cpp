@@ -0,0 +1,144 @@
+/*!
+ * @file test_main.cpp
+ * @brief Host tests of the background reader: a std::thread polling a
+ * ReplayTransport into the sentence queue while the test collects the
+ * sentences, as a sketch would with an ESP32 reader task.
+ * @n Run with: pio test -e native -f test_reader
+ * @copyright   MIT License
+ */
+#include <INA.h>
+#include <unity.h>
+
+#include <ctime>
+
+/// Three epochs of GGA and RMC, as the GPS sends them once a second
+static const char *const lines[] = {
+    "$GPGGA,120000.00,4807.0380,N,01131.0000,E,1,08,0.9,545.4,M,46.9,M,,*67\r\n",
+    "$GPRMC,120000.00,A,4807.0380,N,01131.0000,E,0.10,54.70,170926,,,A*63\r\n",
+    "$GPGGA,120001.00,4807.0390,N,01131.0010,E,1,08,0.9,545.5,M,46.9,M,,*67\r\n",
+    "$GPRMC,120001.00,A,4807.0390,N,01131.0010,E,0.11,54.80,170926,,,A*6C\r\n",
+    "$GPGGA,120002.00,4807.0400,N,01131.0020,E,1,09,0.8,545.6,M,46.9,M,,*6A\r\n",
+    "$GPRMC,120002.00,A,4807.0400,N,01131.0020,E,0.12,54.90,170926,,,A*60\r\n",
+};
+static const uint8_t LINES = sizeof(lines) / sizeof(lines[0]);
+
+static char text[(MAXLINELENGTH + 2) * 2 * NMEA_QUEUE_DEPTH];
+
+/// The receiver, outside the tests so tearDown() can stop its reader even
+/// when a failed assertion leaves a test early
+static INA_Receiver<ReplayTransport> gps(text);
+
+/// Put the lines in text as many times as asked
+static void replay(uint8_t times) {
+    text[0] = 0;
+    for (uint8_t t = 0; t < times; t++) {
+        for (uint8_t i = 0; i < LINES; i++)
+            strcat(text, lines[i]);
+    }
+}
+
+void setUp(void) {}
+
+void tearDown(void) { gps.stopReader(); }
+
+void test_reader_queues_every_sentence(void) {
+    replay(1);
+    TEST_ASSERT_TRUE(gps.begin());
+    TEST_ASSERT_TRUE(gps.startReader(0, 1));
+
+    char buff[MAXLINELENGTH];
+    for (uint8_t i = 0; i < LINES; i++) {
+        TEST_ASSERT_TRUE(gps.nextNMEA(buff, sizeof(buff), 1000));
+        TEST_ASSERT_EQUAL_STRING(lines[i], buff);
+    }
+    TEST_ASSERT_FALSE(gps.nextNMEA(buff, sizeof(buff), 50));
+    TEST_ASSERT_EQUAL_UINT32(0, gps.lostNMEA());
+}
+
+void test_reader_counts_what_the_queue_cannot_hold(void) {
+    replay(2);
+    gps.begin();
+    gps.startReader(0, 1);
+    delay(50);  // no one takes sentences, so the queue fills up
+    gps.stopReader();
+
+    TEST_ASSERT_EQUAL_UINT8(NMEA_QUEUE_DEPTH, gps.pendingNMEA());
+    TEST_ASSERT_EQUAL_UINT32(2 * LINES - NMEA_QUEUE_DEPTH, gps.lostNMEA());
+    char buff[MAXLINELENGTH];
+    for (uint8_t i = 0; i < NMEA_QUEUE_DEPTH; i++) {
+        TEST_ASSERT_TRUE(gps.nextNMEA(buff, sizeof(buff)));
+        TEST_ASSERT_EQUAL_STRING(lines[i % LINES], buff);  // oldest kept
+    }
+}
+
+void test_getters_wait_for_the_reader(void) {
+    replay(1);
+    gps.begin();
+    gps.startReader(0, 1);
+
+    uint8_t buff[INA_PACKED_SIZE];
+    nmea_fix_t f;
+    TEST_ASSERT_EQUAL(INA_PACKED_SIZE, gps.getPacked(buff, sizeof(buff)));
+    TEST_ASSERT_TRUE(INA_Core::unpackFix(buff, sizeof(buff), f));
+    TEST_ASSERT_EQUAL_UINT8(12, f.hour);
+    TEST_ASSERT_EQUAL_UINT8(2, f.seconds);  // the newest of what was queued
+    TEST_ASSERT_EQUAL_INT32(481173333, f.latitude_fixed);
+    TEST_ASSERT_EQUAL_INT32(115167000, f.longitude_fixed);
+}
+
+void test_reader_and_stream_decode_exclude_each_other(void) {
+    replay(1);
+    gps.begin();
+    TEST_ASSERT_TRUE(gps.setStreamDecode(true));
+    TEST_ASSERT_FALSE(gps.startReader(0, 1));
+    TEST_ASSERT_TRUE(gps.setStreamDecode(false));
+    TEST_ASSERT_TRUE(gps.startReader(0, 1));
+    TEST_ASSERT_FALSE(gps.startReader(0, 1));  // already running
+    TEST_ASSERT_FALSE(gps.setStreamDecode(true));
+}
+
+void test_begin_drains_the_queue(void) {
+    replay(1);
+    gps.begin();
+    gps.startReader(0, 1);
+    char buff[MAXLINELENGTH];
+    TEST_ASSERT_TRUE(gps.nextNMEA(buff, sizeof(buff), 1000));
+    gps.stopReader();
+    TEST_ASSERT_TRUE(gps.pendingNMEA() > 0);
+
+    gps.begin();
+    TEST_ASSERT_EQUAL_UINT8(0, gps.pendingNMEA());
+}
+
+void test_wait_for_sentence_sleeps_and_gives_up(void) {
+    replay(1);
+    gps.begin();
+    gps.startReader(0, 1);
+    TEST_ASSERT_TRUE(gps.waitForSentence("$GPRMC,120001"));
+
+    // nothing more comes, so it gives up after INA_FIX_TIMEOUT ms, asleep
+    uint32_t start = millis();
+    std::clock_t cpu = std::clock();
+    TEST_ASSERT_FALSE(gps.waitForSentence("$PMTK"));
+    uint32_t waited = millis() - start;
+    double busy = (std::clock() - cpu) * 1000.0 / CLOCKS_PER_SEC;
+    TEST_ASSERT_UINT32_WITHIN(200, INA_FIX_TIMEOUT + 100, waited);
+    TEST_ASSERT_LESS_THAN(waited / 4, (uint32_t)busy);
+
+    // and polling the transport itself, it gives up too
+    gps.stopReader();
+    TEST_ASSERT_FALSE(gps.waitForSentence("$PMTK"));
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_reader_queues_every_sentence);
+    RUN_TEST(test_reader_counts_what_the_queue_cannot_hold);
+    RUN_TEST(test_getters_wait_for_the_reader);
+    RUN_TEST(test_reader_and_stream_decode_exclude_each_other);
+    RUN_TEST(test_begin_drains_the_queue);
+    RUN_TEST(test_wait_for_sentence_sleeps_and_gives_up);
+    return UNITY_END();
+}
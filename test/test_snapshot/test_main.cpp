@@ -0,0 +1,116 @@
+/*!
+ * @file test_main.cpp
+ * @brief Host stress test of snapshot(): one thread parses synthetic GGA
+ * sentences as fast as it can while others take snapshots, and every
+ * snapshot has to hold the time, position and data values of one sentence.
+ * @n Run with: pio test -e native -f test_snapshot
+ * @copyright   MIT License
+ */
+#include <INA.h>
+#include <unity.h>
+
+#include <atomic>
+#include <thread>
+
+#define SENTENCES 200000  ///< sentences the writer parses
+#define READERS 2         ///< threads taking snapshots
+
+/// GGA sentence n, whose time, latitude and longitude all follow from n
+static void sentence(uint32_t n, char *buff, size_t len) {
+    uint32_t s = n % 86400;
+    int k = snprintf(buff, len,
+                     "$GPGGA,%02u%02u%02u.00,%02u%02u.%04u,N,%03u%02u.%04u,E,"
+                     "1,08,0.9,%u.0,M,46.9,M,,*",
+                     s / 3600, s / 60 % 60, s % 60, s % 90, n % 60, n % 10000,
+                     s % 180, n / 7 % 60, n * 7 % 10000, n % 1000);
+    uint8_t sum = 0;
+    for (int i = 1; i < k - 1; i++)
+        sum ^= buff[i];
+    snprintf(buff + k, len - k, "%02X\r\n", sum);
+}
+
+/// The n the time of a record says it came from, give or take a day
+static uint32_t sentenceOf(const nmea_fix_t &f) {
+    return f.hour * 3600 + f.minute * 60 + f.seconds;
+}
+
+static INA_Receiver<ReplayTransport> gps("");
+static std::atomic<bool> writing;
+static std::atomic<uint32_t> snaps, torn;
+
+/// Take snapshots until the writer is done, counting the inconsistent ones
+static void reader(void) {
+    nmea_fix_t f, want;
+    nmea_float_t latest[NMEA_MAX_INDEX];
+    char buff[MAXLINELENGTH];
+    uint32_t last = 0;
+    while (writing) {
+        uint32_t count = gps.snapshot(f, latest);
+        if (count < last)
+            torn++;  // epochs went backwards
+        last = count;
+        if (count == 0)
+            continue;
+        // look for the sentence among those with the same time of day
+        bool match = false;
+        for (uint32_t n = sentenceOf(f); n < SENTENCES && !match; n += 86400) {
+            sentence(n, buff, sizeof(buff));
+            want = nmea_fix_t();
+            nmea::parse(buff, NULL, want);
+            match = f.latitude_fixed == want.latitude_fixed &&
+                    f.longitude_fixed == want.longitude_fixed &&
+                    f.altitude_fixed == want.altitude_fixed;
+#ifdef NMEA_EXTENSIONS
+            match = match && latest[NMEA_LAT] ==
+                                 want.latitude_fixed / (nmea_float_t)10000000.;
+#endif
+        }
+        if (!match)
+            torn++;
+        snaps++;
+    }
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_snapshots_never_mix_sentences(void) {
+    gps.begin();
+    gps.setEpochFields(NMEA_FIX_TIME | NMEA_FIX_POSITION | NMEA_FIX_ALTITUDE);
+    writing = true;
+    snaps = torn = 0;
+    std::thread readers[READERS];
+    for (uint8_t i = 0; i < READERS; i++)
+        readers[i] = std::thread(reader);
+
+    char buff[MAXLINELENGTH];
+    uint32_t parsed = 0;
+    for (uint32_t n = 0; n < SENTENCES; n++) {
+        sentence(n, buff, sizeof(buff));
+        parsed += gps.parse(buff);
+    }
+    writing = false;
+    for (uint8_t i = 0; i < READERS; i++)
+        readers[i].join();
+
+    char msg[80];
+    snprintf(msg, sizeof(msg), "%u sentences, %u snapshots", (unsigned)parsed,
+             (unsigned)snaps);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL_UINT32(SENTENCES, parsed);
+    TEST_ASSERT_GREATER_THAN(0, snaps.load());
+    TEST_ASSERT_EQUAL_UINT32(0, torn.load());
+
+    nmea_fix_t f;
+    TEST_ASSERT_EQUAL_UINT32(SENTENCES, gps.snapshot(f));
+    TEST_ASSERT_EQUAL_UINT32((SENTENCES - 1) % 86400, sentenceOf(f));
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_snapshots_never_mix_sentences);
+    return UNITY_END();
+}
@@ -0,0 +1,171 @@
+/*!
+ * @file test_main.cpp
+ * @brief Host test that the streaming decoder and parse() agree: the same
+ * text goes to one receiver that parses every line with parse(lastNMEA())
+ * and to one with setStreamDecode(true), and after every line both must
+ * hold the same values, have taken or refused it alike, and published the
+ * same epochs.
+ * @n Run with: pio test -e native -f test_stream
+ * @copyright   MIT License
+ */
+#include <INA.h>
+#include <unity.h>
+
+/// Lines the receivers are given one at a time, good and bad
+static const char *const corpus[] = {
+    "$GPGGA,123519.00,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*69\r\n",
+    "$GNRMC,083559.00,A,4717.11437,N,00833.91522,E,0.004,77.52,091202,,,A*49"
+    "\r\n",
+    "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39\r\n",
+    "$GPGLL,4916.45,N,12311.12,W,225444,A*31\r\n",
+    "$PGTOP,11,3*6F\r\n",
+    "$IIDBT,12.3,f,3.7,M,2.0,F*27\r\n",
+    "$IIMWV,045.0,R,12.5,N,A*0A\r\n",
+    "$IIHDM,123.4,M*26\r\n",
+    "$IIMTW,18.5,C*1F\r\n",
+    "$IIVHW,100.0,T,95.0,M,6.5,N,12.0,K*58\r\n",
+    "$GPHDT,274.07,T*03\r\n",
+    "$GPRMC,235959.999,A,3351.5678,S,15112.3456,E,12.34,359.99,311299,,*26\r\n",
+    "$GPGGA,000001.5,0000.0001,S,00000.0001,W,2,12,99.9,-12.3,M,,M,,*6D\r\n",
+    "$GPTXT,01,01,02,ANTSTATUS=OK*3B\r\n",
+    "$GPZDA,201530.00,04,07,2002,00,00*60\r\n",
+    "$GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00*74\r\n",
+    "$GPRMB,A,0.66,L,003,004,4917.24,N,12309.57,W,001.3,052.5,000.5,V*20\r\n",
+    "$GPXXX,1,2,3*53\r\n",  // not a sentence either knows
+    "garbage\r\n",
+    "\r\n",
+    // bad checksums
+    "$GNRMC,083559.00,A,4717.11437,N,00833.91522,E,0.004,77.52,091202,,,A*FF"
+    "\r\n",
+    "$GPGGA,123519.00,4807.038,N,01131.000,E,1,08,0.9,545.5,M,46.9,M,,*69\r\n",
+    "$GPGLL,4916.45,N,12311.12,W,225444,A*3\r\n",
+    "$GPGLL,4916.45,N,12311.12,W,225444,A*G1\r\n",
+    "$GPGLL,4916.45,N,12311.12,W,225444,A\r\n",
+    // truncated, ended by the line end or run into the next sentence
+    "$GPGGA,123520.00,4807.038,N,011\r\n",
+    "$GPRMC,123520.00,A,48",
+    "$GPGGA,123521.00,4807.040,N,01131.002,E,1,09,0.8,545.6,M,46.9,M,,*6D\r\n",
+    // too long for a line
+    "$GPTXT,01,01,02,AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA"
+    "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA*3B\r\n",
+    "$GPGGA,123521.00,4807.040,N,01131.002,E,1,09,0.8,545.6,M,46.9,M,,*6D\r\n",
+    "$GPRMC,123521.00,A,4807.040,N,01131.002,E,0.12,54.90,170926,,,A*67\r\n",
+};
+static const uint8_t LINES = sizeof(corpus) / sizeof(corpus[0]);
+
+/// What both receivers replay. Each line is added to the end as it is
+/// needed, so a poll() only ever finds the one line.
+static char text[LINES * (MAXLINELENGTH + 50)];
+
+static INA_Receiver<ReplayTransport> parsed(text), streamed(text);
+
+/// The same value, where a NaN is the same as a NaN
+template <class T>
+static bool same(T a, T b) {
+    return a == b || (a != a && b != b);
+}
+
+/// Fail with the member and the line if the receivers differ
+static void expectSame(bool ok, const char *member, const char *line) {
+    char msg[MAXLINELENGTH + 80];
+    snprintf(msg, sizeof(msg), "%s differs %s", member, line);
+    TEST_ASSERT_TRUE_MESSAGE(ok, msg);
+}
+
+/// Check that both receivers have the same value of a member
+#define SAME(member) \
+    expectSame(same(parsed.member, streamed.member), #member, msg)
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_stream_decode_matches_parse(void) {
+    text[0] = 0;
+    parsed.begin();
+    streamed.begin();
+    TEST_ASSERT_TRUE(streamed.setStreamDecode(true));
+
+    uint8_t taken = 0;
+    for (uint8_t i = 0; i < LINES; i++) {
+        strcat(text, corpus[i]);
+        bool byParse = false;
+        parsed.poll();
+        while (parsed.newNMEAreceived())
+            byParse = parsed.parse(parsed.lastNMEA());
+        uint32_t before = streamed.streamParsed;
+        streamed.poll();
+        while (streamed.newNMEAreceived())
+            streamed.lastNMEA();  // decoded as it arrived
+        bool byStream = streamed.streamParsed != before;
+
+        char msg[MAXLINELENGTH + 40];
+        snprintf(msg, sizeof(msg), "after line %u: %.*s", i,
+                 (int)strcspn(corpus[i], "\r\n"), corpus[i]);
+        TEST_ASSERT_EQUAL_MESSAGE(byParse, byStream, msg);
+        taken += byParse;
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(parsed.lastSource,
+                                         streamed.lastSource, msg);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(parsed.lastSentence,
+                                         streamed.lastSentence, msg);
+        SAME(hour);
+        SAME(minute);
+        SAME(seconds);
+        SAME(milliseconds);
+        SAME(year);
+        SAME(month);
+        SAME(day);
+        SAME(latitude_fixed);
+        SAME(longitude_fixed);
+        SAME(latitude);
+        SAME(longitude);
+        SAME(latitudeDegrees);
+        SAME(longitudeDegrees);
+        SAME(lat);
+        SAME(lon);
+        SAME(altitude_fixed);
+        SAME(geoidheight_fixed);
+        SAME(speed_fixed);
+        SAME(angle_fixed);
+        SAME(magvariation);
+        SAME(mag);
+        SAME(HDOP);
+        SAME(VDOP);
+        SAME(PDOP);
+        SAME(fix);
+        SAME(fixquality);
+        SAME(fixquality_3d);
+        SAME(satellites);
+        SAME(satellitesInView);
+        SAME(antenna);
+        SAME(fixCount);
+
+        nmea_fix_t a, b;
+        parsed.snapshot(a);
+        streamed.snapshot(b);
+        TEST_ASSERT_EQUAL_UINT16_MESSAGE(a.have, b.have, msg);
+        TEST_ASSERT_EQUAL_MESSAGE(nmea::epochMillis(a), nmea::epochMillis(b),
+                                  msg);
+        TEST_ASSERT_EQUAL_INT32_MESSAGE(a.latitude_fixed, b.latitude_fixed,
+                                        msg);
+#ifdef NMEA_EXTENSIONS
+        nmea_float_t la[NMEA_MAX_INDEX], lb[NMEA_MAX_INDEX];
+        parsed.copyLatest(la);
+        streamed.copyLatest(lb);
+        for (int k = 0; k < (int)NMEA_MAX_INDEX; k++)
+            TEST_ASSERT_TRUE_MESSAGE(same(la[k], lb[k]), msg);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(parsed.txtTXT, streamed.txtTXT, msg);
+#endif
+    }
+    // the good ones were taken, and the corpus reached a complete epoch
+    TEST_ASSERT_GREATER_OR_EQUAL(LINES / 2, taken);
+    TEST_ASSERT_GREATER_THAN(0, streamed.fixCount);
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_stream_decode_matches_parse);
+    return UNITY_END();
+}